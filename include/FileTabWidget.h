@@ -16,9 +16,21 @@
 #ifndef FILETABWIDGET_H
 #define FILETABWIDGET_H
 
+#include <QDragEnterEvent>
+#include <QDropEvent>
+#include <QLabel>
 #include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
 #include <QWidget>
 #include <Stirlitz.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
 
 class FileTabWidget : public QWidget
 {
@@ -28,11 +40,39 @@ public:
                 const std::shared_ptr<gcry_sexp> &key_pair,
                 const std::shared_ptr<gcry_sexp> &other_key);
 
+  ~FileTabWidget();
+
   void
   resetKeys(const std::shared_ptr<gcry_sexp> &key_pair,
             const std::shared_ptr<gcry_sexp> &other_key);
 
+protected:
+  void
+  dragEnterEvent(QDragEnterEvent *event) override;
+
+  void
+  dropEvent(QDropEvent *event) override;
+
 private:
+  enum EntryState
+  {
+    Pending,
+    Running,
+    Done,
+    Failed,
+    Cancelled
+  };
+
+  struct QueueEntry
+  {
+    std::filesystem::path source;
+    std::filesystem::path result;
+    uint64_t size = 0;
+    uint64_t processed = 0;
+    EntryState state = EntryState::Pending;
+    std::shared_ptr<StirlitzJob> job;
+  };
+
   void
   createWidget();
 
@@ -40,19 +80,40 @@ private:
   openFileDialog();
 
   void
-  openFileFunction(const QString &filename);
+  addFile(const QString &filename);
+
+  std::filesystem::path
+  resultPath(const std::filesystem::path &source);
+
+  void
+  updateResultPaths();
+
+  void
+  outputDirDialog();
+
+  void
+  startBatch(const bool &encrypt);
+
+  void
+  schedule();
 
   void
-  saveFileDialog();
+  cancelBatch();
 
   void
-  saveFileFunction(const QString &filename);
+  clearQueue();
 
   void
-  encryptFile();
+  jobFinished(const int &index, const int &state);
 
   void
-  decryptFile();
+  batchCommitted(const bool &success);
+
+  void
+  setEntryState(const size_t &index, const EntryState &state);
+
+  void
+  updateStats();
 
   enum MessageType
   {
@@ -62,18 +123,39 @@ private:
   };
 
   void
-  infoMessage(QWidget *progr_dialog, const MessageType &type);
+  infoMessage(const MessageType &type);
 
   Stirlitz *spy;
   std::shared_ptr<gcry_sexp> key_pair;
   std::shared_ptr<gcry_sexp> other_key;
 
-  QLineEdit *source_file;
-  QLineEdit *result_file;
+  QTableWidget *queue_view;
+  QLineEdit *output_dir;
+  QSpinBox *max_jobs;
+  QPushButton *encrypt;
+  QPushButton *decrypt;
+  QPushButton *cancel;
+  QPushButton *clear;
+  QLabel *stats;
+  QTimer *stats_timer;
+
+  std::vector<QueueEntry> queue;
+  size_t running = 0;
+  bool batch = false;
+  bool batch_encrypt = true;
+  std::string batch_username;
+  std::string batch_password;
+  uint64_t batch_base = 0;
+  std::chrono::time_point<std::chrono::steady_clock> batch_start;
+  std::thread *commit_thread = nullptr;
+  uint64_t commit_batch = 0;
 
 signals:
   void
-  signalMessage(QWidget *progr_dialog, const MessageType &type);
+  signalJobFinished(const int &index, const int &state);
+
+  void
+  signalBatchCommitted(const bool &success);
 };
 
 #endif // FILETABWIDGET_H
@@ -67,10 +67,8 @@ private:
   std::shared_ptr<gcry_sexp> key_pair;
   std::shared_ptr<gcry_sexp> other_key;
 
-  char *u_name = nullptr;
-  size_t u_name_sz = 0;
-  char *passwd = nullptr;
-  size_t passwd_sz = 0;
+  // Key of profile files, derived once from user name and password.
+  StirlitzSessionKey session_key;
 
   TextTabWidget *text_tab;
   FileTabWidget *file_tab;
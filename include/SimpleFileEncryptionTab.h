@@ -16,9 +16,14 @@
 #ifndef SIMPLEFILEENCRYPTIONTAB_H
 #define SIMPLEFILEENCRYPTIONTAB_H
 
+#include <QLabel>
 #include <QLineEdit>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QWidget>
 #include <Stirlitz.h>
+#include <chrono>
+#include <memory>
 
 class SimpleFileEncryptionTab : public QWidget
 {
@@ -27,6 +32,8 @@ public:
   SimpleFileEncryptionTab(QWidget *parent, Stirlitz *spy,
                           const bool &show_as_window);
 
+  ~SimpleFileEncryptionTab();
+
   void
   creatWidget();
 
@@ -40,6 +47,15 @@ private:
   void
   resultFunc(const bool &encrypt);
 
+  void
+  setBusy(const bool &busy);
+
+  void
+  jobProgress(const int &percent);
+
+  void
+  jobFinished(const int &state);
+
   enum ErrorType
   {
     SourceNotExists,
@@ -62,6 +78,22 @@ private:
 
   QLineEdit *username;
   QLineEdit *password;
+
+  QPushButton *encrypt;
+  QPushButton *decrypt;
+  QPushButton *cancel;
+  QProgressBar *progress;
+  QLabel *speed;
+
+  std::shared_ptr<StirlitzJob> job;
+  std::chrono::time_point<std::chrono::steady_clock> start;
+
+signals:
+  void
+  signalProgress(const int &percent);
+
+  void
+  signalFinished(const int &state);
 };
 
 #endif // SIMPLEFILEENCRYPTIONTAB_H
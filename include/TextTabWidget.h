@@ -16,10 +16,15 @@
 #ifndef TEXTTABWIDGET_H
 #define TEXTTABWIDGET_H
 
+#include <QLabel>
 #include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QWidget>
 #include <Stirlitz.h>
 #include <memory>
+#include <mutex>
+#include <string>
 
 class TextTabWidget : public QWidget
 {
@@ -29,6 +34,8 @@ public:
                 const std::shared_ptr<gcry_sexp> &key_pair,
                 const std::shared_ptr<gcry_sexp> &other_key);
 
+  ~TextTabWidget();
+
   void
   resetKeys(const std::shared_ptr<gcry_sexp> &key_pair,
             const std::shared_ptr<gcry_sexp> &other_key);
@@ -43,6 +50,34 @@ private:
   void
   decryptText();
 
+  StirlitzJob::Callbacks
+  jobCallbacks(const bool &encrypt);
+
+  void
+  setBusy(const bool &busy);
+
+  void
+  jobProgress(const int &percent);
+
+  void
+  jobFinished(const bool &success);
+
+  void
+  showResult();
+
+  void
+  textFileDialog(const bool &encrypt);
+
+  void
+  textFileResultDialog(const bool &encrypt, const QString &source);
+
+  void
+  textFileJob(const bool &encrypt, const QString &source,
+              const QString &result);
+
+  void
+  textFileFinished(const int &state);
+
   void
   saveFileDialog();
 
@@ -61,6 +96,31 @@ private:
 
   QPlainTextEdit *source_text;
   QPlainTextEdit *encrypted_text;
+  QLabel *result_info;
+  QPushButton *encrypt;
+  QPushButton *decrypt;
+  QPushButton *cancel;
+  QPushButton *file_encrypt;
+  QPushButton *file_decrypt;
+  QProgressBar *progress;
+
+  std::shared_ptr<StirlitzJob> job;
+
+  // Whole result is kept here, encrypted_text shows only its beginning.
+  // Copy and save take data from this buffer.
+  std::string result;
+  std::string job_result;
+  std::mutex job_result_mtx;
+
+signals:
+  void
+  signalProgress(const int &percent);
+
+  void
+  signalFinished(const bool &success);
+
+  void
+  signalTextFileFinished(const int &state);
 };
 
 #endif // TEXTTABWIDGET_H
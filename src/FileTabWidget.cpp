@@ -15,14 +15,15 @@
  */
 
 #include <FileTabWidget.h>
-#include <NonCloseMsg.h>
 #include <QDir>
 #include <QFileDialog>
 #include <QHBoxLayout>
+#include <QHeaderView>
 #include <QMessageBox>
-#include <QPushButton>
+#include <QMimeData>
+#include <QUrl>
 #include <QVBoxLayout>
-#include <filesystem>
+#include <algorithm>
 #include <thread>
 
 #ifndef __ANDROID__
@@ -40,11 +41,39 @@ FileTabWidget::FileTabWidget(QWidget *parent, Stirlitz *spy,
   this->spy = spy;
   this->key_pair = key_pair;
   this->other_key = other_key;
-  connect(this, &FileTabWidget::signalMessage, this,
-          &FileTabWidget::infoMessage);
+  connect(this, &FileTabWidget::signalJobFinished, this,
+          &FileTabWidget::jobFinished);
+  connect(this, &FileTabWidget::signalBatchCommitted, this,
+          &FileTabWidget::batchCommitted);
+  this->setAcceptDrops(true);
   createWidget();
 }
 
+FileTabWidget::~FileTabWidget()
+{
+  // Job callbacks use this object, so all jobs must be stopped before
+  // destruction.
+  for(auto it = queue.begin(); it != queue.end(); it++)
+    {
+      if(it->job)
+        {
+          it->job->cancel();
+        }
+    }
+  for(auto it = queue.begin(); it != queue.end(); it++)
+    {
+      if(it->job)
+        {
+          it->job->wait();
+        }
+    }
+  if(commit_thread)
+    {
+      commit_thread->join();
+      delete commit_thread;
+    }
+}
+
 void
 FileTabWidget::resetKeys(const std::shared_ptr<gcry_sexp> &key_pair,
                          const std::shared_ptr<gcry_sexp> &other_key)
@@ -59,41 +88,125 @@ FileTabWidget::createWidget()
   QVBoxLayout *v_box = new QVBoxLayout;
   this->setLayout(v_box);
 
-  source_file = new QLineEdit;
-  source_file->setPlaceholderText(tr("File to be encrypted or decrypted"));
-  v_box->addWidget(source_file);
+  queue_view = new QTableWidget;
+  queue_view->setColumnCount(3);
+  queue_view->setHorizontalHeaderLabels(QStringList()
+                                        << tr("File") << tr("Result")
+                                        << tr("State"));
+  queue_view->horizontalHeader()->setSectionResizeMode(0,
+                                                       QHeaderView::Stretch);
+  queue_view->horizontalHeader()->setSectionResizeMode(1,
+                                                       QHeaderView::Stretch);
+  queue_view->horizontalHeader()->setSectionResizeMode(
+      2, QHeaderView::ResizeToContents);
+  queue_view->verticalHeader()->setVisible(false);
+  queue_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  queue_view->setSelectionMode(QAbstractItemView::NoSelection);
+  queue_view->setToolTip(tr("Drop files here or press \"Add files\""));
+  v_box->addWidget(queue_view);
+
+  QHBoxLayout *h_box = new QHBoxLayout;
+  v_box->addLayout(h_box);
 
   QPushButton *open = new QPushButton;
-  open->setText(tr("Open"));
+  open->setText(tr("Add files"));
   connect(open, &QPushButton::clicked, this, &FileTabWidget::openFileDialog);
-  v_box->addWidget(open, 0, Qt::AlignVCenter | Qt::AlignRight);
+  h_box->addWidget(open, 0, Qt::AlignCenter);
+
+  clear = new QPushButton;
+  clear->setText(tr("Clear list"));
+  connect(clear, &QPushButton::clicked, this, &FileTabWidget::clearQueue);
+  h_box->addWidget(clear, 0, Qt::AlignCenter);
+
+  h_box->addStretch();
+
+  output_dir = new QLineEdit;
+  output_dir->setPlaceholderText(
+      tr("Folder for resulting files (next to source files if empty)"));
+  connect(output_dir, &QLineEdit::textChanged, this,
+          &FileTabWidget::updateResultPaths);
+  v_box->addWidget(output_dir);
+
+  QPushButton *choose_dir = new QPushButton;
+  choose_dir->setText(tr("Choose..."));
+  connect(choose_dir, &QPushButton::clicked, this,
+          &FileTabWidget::outputDirDialog);
+  v_box->addWidget(choose_dir, 0, Qt::AlignVCenter | Qt::AlignRight);
+
+  h_box = new QHBoxLayout;
+  v_box->addLayout(h_box);
 
-  result_file = new QLineEdit;
-  result_file->setPlaceholderText(tr("Resulting file path"));
-  v_box->addWidget(result_file);
+  QLabel *max_jobs_lab = new QLabel;
+  max_jobs_lab->setText(tr("Simultaneous jobs:"));
+  h_box->addWidget(max_jobs_lab);
 
-  QPushButton *save_as = new QPushButton;
-  save_as->setText(tr("Save as..."));
-  connect(save_as, &QPushButton::clicked, this,
-          &FileTabWidget::saveFileDialog);
-  v_box->addWidget(save_as, 0, Qt::AlignVCenter | Qt::AlignRight);
+  max_jobs = new QSpinBox;
+  max_jobs->setRange(1, 64);
+  max_jobs->setValue(
+      static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)));
+  connect(max_jobs, &QSpinBox::valueChanged, this, &FileTabWidget::schedule);
+  h_box->addWidget(max_jobs);
+
+  h_box->addStretch();
 
   v_box->addSpacing(20);
 
-  QHBoxLayout *h_box = new QHBoxLayout;
+  h_box = new QHBoxLayout;
   v_box->addLayout(h_box);
 
-  QPushButton *encrypt = new QPushButton;
+  encrypt = new QPushButton;
   encrypt->setText(tr("Encrypt"));
-  connect(encrypt, &QPushButton::clicked, this, &FileTabWidget::encryptFile);
+  connect(encrypt, &QPushButton::clicked, this,
+          [this]
+            {
+              startBatch(true);
+            });
   h_box->addWidget(encrypt, 0, Qt::AlignCenter);
 
-  QPushButton *decrypt = new QPushButton;
+  decrypt = new QPushButton;
   decrypt->setText(tr("Decrypt"));
-  connect(decrypt, &QPushButton::clicked, this, &FileTabWidget::decryptFile);
+  connect(decrypt, &QPushButton::clicked, this,
+          [this]
+            {
+              startBatch(false);
+            });
   h_box->addWidget(decrypt, 0, Qt::AlignCenter);
 
-  v_box->addStretch();
+  cancel = new QPushButton;
+  cancel->setText(tr("Cancel"));
+  cancel->setEnabled(false);
+  connect(cancel, &QPushButton::clicked, this, &FileTabWidget::cancelBatch);
+  h_box->addWidget(cancel, 0, Qt::AlignCenter);
+
+  stats = new QLabel;
+  v_box->addWidget(stats, 0, Qt::AlignCenter);
+
+  stats_timer = new QTimer(this);
+  stats_timer->setInterval(1000);
+  connect(stats_timer, &QTimer::timeout, this, &FileTabWidget::updateStats);
+}
+
+void
+FileTabWidget::dragEnterEvent(QDragEnterEvent *event)
+{
+  if(event->mimeData()->hasUrls())
+    {
+      event->acceptProposedAction();
+    }
+}
+
+void
+FileTabWidget::dropEvent(QDropEvent *event)
+{
+  QList<QUrl> urls = event->mimeData()->urls();
+  for(auto it = urls.begin(); it != urls.end(); it++)
+    {
+      if(it->isLocalFile())
+        {
+          addFile(it->toLocalFile());
+        }
+    }
+  event->acceptProposedAction();
 }
 
 void
@@ -105,163 +218,493 @@ FileTabWidget::openFileDialog()
 
   fd->setAcceptMode(QFileDialog::AcceptOpen);
   fd->setDirectory(QDir::homePath());
-  fd->setFileMode(QFileDialog::ExistingFile);
+  fd->setFileMode(QFileDialog::ExistingFiles);
   fd->setOption(QFileDialog::ReadOnly);
 
-  connect(fd, &QFileDialog::fileSelected, this,
-          &FileTabWidget::openFileFunction);
+  connect(fd, &QFileDialog::filesSelected, this,
+          [this](const QStringList &files)
+            {
+              for(auto it = files.begin(); it != files.end(); it++)
+                {
+                  addFile(*it);
+                }
+            });
 
   fd->show();
 }
 
 void
-FileTabWidget::openFileFunction(const QString &filename)
+FileTabWidget::addFile(const QString &filename)
 {
-  source_file->setText(filename);
+  std::filesystem::path source
+      = std::filesystem::u8path(filename.toStdString());
+  if(!std::filesystem::is_regular_file(source))
+    {
+      return void();
+    }
+  auto it = std::find_if(queue.begin(), queue.end(),
+                         [source](const QueueEntry &el)
+                           {
+                             return el.source == source
+                                    && el.state == EntryState::Pending;
+                           });
+  if(it != queue.end())
+    {
+      return void();
+    }
+
+  QueueEntry entry;
+  entry.source = source;
+  entry.result = resultPath(source);
+  entry.size = std::filesystem::file_size(source);
+  queue.push_back(entry);
+
+  int row = queue_view->rowCount();
+  queue_view->insertRow(row);
+  queue_view->setItem(row, 0,
+                      new QTableWidgetItem(source.u8string().c_str()));
+  queue_view->setItem(row, 1,
+                      new QTableWidgetItem(entry.result.u8string().c_str()));
+  queue_view->setItem(row, 2, new QTableWidgetItem);
+  setEntryState(queue.size() - 1, EntryState::Pending);
+
+  // Files added during batch are processed by the same operation.
+  schedule();
+  updateStats();
+}
 
-  if(result_file->text().isEmpty())
+std::filesystem::path
+FileTabWidget::resultPath(const std::filesystem::path &source)
+{
+  std::filesystem::path dir = source.parent_path();
+  std::string out = output_dir->text().toStdString();
+  if(!out.empty())
     {
-      std::filesystem::path p
-          = std::filesystem::u8path(filename.toStdString());
-      std::string str = p.stem().u8string();
-      str += "_new" + p.extension().u8string();
-      p = p.parent_path() / std::filesystem::u8path(str);
-      result_file->setText(p.u8string().c_str());
+      dir = std::filesystem::u8path(out);
     }
+  std::string stem = source.stem().u8string();
+  std::string ext = source.extension().u8string();
+
+  std::filesystem::path result
+      = dir / std::filesystem::u8path(stem + "_new" + ext);
+  for(int i = 1;; i++)
+    {
+      auto it = std::find_if(queue.begin(), queue.end(),
+                             [result](const QueueEntry &el)
+                               {
+                                 return el.result == result
+                                        || el.source == result;
+                               });
+      if(it == queue.end() && !std::filesystem::exists(result))
+        {
+          break;
+        }
+      result = dir
+               / std::filesystem::u8path(stem + "_new" + std::to_string(i)
+                                         + ext);
+    }
+
+  return result;
 }
 
 void
-FileTabWidget::saveFileDialog()
+FileTabWidget::updateResultPaths()
+{
+  for(size_t i = 0; i < queue.size(); i++)
+    {
+      if(queue[i].state == EntryState::Pending)
+        {
+          queue[i].result.clear();
+        }
+    }
+  for(size_t i = 0; i < queue.size(); i++)
+    {
+      if(queue[i].state == EntryState::Pending)
+        {
+          queue[i].result = resultPath(queue[i].source);
+          queue_view->item(static_cast<int>(i), 1)
+              ->setText(queue[i].result.u8string().c_str());
+        }
+    }
+}
+
+void
+FileTabWidget::outputDirDialog()
 {
   QFileDialog *fd = new QFileDialog(this->window());
   fd->setAttribute(Qt::WA_DeleteOnClose);
   fd->setWindowModality(Qt::WindowModal);
 
-  fd->setAcceptMode(QFileDialog::AcceptSave);
+  fd->setAcceptMode(QFileDialog::AcceptOpen);
   fd->setDirectory(QDir::homePath());
+  fd->setFileMode(QFileDialog::Directory);
 
-  connect(fd, &QFileDialog::fileSelected, this,
-          &FileTabWidget::saveFileFunction);
+  connect(fd, &QFileDialog::fileSelected, output_dir, &QLineEdit::setText);
 
   fd->show();
 }
 
 void
-FileTabWidget::saveFileFunction(const QString &filename)
+FileTabWidget::startBatch(const bool &encrypt)
 {
-  result_file->setText(filename);
+  if(batch)
+    {
+      return void();
+    }
+  auto it = std::find_if(queue.begin(), queue.end(),
+                         [](const QueueEntry &el)
+                           {
+                             return el.state == EntryState::Pending;
+                           });
+  if(it == queue.end())
+    {
+      return void();
+    }
+
+  try
+    {
+      std::tuple<std::string, std::string> pass_tup;
+      if(encrypt)
+        {
+          pass_tup = spy->genUsernamePasswordEncryption(key_pair, other_key);
+        }
+      else
+        {
+          pass_tup = spy->genUsernamePasswordDecryption(key_pair, other_key);
+        }
+      batch_username = std::get<0>(pass_tup);
+      batch_password = std::get<1>(pass_tup);
+    }
+  catch(std::exception &er)
+    {
+#ifndef __ANDROID__
+      std::cout << "FileTabWidget::startBatch: \"" << er.what() << "\""
+                << std::endl;
+#else
+      __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                          "FileTabWidget::startBatch: \"%s\"", er.what());
+#endif
+      infoMessage(MessageType::Error);
+      return void();
+    }
+
+  batch = true;
+  batch_encrypt = encrypt;
+  commit_batch = spy->newBatch();
+  batch_base = 0;
+  for(auto it = queue.begin(); it != queue.end(); it++)
+    {
+      batch_base += it->processed;
+    }
+  batch_start = std::chrono::steady_clock::now();
+  this->encrypt->setEnabled(false);
+  decrypt->setEnabled(false);
+  clear->setEnabled(false);
+  output_dir->setEnabled(false);
+  cancel->setEnabled(true);
+  stats_timer->start();
+
+  schedule();
 }
 
 void
-FileTabWidget::encryptFile()
+FileTabWidget::schedule()
 {
-  std::filesystem::path source
-      = std::filesystem::u8path(source_file->text().toStdString());
-  if(!std::filesystem::exists(source))
+  if(!batch || commit_thread)
     {
       return void();
     }
 
-  std::filesystem::path result
-      = std::filesystem::u8path(result_file->text().toStdString());
-  if(result.empty())
+  for(size_t i = 0; i < queue.size(); i++)
     {
-      return void();
-    }
+      if(running >= static_cast<size_t>(max_jobs->value()))
+        {
+          break;
+        }
+      QueueEntry &entry = queue[i];
+      if(entry.state != EntryState::Pending)
+        {
+          continue;
+        }
 
-  NonCloseMsg *msg
-      = new NonCloseMsg(this->window(), tr("Operation in progress..."));
-  msg->show();
+      // Resulting files of batch are flushed together by commitFiles().
+      Stirlitz::FileOptions options;
+      options.durability = Stirlitz::FileOptions::SyncBatch;
+      options.batch = commit_batch;
 
-  std::thread thr(
-      [this, msg, source, result]
+      StirlitzJob::Callbacks callbacks;
+      callbacks.finished = [this, i](StirlitzJob &job)
         {
-          try
-            {
-              std::tuple<std::string, std::string> pass_tup
-                  = spy->genUsernamePasswordEncryption(key_pair, other_key);
-
-              spy->encryptFile(source, result, std::get<0>(pass_tup),
-                               std::get<1>(pass_tup));
-            }
-          catch(std::exception &er)
+          if(job.state() == StirlitzJob::Failed)
             {
 #ifndef __ANDROID__
-              std::cout << "FileTabWidget::encryptFile: \"" << er.what()
+              std::cout << "FileTabWidget::schedule: \"" << job.error()
                         << "\"" << std::endl;
 #else
               __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
-                                  "FileTabWidget::encryptFile: \"%s\"",
-                                  er.what());
+                                  "FileTabWidget::schedule: \"%s\"",
+                                  job.error().c_str());
 #endif
-              emit signalMessage(msg, MessageType::Error);
-              return void();
             }
-          emit signalMessage(msg, MessageType::Encrypted);
-        });
-  thr.detach();
-}
+          emit signalJobFinished(static_cast<int>(i),
+                                 static_cast<int>(job.state()));
+        };
 
-void
-FileTabWidget::decryptFile()
-{
-  std::filesystem::path source
-      = std::filesystem::u8path(source_file->text().toStdString());
-  if(!std::filesystem::exists(source))
-    {
-      return void();
+      try
+        {
+          if(batch_encrypt)
+            {
+              entry.job = spy->encryptFileAsync(
+                  entry.source, entry.result, batch_username, batch_password,
+                  options, callbacks);
+            }
+          else
+            {
+              entry.job = spy->decryptFileAsync(
+                  entry.source, entry.result, batch_username, batch_password,
+                  options, callbacks);
+            }
+          running++;
+          setEntryState(i, EntryState::Running);
+        }
+      catch(std::exception &er)
+        {
+#ifndef __ANDROID__
+          std::cout << "FileTabWidget::schedule: \"" << er.what() << "\""
+                    << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                              "FileTabWidget::schedule: \"%s\"", er.what());
+#endif
+          setEntryState(i, EntryState::Failed);
+        }
     }
 
-  std::filesystem::path result
-      = std::filesystem::u8path(result_file->text().toStdString());
-  if(result.empty())
+  if(running > 0)
     {
       return void();
     }
 
-  NonCloseMsg *msg
-      = new NonCloseMsg(this->window(), tr("Operation in progress..."));
-  msg->show();
-
-  std::thread thr(
-      [this, msg, source, result]
+  // Batch is finished. Flushing of resulting files can take long time, so
+  // they are committed out of event loop.
+  updateStats();
+  stats_timer->stop();
+  cancel->setEnabled(false);
+  commit_thread = new std::thread(
+      [this]
         {
+          bool success = true;
           try
             {
-              std::tuple<std::string, std::string> pass_tup
-                  = spy->genUsernamePasswordDecryption(key_pair, other_key);
-
-              spy->decryptFile(source, result, std::get<0>(pass_tup),
-                               std::get<1>(pass_tup));
+              spy->commitFiles(commit_batch);
             }
           catch(std::exception &er)
             {
 #ifndef __ANDROID__
-              std::cout << "FileTabWidget::decryptFile: \"" << er.what()
+              std::cout << "FileTabWidget::schedule: \"" << er.what()
                         << "\"" << std::endl;
 #else
               __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
-                                  "FileTabWidget::decryptFile: \"%s\"",
+                                  "FileTabWidget::schedule: \"%s\"",
                                   er.what());
 #endif
-              emit signalMessage(msg, MessageType::Error);
-              return void();
+              success = false;
             }
-          emit signalMessage(msg, MessageType::Decrypted);
+          emit signalBatchCommitted(success);
         });
-  thr.detach();
 }
 
 void
-FileTabWidget::infoMessage(QWidget *progr_dialog, const MessageType &type)
+FileTabWidget::batchCommitted(const bool &success)
+{
+  if(commit_thread)
+    {
+      commit_thread->join();
+      delete commit_thread;
+      commit_thread = nullptr;
+    }
+  batch = false;
+  batch_username.clear();
+  batch_password.clear();
+  encrypt->setEnabled(true);
+  decrypt->setEnabled(true);
+  clear->setEnabled(true);
+  output_dir->setEnabled(true);
+
+  bool failed = !success;
+  bool cancelled = false;
+  for(auto it = queue.begin(); it != queue.end(); it++)
+    {
+      failed = failed || it->state == EntryState::Failed;
+      cancelled = cancelled || it->state == EntryState::Cancelled;
+    }
+  if(failed)
+    {
+      infoMessage(MessageType::Error);
+    }
+  else if(!cancelled)
+    {
+      if(batch_encrypt)
+        {
+          infoMessage(MessageType::Encrypted);
+        }
+      else
+        {
+          infoMessage(MessageType::Decrypted);
+        }
+    }
+}
+
+void
+FileTabWidget::cancelBatch()
+{
+  for(size_t i = 0; i < queue.size(); i++)
+    {
+      if(queue[i].state == EntryState::Pending)
+        {
+          setEntryState(i, EntryState::Cancelled);
+        }
+      else if(queue[i].job)
+        {
+          queue[i].job->cancel();
+        }
+    }
+  schedule();
+}
+
+void
+FileTabWidget::clearQueue()
+{
+  if(batch)
+    {
+      return void();
+    }
+  queue.clear();
+  queue_view->setRowCount(0);
+  stats->setText("");
+}
+
+void
+FileTabWidget::jobFinished(const int &index, const int &state)
+{
+  size_t i = static_cast<size_t>(index);
+  if(i >= queue.size() || !queue[i].job)
+    {
+      return void();
+    }
+  QueueEntry &entry = queue[i];
+  entry.processed = entry.job->processed();
+  entry.job.reset();
+  running--;
+  switch(state)
+    {
+    case StirlitzJob::Finished:
+      {
+        setEntryState(i, EntryState::Done);
+        break;
+      }
+    case StirlitzJob::Failed:
+      {
+        setEntryState(i, EntryState::Failed);
+        break;
+      }
+    default:
+      {
+        setEntryState(i, EntryState::Cancelled);
+        break;
+      }
+    }
+  schedule();
+}
+
+void
+FileTabWidget::setEntryState(const size_t &index, const EntryState &state)
+{
+  queue[index].state = state;
+  QString text;
+  switch(state)
+    {
+    case EntryState::Pending:
+      {
+        text = tr("Waiting");
+        break;
+      }
+    case EntryState::Running:
+      {
+        text = tr("In progress");
+        break;
+      }
+    case EntryState::Done:
+      {
+        text = tr("Done");
+        break;
+      }
+    case EntryState::Failed:
+      {
+        text = tr("Error");
+        break;
+      }
+    case EntryState::Cancelled:
+      {
+        text = tr("Cancelled");
+        break;
+      }
+    default:
+      break;
+    }
+  queue_view->item(static_cast<int>(index), 2)->setText(text);
+}
+
+void
+FileTabWidget::updateStats()
 {
-  NonCloseMsg *ncm = dynamic_cast<NonCloseMsg *>(progr_dialog);
-  if(ncm)
+  uint64_t total = 0;
+  uint64_t processed = 0;
+  size_t done = 0;
+  for(auto it = queue.begin(); it != queue.end(); it++)
+    {
+      total += it->size;
+      if(it->job)
+        {
+          processed += it->job->processed();
+        }
+      else
+        {
+          processed += it->processed;
+        }
+      if(it->state == EntryState::Done)
+        {
+          done++;
+        }
+    }
+
+  QString text = tr("Files: ") + QString::number(done) + "/"
+                 + QString::number(queue.size()) + tr(", processed: ")
+                 + QString::number(static_cast<double>(processed) / 1048576.0,
+                                   'f', 1)
+                 + "/"
+                 + QString::number(static_cast<double>(total) / 1048576.0,
+                                   'f', 1)
+                 + tr(" MiB");
+  if(batch)
     {
-      ncm->allowClose(true);
-      ncm->close();
+      double sec = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - batch_start)
+                       .count();
+      if(sec > 0.0 && processed >= batch_base)
+        {
+          double speed
+              = static_cast<double>(processed - batch_base) / 1048576.0 / sec;
+          text += tr(", speed: ") + QString::number(speed, 'f', 1)
+                  + tr(" MiB/s");
+        }
     }
+  stats->setText(text);
+}
 
+void
+FileTabWidget::infoMessage(const MessageType &type)
+{
   QMessageBox *msg = new QMessageBox(this->window());
   msg->setAttribute(Qt::WA_DeleteOnClose);
   msg->setWindowModality(Qt::WindowModal);
@@ -270,13 +713,13 @@ FileTabWidget::infoMessage(QWidget *progr_dialog, const MessageType &type)
     {
     case MessageType::Decrypted:
       {
-        msg->setText(tr("File has been successfully decrypted"));
+        msg->setText(tr("Files have been successfully decrypted"));
         msg->setIcon(QMessageBox::Information);
         break;
       }
     case MessageType::Encrypted:
       {
-        msg->setText(tr("File has been successfully encrypted"));
+        msg->setText(tr("Files have been successfully encrypted"));
         msg->setIcon(QMessageBox::Information);
         break;
       }
@@ -57,14 +57,7 @@ MainWindow::~MainWindow()
       warn_thread->join();
       delete warn_thread;
     }
-  if(u_name)
-    {
-      gcry_free(u_name);
-    }
-  if(passwd)
-    {
-      gcry_free(passwd);
-    }
+  session_key.clear();
   delete spy;
 }
 
@@ -72,18 +65,7 @@ void
 MainWindow::enterWindow()
 {
   one_time_profile = false;
-  if(u_name)
-    {
-      gcry_free(u_name);
-      u_name = nullptr;
-      u_name_sz = 0;
-    }
-  if(passwd)
-    {
-      gcry_free(passwd);
-      passwd = nullptr;
-      passwd_sz = 0;
-    }
+  session_key.clear();
 
   key_pair.reset();
   other_key.reset();
@@ -261,19 +243,7 @@ MainWindow::mainWindow(const std::string &profile, const std::string &username,
   std::filesystem::path prof_p;
   if(!one_time_profile)
     {
-      u_name_sz = username.size();
-      u_name = reinterpret_cast<char *>(gcry_malloc_secure(u_name_sz));
-      for(size_t i = 0; i < u_name_sz; i++)
-        {
-          u_name[i] = username[i];
-        }
-
-      passwd_sz = password.size();
-      passwd = reinterpret_cast<char *>(gcry_malloc_secure(passwd_sz));
-      for(size_t i = 0; i < passwd_sz; i++)
-        {
-          passwd[i] = password[i];
-        }
+      session_key = StirlitzSessionKey(username, password);
 
       prof_p = home_p / std::filesystem::u8path(profile)
                / std::filesystem::u8path("owk");
@@ -296,8 +266,8 @@ MainWindow::mainWindow(const std::string &profile, const std::string &username,
 
           try
             {
-              val = spy->decryptData(username, password, val);
-              key_pair = spy->sexpFromString(val);
+              val = spy->decryptData(session_key, val);
+              key_pair = StirlitzKeyPair::deserialize(val).sexp();
             }
           catch(std::exception &er)
             {
@@ -312,8 +282,9 @@ MainWindow::mainWindow(const std::string &profile, const std::string &username,
           key_pair = spy->generateKeyPair();
           if(!one_time_profile)
             {
-              std::string val = spy->sexpToString(key_pair);
-              val = spy->encryptData(username, password, val);
+              std::string val
+                  = StirlitzKeyPair::fromSexp(key_pair).serialize();
+              val = spy->encryptData(session_key, val);
 
               std::fstream f;
               f.open(prof_p, std::ios_base::out | std::ios_base::binary);
@@ -481,20 +452,10 @@ MainWindow::resetOwnKey(const std::filesystem::path &prof_p, QScrollArea *scrl)
                       key_pair = spy->generateKeyPair();
                       if(!one_time_profile)
                         {
-                          std::string val = spy->sexpToString(key_pair);
-                          std::string username;
-                          username.resize(u_name_sz);
-                          for(size_t i = 0; i < u_name_sz; i++)
-                            {
-                              username[i] = u_name[i];
-                            }
-                          std::string password;
-                          password.resize(passwd_sz);
-                          for(size_t i = 0; i < passwd_sz; i++)
-                            {
-                              password[i] = passwd[i];
-                            }
-                          val = spy->encryptData(username, password, val);
+                          std::string val
+                              = StirlitzKeyPair::fromSexp(key_pair)
+                                    .serialize();
+                          val = spy->encryptData(session_key, val);
 
                           std::filesystem::remove_all(prof_p);
                           std::fstream f;
@@ -566,24 +527,12 @@ MainWindow::otherKeyWidget(const std::filesystem::path &prof_p)
           f.read(val.data(), val.size());
           f.close();
 
-          std::string username;
-          username.resize(u_name_sz);
-          for(size_t i = 0; i < u_name_sz; i++)
-            {
-              username[i] = u_name[i];
-            }
-
-          std::string password;
-          password.resize(passwd_sz);
-          for(size_t i = 0; i < passwd_sz; i++)
-            {
-              password[i] = passwd[i];
-            }
           try
             {
-              val = spy->decryptData(username, password, val);
-              other_key = spy->sexpFromString(val);
-              val = spy->getPublicKeyString(other_key);
+              val = spy->decryptData(session_key, val);
+              StirlitzKey key = StirlitzKey::deserialize(val);
+              other_key = key.sexp();
+              val = spy->toHex(key.raw());
             }
           catch(std::exception &er)
             {
@@ -614,9 +563,9 @@ MainWindow::otherKeyWidget(const std::filesystem::path &prof_p)
                   ksw, &KeySetWindow::signalKey, this,
                   [this, scrl, other_key_p](const std::string &key)
                     {
-                      std::string raw = spy->fromHex(key);
                       try
                         {
+                          std::string raw = spy->fromHex(key);
                           other_key = spy->generatePublicKeyExp(raw);
                         }
                       catch(std::exception &er)
@@ -635,22 +584,10 @@ MainWindow::otherKeyWidget(const std::filesystem::path &prof_p)
                         {
                           if(!one_time_profile)
                             {
-                              std::string username;
-                              username.resize(u_name_sz);
-                              for(size_t i = 0; i < u_name_sz; i++)
-                                {
-                                  username[i] = u_name[i];
-                                }
-
-                              std::string password;
-                              password.resize(passwd_sz);
-                              for(size_t i = 0; i < passwd_sz; i++)
-                                {
-                                  password[i] = passwd[i];
-                                }
-
-                              std::string val = spy->sexpToString(other_key);
-                              val = spy->encryptData(username, password, val);
+                              std::string val
+                                  = StirlitzKey::fromSexp(other_key)
+                                        .serialize();
+                              val = spy->encryptData(session_key, val);
 
                               std::filesystem::create_directories(
                                   other_key_p.parent_path());
@@ -37,6 +37,10 @@ SimpleFileEncryptionTab::SimpleFileEncryptionTab(QWidget *parent,
 {
   this->spy = spy;
   this->show_as_window = show_as_window;
+  connect(this, &SimpleFileEncryptionTab::signalProgress, this,
+          &SimpleFileEncryptionTab::jobProgress);
+  connect(this, &SimpleFileEncryptionTab::signalFinished, this,
+          &SimpleFileEncryptionTab::jobFinished);
   if(show_as_window)
     {
       this->setAttribute(Qt::WA_DeleteOnClose, true);
@@ -50,6 +54,17 @@ SimpleFileEncryptionTab::SimpleFileEncryptionTab(QWidget *parent,
     }
 }
 
+SimpleFileEncryptionTab::~SimpleFileEncryptionTab()
+{
+  // Job callbacks use this object, so job must be stopped before
+  // destruction (partially written resulting file is removed by job).
+  if(job)
+    {
+      job->cancel();
+      job->wait();
+    }
+}
+
 void
 SimpleFileEncryptionTab::creatWidget()
 {
@@ -87,7 +102,7 @@ SimpleFileEncryptionTab::creatWidget()
   QHBoxLayout *h_box = new QHBoxLayout;
   v_box->addLayout(h_box);
 
-  QPushButton *encrypt = new QPushButton;
+  encrypt = new QPushButton;
   encrypt->setText(tr("Encrypt"));
   connect(encrypt, &QPushButton::clicked, this,
           [this]
@@ -96,7 +111,7 @@ SimpleFileEncryptionTab::creatWidget()
             });
   h_box->addWidget(encrypt, 0, Qt::AlignCenter);
 
-  QPushButton *decrypt = new QPushButton;
+  decrypt = new QPushButton;
   decrypt->setText(tr("Decrypt"));
   connect(decrypt, &QPushButton::clicked, this,
           [this]
@@ -105,6 +120,28 @@ SimpleFileEncryptionTab::creatWidget()
             });
   h_box->addWidget(decrypt, 0, Qt::AlignCenter);
 
+  cancel = new QPushButton;
+  cancel->setText(tr("Cancel"));
+  cancel->setVisible(false);
+  connect(cancel, &QPushButton::clicked, this,
+          [this]
+            {
+              if(job)
+                {
+                  job->cancel();
+                }
+            });
+  h_box->addWidget(cancel, 0, Qt::AlignCenter);
+
+  progress = new QProgressBar;
+  progress->setRange(0, 100);
+  progress->setVisible(false);
+  v_box->addWidget(progress);
+
+  speed = new QLabel;
+  speed->setVisible(false);
+  v_box->addWidget(speed, 0, Qt::AlignCenter);
+
   if(show_as_window)
     {
       QPushButton *close = new QPushButton;
@@ -225,17 +262,50 @@ SimpleFileEncryptionTab::resultFunc(const bool &encrypt)
       return void();
     }
 
+  if(job)
+    {
+      return void();
+    }
+
+  StirlitzJob::Callbacks callbacks;
+  callbacks.progress
+      = [this](const uint64_t &processed, const uint64_t &total)
+    {
+      if(total > 0)
+        {
+          emit signalProgress(static_cast<int>(processed * 100 / total));
+        }
+    };
+  callbacks.finished = [this](StirlitzJob &job)
+    {
+      if(job.state() == StirlitzJob::Failed)
+        {
+#ifndef __ANDROID__
+          std::cout << "SimpleFileEncryptionTab::resultFunc: " << job.error()
+                    << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                              "SimpleFileEncryptionTab::resultFunc: %s",
+                              job.error().c_str());
+#endif
+        }
+      emit signalFinished(static_cast<int>(job.state()));
+    };
+
   try
     {
       if(encrypt)
         {
-          spy->encryptFile(s_path, r_path, unm, passwd);
+          job = spy->encryptFileAsync(s_path, r_path, unm, passwd,
+                                      Stirlitz::FileOptions(), callbacks);
         }
       else
         {
-          spy->decryptFile(s_path, r_path, unm, passwd);
+          job = spy->decryptFileAsync(s_path, r_path, unm, passwd,
+                                      Stirlitz::FileOptions(), callbacks);
         }
-      errorDialog(ErrorType::Success);
+      start = std::chrono::steady_clock::now();
+      setBusy(true);
     }
   catch(std::exception &er)
     {
@@ -251,6 +321,61 @@ SimpleFileEncryptionTab::resultFunc(const bool &encrypt)
     }
 }
 
+void
+SimpleFileEncryptionTab::setBusy(const bool &busy)
+{
+  encrypt->setEnabled(!busy);
+  decrypt->setEnabled(!busy);
+  cancel->setVisible(busy);
+  progress->setValue(0);
+  progress->setVisible(busy);
+  speed->setText("");
+  speed->setVisible(busy);
+}
+
+void
+SimpleFileEncryptionTab::jobProgress(const int &percent)
+{
+  if(!job)
+    {
+      return void();
+    }
+  progress->setValue(percent);
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                             - start)
+                   .count();
+  if(sec > 0.0)
+    {
+      double mib = static_cast<double>(job->processed()) / 1048576.0;
+      speed->setText(tr("Processed: ") + QString::number(mib, 'f', 1)
+                     + tr(" MiB, speed: ") + QString::number(mib / sec, 'f', 1)
+                     + tr(" MiB/s"));
+    }
+}
+
+void
+SimpleFileEncryptionTab::jobFinished(const int &state)
+{
+  job.reset();
+  setBusy(false);
+  switch(state)
+    {
+    case StirlitzJob::Finished:
+      {
+        errorDialog(ErrorType::Success);
+        break;
+      }
+    case StirlitzJob::Failed:
+      {
+        errorDialog(ErrorType::Error);
+        break;
+      }
+    default:
+      break;
+    }
+}
+
 void
 SimpleFileEncryptionTab::errorDialog(const ErrorType &er)
 {
@@ -19,11 +19,13 @@
 #include <QFileDialog>
 #include <QGuiApplication>
 #include <QHBoxLayout>
+#include <QMessageBox>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <TextTabWidget.h>
 #include <filesystem>
 #include <fstream>
+#include <stdexcept>
 
 #ifndef __ANDROID__
 #include <iostream>
@@ -40,9 +42,26 @@ TextTabWidget::TextTabWidget(QWidget *parent, Stirlitz *spy,
   this->spy = spy;
   this->key_pair = key_pair;
   this->other_key = other_key;
+  connect(this, &TextTabWidget::signalProgress, this,
+          &TextTabWidget::jobProgress);
+  connect(this, &TextTabWidget::signalFinished, this,
+          &TextTabWidget::jobFinished);
+  connect(this, &TextTabWidget::signalTextFileFinished, this,
+          &TextTabWidget::textFileFinished);
   createWidget();
 }
 
+TextTabWidget::~TextTabWidget()
+{
+  // Job callbacks use this object, so job must be stopped before
+  // destruction.
+  if(job)
+    {
+      job->cancel();
+      job->wait();
+    }
+}
+
 void
 TextTabWidget::resetKeys(const std::shared_ptr<gcry_sexp> &key_pair,
                          const std::shared_ptr<gcry_sexp> &other_key)
@@ -65,16 +84,29 @@ TextTabWidget::createWidget()
   QHBoxLayout *h_box = new QHBoxLayout;
   v_box->addLayout(h_box);
 
-  QPushButton *encrypt = new QPushButton;
+  encrypt = new QPushButton;
   encrypt->setText(tr("Encrypt"));
   connect(encrypt, &QPushButton::clicked, this, &TextTabWidget::encryptText);
   h_box->addWidget(encrypt, 0, Qt::AlignCenter);
 
-  QPushButton *decrypt = new QPushButton;
+  decrypt = new QPushButton;
   decrypt->setText(tr("Decrypt"));
   connect(decrypt, &QPushButton::clicked, this, &TextTabWidget::decryptText);
   h_box->addWidget(decrypt, 0, Qt::AlignCenter);
 
+  cancel = new QPushButton;
+  cancel->setText(tr("Cancel"));
+  cancel->setVisible(false);
+  connect(cancel, &QPushButton::clicked, this,
+          [this]
+            {
+              if(job)
+                {
+                  job->cancel();
+                }
+            });
+  h_box->addWidget(cancel, 0, Qt::AlignCenter);
+
 #ifdef __ANDROID__
   h_box = new QHBoxLayout;
   v_box->addLayout(h_box);
@@ -108,11 +140,21 @@ TextTabWidget::createWidget()
   h_box->addStretch();
 #endif
 
+  progress = new QProgressBar;
+  progress->setRange(0, 100);
+  progress->setVisible(false);
+  v_box->addWidget(progress);
+
   encrypted_text = new QPlainTextEdit;
   encrypted_text->setPlaceholderText(tr("Result"));
   encrypted_text->setReadOnly(true);
   v_box->addWidget(encrypted_text);
 
+  result_info = new QLabel;
+  result_info->setWordWrap(true);
+  result_info->setVisible(false);
+  v_box->addWidget(result_info);
+
   h_box = new QHBoxLayout;
   v_box->addLayout(h_box);
 
@@ -121,8 +163,11 @@ TextTabWidget::createWidget()
   connect(copy_result, &QPushButton::clicked, encrypted_text,
           [this]
             {
-              QClipboard *cpb = QGuiApplication::clipboard();
-              cpb->setText(encrypted_text->document()->toPlainText());
+              if(!result.empty())
+                {
+                  QClipboard *cpb = QGuiApplication::clipboard();
+                  cpb->setText(QString::fromStdString(result));
+                }
             });
   h_box->addWidget(copy_result, 0, Qt::AlignCenter);
 
@@ -133,11 +178,39 @@ TextTabWidget::createWidget()
   h_box->addWidget(save_result, 0, Qt::AlignCenter);
 
   h_box->addStretch();
+
+  // Files are converted directly, their content is never loaded to widgets.
+  h_box = new QHBoxLayout;
+  v_box->addLayout(h_box);
+
+  file_encrypt = new QPushButton;
+  file_encrypt->setText(tr("Encrypt file to text file"));
+  connect(file_encrypt, &QPushButton::clicked, this,
+          [this]
+            {
+              textFileDialog(true);
+            });
+  h_box->addWidget(file_encrypt, 0, Qt::AlignCenter);
+
+  file_decrypt = new QPushButton;
+  file_decrypt->setText(tr("Decrypt text file"));
+  connect(file_decrypt, &QPushButton::clicked, this,
+          [this]
+            {
+              textFileDialog(false);
+            });
+  h_box->addWidget(file_decrypt, 0, Qt::AlignCenter);
+
+  h_box->addStretch();
 }
 
 void
 TextTabWidget::encryptText()
 {
+  if(job)
+    {
+      return void();
+    }
   QString source = source_text->document()->toRawText();
   if(source.isEmpty())
     {
@@ -145,14 +218,15 @@ TextTabWidget::encryptText()
     }
   try
     {
-      std::tuple<std::string, std::string> pass_tup
-          = spy->genUsernamePasswordEncryption(key_pair, other_key);
-      std::string enc = spy->encryptData(
-          std::get<0>(pass_tup), std::get<1>(pass_tup), source.toStdString());
-
-      enc = spy->toHex(enc);
-
-      encrypted_text->setPlainText(enc.c_str());
+      // QString is shared, not copied, text is converted in thread of pool.
+      job = spy->encryptDataAsync(
+          key_pair, other_key,
+          [source]
+            {
+              return source.toStdString();
+            },
+          jobCallbacks(true));
+      setBusy(true);
     }
   catch(std::exception &er)
     {
@@ -169,21 +243,28 @@ TextTabWidget::encryptText()
 void
 TextTabWidget::decryptText()
 {
+  if(job)
+    {
+      return void();
+    }
   QString source = source_text->document()->toRawText();
   if(source.isEmpty())
     {
       return void();
     }
 
-  std::string enc = spy->fromHex(source.toStdString());
   try
     {
-      std::tuple<std::string, std::string> pass_tup
-          = spy->genUsernamePasswordDecryption(key_pair, other_key);
-      enc = spy->decryptData(std::get<0>(pass_tup), std::get<1>(pass_tup),
-                             enc);
-
-      encrypted_text->setPlainText(enc.c_str());
+      // Text is converted and decoded (bare hexadecimal text and armored
+      // text are both accepted) in thread of pool.
+      job = spy->decryptTextAsync(
+          key_pair, other_key,
+          [source]
+            {
+              return source.toStdString();
+            },
+          jobCallbacks(false));
+      setBusy(true);
     }
   catch(std::exception &er)
     {
@@ -197,10 +278,277 @@ TextTabWidget::decryptText()
     }
 }
 
+StirlitzJob::Callbacks
+TextTabWidget::jobCallbacks(const bool &encrypt)
+{
+  StirlitzJob::Callbacks callbacks;
+  callbacks.progress = [this](const uint64_t &processed, const uint64_t &total)
+    {
+      if(total > 0)
+        {
+          emit signalProgress(static_cast<int>(processed * 100 / total));
+        }
+    };
+
+  // Result is converted to text in thread of pool and moved to GUI thread
+  // through job_result, it is never copied to widgets as a whole.
+  callbacks.finished = [this, encrypt](StirlitzJob &job)
+    {
+      bool success = job.state() == StirlitzJob::Finished;
+      try
+        {
+          if(success)
+            {
+              std::string res = job.result();
+              if(encrypt)
+                {
+                  res = spy->toHex(res);
+                }
+              std::lock_guard<std::mutex> lglock(job_result_mtx);
+              job_result = std::move(res);
+            }
+          else if(job.state() == StirlitzJob::Failed)
+            {
+              throw std::runtime_error(job.error());
+            }
+        }
+      catch(std::exception &er)
+        {
+          success = false;
+#ifndef __ANDROID__
+          std::cout << "TextTabWidget::jobCallbacks: \"" << er.what() << "\""
+                    << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                              "TextTabWidget::jobCallbacks: \"%s\"",
+                              er.what());
+#endif
+        }
+      emit signalFinished(success);
+    };
+
+  return callbacks;
+}
+
+void
+TextTabWidget::setBusy(const bool &busy)
+{
+  encrypt->setEnabled(!busy);
+  decrypt->setEnabled(!busy);
+  file_encrypt->setEnabled(!busy);
+  file_decrypt->setEnabled(!busy);
+  cancel->setVisible(busy);
+  progress->setValue(0);
+  progress->setVisible(busy);
+}
+
+void
+TextTabWidget::jobProgress(const int &percent)
+{
+  progress->setValue(percent);
+}
+
+void
+TextTabWidget::jobFinished(const bool &success)
+{
+  job.reset();
+  setBusy(false);
+  if(success)
+    {
+      std::lock_guard<std::mutex> lglock(job_result_mtx);
+      result = std::move(job_result);
+      job_result.clear();
+    }
+  showResult();
+}
+
+void
+TextTabWidget::showResult()
+{
+  // Layout of multi-megabyte text takes much more time than encryption, so
+  // only beginning of result is shown.
+  size_t preview_sz = 65536;
+  if(result.size() <= preview_sz)
+    {
+      encrypted_text->setPlainText(QString::fromStdString(result));
+      result_info->setVisible(false);
+      return void();
+    }
+
+  // Preview must not end in the middle of UTF-8 sequence.
+  while(preview_sz > 0
+        && (static_cast<unsigned char>(result[preview_sz]) & 0xc0) == 0x80)
+    {
+      preview_sz--;
+    }
+  encrypted_text->setPlainText(
+      QString::fromUtf8(result.c_str(), static_cast<qsizetype>(preview_sz)));
+  result_info->setText(
+      tr("Result is too large to be shown completely (%1 of %2 bytes are "
+         "shown). Use \"Copy result\" or \"Save result\" to get whole "
+         "result.")
+          .arg(preview_sz)
+          .arg(result.size()));
+  result_info->setVisible(true);
+}
+
+void
+TextTabWidget::textFileDialog(const bool &encrypt)
+{
+  if(job)
+    {
+      return void();
+    }
+  QFileDialog *fd = new QFileDialog(this->window());
+  fd->setAttribute(Qt::WA_DeleteOnClose);
+  fd->setWindowModality(Qt::WindowModal);
+
+  fd->setDirectory(QDir::homePath());
+  fd->setAcceptMode(QFileDialog::AcceptOpen);
+  fd->setFileMode(QFileDialog::ExistingFile);
+  fd->setOption(QFileDialog::ReadOnly, true);
+
+  connect(fd, &QFileDialog::fileSelected, this,
+          [this, encrypt](const QString &filename)
+            {
+              textFileResultDialog(encrypt, filename);
+            });
+
+  fd->show();
+}
+
+void
+TextTabWidget::textFileResultDialog(const bool &encrypt,
+                                    const QString &source)
+{
+  std::filesystem::path p = std::filesystem::u8path(source.toStdString());
+  std::string str;
+  if(encrypt)
+    {
+      str = p.filename().u8string() + ".txt";
+    }
+  else
+    {
+      str = p.stem().u8string() + "_new";
+    }
+
+  QFileDialog *fd = new QFileDialog(this->window());
+  fd->setAttribute(Qt::WA_DeleteOnClose);
+  fd->setWindowModality(Qt::WindowModal);
+
+  fd->setDirectory(p.parent_path().u8string().c_str());
+  fd->selectFile(str.c_str());
+  fd->setAcceptMode(QFileDialog::AcceptSave);
+
+  connect(fd, &QFileDialog::fileSelected, this,
+          [this, encrypt, source](const QString &filename)
+            {
+              textFileJob(encrypt, source, filename);
+            });
+
+  fd->show();
+}
+
+void
+TextTabWidget::textFileJob(const bool &encrypt, const QString &source,
+                           const QString &result)
+{
+  if(job)
+    {
+      return void();
+    }
+  std::filesystem::path s_path
+      = std::filesystem::u8path(source.toStdString());
+  std::filesystem::path r_path
+      = std::filesystem::u8path(result.toStdString());
+  if(s_path == r_path)
+    {
+      return void();
+    }
+
+  StirlitzJob::Callbacks callbacks;
+  callbacks.progress = [this](const uint64_t &processed, const uint64_t &total)
+    {
+      if(total > 0)
+        {
+          emit signalProgress(static_cast<int>(processed * 100 / total));
+        }
+    };
+  callbacks.finished = [this](StirlitzJob &job)
+    {
+      if(job.state() == StirlitzJob::Failed)
+        {
+#ifndef __ANDROID__
+          std::cout << "TextTabWidget::textFileJob: \"" << job.error()
+                    << "\"" << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                              "TextTabWidget::textFileJob: \"%s\"",
+                              job.error().c_str());
+#endif
+        }
+      emit signalTextFileFinished(static_cast<int>(job.state()));
+    };
+
+  try
+    {
+      // Key agreement is done by job, not by event loop.
+      if(encrypt)
+        {
+          job = spy->encryptFileToTextAsync(s_path, r_path, key_pair,
+                                            other_key, callbacks);
+        }
+      else
+        {
+          job = spy->decryptFileFromTextAsync(s_path, r_path, key_pair,
+                                              other_key, callbacks);
+        }
+      setBusy(true);
+    }
+  catch(std::exception &er)
+    {
+#ifndef __ANDROID__
+      std::cout << "TextTabWidget::textFileJob: \"" << er.what() << "\""
+                << std::endl;
+#else
+      __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                          "TextTabWidget::textFileJob: \"%s\"", er.what());
+#endif
+      textFileFinished(static_cast<int>(StirlitzJob::Failed));
+    }
+}
+
+void
+TextTabWidget::textFileFinished(const int &state)
+{
+  job.reset();
+  setBusy(false);
+  if(state == StirlitzJob::Cancelled)
+    {
+      return void();
+    }
+
+  QMessageBox *msg = new QMessageBox(this->window());
+  msg->setAttribute(Qt::WA_DeleteOnClose);
+  msg->setWindowModality(Qt::WindowModal);
+  if(state == StirlitzJob::Finished)
+    {
+      msg->setText(tr("Operation successfully completed!"));
+      msg->setIcon(QMessageBox::Information);
+    }
+  else
+    {
+      msg->setText(tr("Error! See system log for details."));
+      msg->setIcon(QMessageBox::Critical);
+      msg->addButton(QMessageBox::Close);
+    }
+  msg->show();
+}
+
 void
 TextTabWidget::saveFileDialog()
 {
-  if(!encrypted_text->toPlainText().isEmpty())
+  if(!result.empty())
     {
       QFileDialog *fd = new QFileDialog(this->window());
       fd->setAttribute(Qt::WA_DeleteOnClose);
@@ -219,8 +567,7 @@ TextTabWidget::saveFileDialog()
 void
 TextTabWidget::saveFunction(const QString &filename)
 {
-  std::string buf = encrypted_text->toPlainText().toStdString();
-  if(!buf.empty())
+  if(!result.empty())
     {
       std::filesystem::path p
           = std::filesystem::u8path(filename.toStdString());
@@ -230,7 +577,7 @@ TextTabWidget::saveFunction(const QString &filename)
       f.open(p, std::ios_base::out | std::ios_base::binary);
       if(f.is_open())
         {
-          f.write(buf.c_str(), buf.size());
+          f.write(result.c_str(), result.size());
           f.close();
         }
     }
@@ -268,6 +615,6 @@ TextTabWidget::openFunction(const QString &filename)
       f.read(buf.data(), buf.size());
       f.close();
 
-      source_text->setPlainText(buf.c_str());
+      source_text->setPlainText(QString::fromStdString(buf));
     }
 }
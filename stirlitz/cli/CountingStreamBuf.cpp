@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <CountingStreamBuf.h>
+
+CountingStreamBuf::CountingStreamBuf(std::streambuf *buf)
+{
+  this->buf = buf;
+}
+
+uint64_t
+CountingStreamBuf::count()
+{
+  return bytes;
+}
+
+CountingStreamBuf::int_type
+CountingStreamBuf::underflow()
+{
+  return buf->sgetc();
+}
+
+CountingStreamBuf::int_type
+CountingStreamBuf::uflow()
+{
+  int_type result = buf->sbumpc();
+  if(!traits_type::eq_int_type(result, traits_type::eof()))
+    {
+      bytes++;
+    }
+  return result;
+}
+
+std::streamsize
+CountingStreamBuf::xsgetn(char_type *s, std::streamsize n)
+{
+  std::streamsize result = buf->sgetn(s, n);
+  bytes += static_cast<uint64_t>(result);
+  return result;
+}
+
+CountingStreamBuf::int_type
+CountingStreamBuf::overflow(int_type ch)
+{
+  if(traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      return traits_type::not_eof(ch);
+    }
+  int_type result = buf->sputc(traits_type::to_char_type(ch));
+  if(!traits_type::eq_int_type(result, traits_type::eof()))
+    {
+      bytes++;
+    }
+  return result;
+}
+
+std::streamsize
+CountingStreamBuf::xsputn(const char_type *s, std::streamsize n)
+{
+  std::streamsize result = buf->sputn(s, n);
+  bytes += static_cast<uint64_t>(result);
+  return result;
+}
+
+int
+CountingStreamBuf::sync()
+{
+  return buf->pubsync();
+}
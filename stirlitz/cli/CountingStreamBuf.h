@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COUNTINGSTREAMBUF_H
+#define COUNTINGSTREAMBUF_H
+
+#include <cstdint>
+#include <streambuf>
+
+// Pass-through stream buffer counting bytes read from (written to) wrapped
+// buffer. Used for statistics of standard input and output.
+class CountingStreamBuf : public std::streambuf
+{
+public:
+  CountingStreamBuf(std::streambuf *buf);
+
+  uint64_t
+  count();
+
+protected:
+  int_type
+  underflow() override;
+
+  int_type
+  uflow() override;
+
+  std::streamsize
+  xsgetn(char_type *s, std::streamsize n) override;
+
+  int_type
+  overflow(int_type ch) override;
+
+  std::streamsize
+  xsputn(const char_type *s, std::streamsize n) override;
+
+  int
+  sync() override;
+
+private:
+  std::streambuf *buf;
+  uint64_t bytes = 0;
+};
+
+#endif // COUNTINGSTREAMBUF_H
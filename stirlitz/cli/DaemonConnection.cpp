@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <DaemonConnection.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+DaemonConnection::DaemonConnection(const int &fd)
+{
+  this->fd = fd;
+}
+
+DaemonConnection::~DaemonConnection()
+{
+  ::close(fd);
+}
+
+std::unique_ptr<DaemonConnection>
+DaemonConnection::connect(const std::filesystem::path &socket_path)
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::string p = socket_path.string();
+  if(p.size() >= sizeof(addr.sun_path))
+    {
+      throw std::runtime_error(
+          "DaemonConnection::connect: socket path is too long");
+    }
+  std::memcpy(addr.sun_path, p.c_str(), p.size());
+
+  int sock = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(sock < 0)
+    {
+      throw std::runtime_error("DaemonConnection::connect: "
+                               + std::string(std::strerror(errno)));
+    }
+  std::unique_ptr<DaemonConnection> result(new DaemonConnection(sock));
+  if(::connect(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+      throw std::runtime_error("DaemonConnection::connect: " + p + ": "
+                               + std::string(std::strerror(errno)));
+    }
+
+  return result;
+}
+
+std::filesystem::path
+DaemonConnection::defaultSocketPath()
+{
+  std::filesystem::path result;
+  const char *run_dir = std::getenv("XDG_RUNTIME_DIR");
+  if(run_dir && *run_dir != 0)
+    {
+      result = std::filesystem::u8path(run_dir)
+               / std::filesystem::u8path("stirlitzd.sock");
+    }
+  else
+    {
+      result = std::filesystem::temp_directory_path()
+               / std::filesystem::u8path(
+                   "stirlitzd-" + std::to_string(getuid()) + ".sock");
+    }
+  return result;
+}
+
+void
+DaemonConnection::send(const DaemonMessage &msg)
+{
+  if(msg.name.size() > name_max || msg.data.size() > inline_max)
+    {
+      throw std::runtime_error("DaemonConnection::send: message is too large");
+    }
+
+  Header hdr;
+  hdr.magic = magic;
+  hdr.op = msg.op;
+  hdr.flags = msg.flags;
+  hdr.status = msg.status;
+  hdr.threads = msg.threads;
+  hdr.name_len = static_cast<uint32_t>(msg.name.size());
+  hdr.frame_size = msg.frame_size;
+  hdr.data_len = static_cast<uint64_t>(msg.data.size());
+
+  iovec iov;
+  iov.iov_base = &hdr;
+  iov.iov_len = sizeof(hdr);
+
+  msghdr mhdr;
+  std::memset(&mhdr, 0, sizeof(mhdr));
+  mhdr.msg_iov = &iov;
+  mhdr.msg_iovlen = 1;
+
+  alignas(cmsghdr) char cbuf[CMSG_SPACE(sizeof(int))];
+  if(msg.fd >= 0)
+    {
+      std::memset(cbuf, 0, sizeof(cbuf));
+      mhdr.msg_control = cbuf;
+      mhdr.msg_controllen = sizeof(cbuf);
+      cmsghdr *cmsg = CMSG_FIRSTHDR(&mhdr);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+      std::memcpy(CMSG_DATA(cmsg), &msg.fd, sizeof(int));
+    }
+
+  ssize_t sent;
+  do
+    {
+      sent = ::sendmsg(fd, &mhdr, MSG_NOSIGNAL);
+    }
+  while(sent < 0 && errno == EINTR);
+  if(sent < 0)
+    {
+      throw std::runtime_error("DaemonConnection::send: "
+                               + std::string(std::strerror(errno)));
+    }
+  // Descriptor is attached to first byte, rest is sent as is.
+  writeAll(reinterpret_cast<const char *>(&hdr) + sent,
+           sizeof(hdr) - static_cast<size_t>(sent));
+  writeAll(msg.name.c_str(), msg.name.size());
+  writeAll(msg.data.c_str(), msg.data.size());
+}
+
+bool
+DaemonConnection::receive(DaemonMessage &msg)
+{
+  Header hdr;
+  iovec iov;
+  iov.iov_base = &hdr;
+  iov.iov_len = sizeof(hdr);
+
+  msghdr mhdr;
+  std::memset(&mhdr, 0, sizeof(mhdr));
+  mhdr.msg_iov = &iov;
+  mhdr.msg_iovlen = 1;
+  alignas(cmsghdr) char cbuf[CMSG_SPACE(sizeof(int))];
+  mhdr.msg_control = cbuf;
+  mhdr.msg_controllen = sizeof(cbuf);
+
+  ssize_t rcvd;
+  do
+    {
+      rcvd = ::recvmsg(fd, &mhdr, MSG_CMSG_CLOEXEC);
+    }
+  while(rcvd < 0 && errno == EINTR);
+  if(rcvd < 0)
+    {
+      throw std::runtime_error("DaemonConnection::receive: "
+                               + std::string(std::strerror(errno)));
+    }
+  if(rcvd == 0)
+    {
+      return false;
+    }
+
+  for(cmsghdr *cmsg = CMSG_FIRSTHDR(&mhdr); cmsg != nullptr;
+      cmsg = CMSG_NXTHDR(&mhdr, cmsg))
+    {
+      if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+          size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+          for(size_t i = 0; i < num; i++)
+            {
+              int r_fd;
+              std::memcpy(&r_fd, CMSG_DATA(cmsg) + i * sizeof(int),
+                          sizeof(int));
+              if(i == 0)
+                {
+                  msg.setFd(r_fd);
+                }
+              else
+                {
+                  ::close(r_fd);
+                }
+            }
+        }
+    }
+
+  readAll(reinterpret_cast<char *>(&hdr) + rcvd,
+          sizeof(hdr) - static_cast<size_t>(rcvd));
+  if(hdr.magic != magic || hdr.name_len > name_max
+     || hdr.data_len > inline_max)
+    {
+      throw std::runtime_error("DaemonConnection::receive: incorrect message");
+    }
+  if((hdr.flags & DaemonMessage::PayloadFd) && msg.fd < 0)
+    {
+      throw std::runtime_error(
+          "DaemonConnection::receive: descriptor has not been received");
+    }
+
+  msg.op = hdr.op;
+  msg.flags = hdr.flags;
+  msg.status = hdr.status;
+  msg.threads = hdr.threads;
+  msg.frame_size = hdr.frame_size;
+  msg.name.resize(hdr.name_len);
+  readAll(msg.name.data(), msg.name.size());
+  msg.data.resize(static_cast<size_t>(hdr.data_len));
+  readAll(msg.data.data(), msg.data.size());
+
+  return true;
+}
+
+void
+DaemonConnection::shutdown()
+{
+  ::shutdown(fd, SHUT_RDWR);
+}
+
+int
+DaemonConnection::descriptor()
+{
+  return fd;
+}
+
+void
+DaemonConnection::writeAll(const char *buf, const size_t &sz)
+{
+  size_t written = 0;
+  while(written < sz)
+    {
+      ssize_t wb = ::send(fd, buf + written, sz - written, MSG_NOSIGNAL);
+      if(wb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          throw std::runtime_error("DaemonConnection::send: "
+                                   + std::string(std::strerror(errno)));
+        }
+      written += static_cast<size_t>(wb);
+    }
+}
+
+void
+DaemonConnection::readAll(char *buf, const size_t &sz)
+{
+  size_t rcvd = 0;
+  while(rcvd < sz)
+    {
+      ssize_t rb = ::recv(fd, buf + rcvd, sz - rcvd, 0);
+      if(rb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          throw std::runtime_error("DaemonConnection::receive: "
+                                   + std::string(std::strerror(errno)));
+        }
+      if(rb == 0)
+        {
+          throw std::runtime_error(
+              "DaemonConnection::receive: connection has been closed");
+        }
+      rcvd += static_cast<size_t>(rb);
+    }
+}
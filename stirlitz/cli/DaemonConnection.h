@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DAEMONCONNECTION_H
+#define DAEMONCONNECTION_H
+
+#include <DaemonMessage.h>
+#include <filesystem>
+#include <memory>
+
+// Connection to (from) stirlitzd over Unix domain socket. Message header is
+// followed by profile name and inline payload, payload descriptor is passed
+// with header by SCM_RIGHTS.
+class DaemonConnection
+{
+public:
+  DaemonConnection(const int &fd);
+
+  ~DaemonConnection();
+
+  static std::unique_ptr<DaemonConnection>
+  connect(const std::filesystem::path &socket_path);
+
+  static std::filesystem::path
+  defaultSocketPath();
+
+  void
+  send(const DaemonMessage &msg);
+
+  bool
+  receive(DaemonMessage &msg);
+
+  void
+  shutdown();
+
+  int
+  descriptor();
+
+  static const uint64_t inline_max = 1048576;
+
+private:
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t op;
+    uint32_t flags;
+    uint32_t status;
+    uint32_t threads;
+    uint32_t name_len;
+    uint64_t frame_size;
+    uint64_t data_len;
+  };
+
+  void
+  writeAll(const char *buf, const size_t &sz);
+
+  void
+  readAll(char *buf, const size_t &sz);
+
+  int fd;
+
+  static const uint32_t magic = 0x315a5453;
+  static const uint32_t name_max = 4096;
+};
+
+#endif // DAEMONCONNECTION_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <DaemonMessage.h>
+#include <unistd.h>
+
+DaemonMessage::DaemonMessage()
+{
+}
+
+DaemonMessage::~DaemonMessage()
+{
+  setFd(-1);
+}
+
+void
+DaemonMessage::setFd(const int &fd)
+{
+  if(this->fd >= 0)
+    {
+      ::close(this->fd);
+    }
+  this->fd = fd;
+  if(fd >= 0)
+    {
+      flags |= Flags::PayloadFd;
+    }
+  else
+    {
+      flags &= ~Flags::PayloadFd;
+    }
+}
+
+int
+DaemonMessage::releaseFd()
+{
+  int result = fd;
+  fd = -1;
+  flags &= ~Flags::PayloadFd;
+  return result;
+}
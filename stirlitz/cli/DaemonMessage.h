@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DAEMONMESSAGE_H
+#define DAEMONMESSAGE_H
+
+#include <cstdint>
+#include <string>
+
+// Request (response) of stirlitzd. Payload is passed either inline (data) or
+// as file descriptor of regular file or memfd (fd), see PayloadFd flag.
+// Message owns descriptor and closes it in destructor.
+class DaemonMessage
+{
+public:
+  enum Operation : uint32_t
+  {
+    NoOperation,
+    Unlock,
+    Lock,
+    Encrypt,
+    Decrypt
+  };
+
+  enum Flags : uint32_t
+  {
+    PayloadFd = 1,
+    // Unlock: name and password are used for encryption directly, profile
+    // keys are not loaded.
+    SimpleCredentials = 2,
+    // Encrypt, Decrypt: one-shot format of Stirlitz::encryptData().
+    WholeData = 4,
+    // Encrypt: result is returned in hexadecimal format. Decrypt: payload is
+    // in hexadecimal format.
+    Hex = 8
+  };
+
+  enum Status : uint32_t
+  {
+    Ok,
+    Error
+  };
+
+  DaemonMessage();
+
+  DaemonMessage(const DaemonMessage &other) = delete;
+
+  DaemonMessage &
+  operator=(const DaemonMessage &other)
+      = delete;
+
+  ~DaemonMessage();
+
+  void
+  setFd(const int &fd);
+
+  int
+  releaseFd();
+
+  uint32_t op = Operation::NoOperation;
+  uint32_t flags = 0;
+  uint32_t status = Status::Ok;
+  uint32_t threads = 1;
+  uint64_t frame_size = 10485760;
+  std::string name;
+  std::string data;
+  int fd = -1;
+};
+
+#endif // DAEMONMESSAGE_H
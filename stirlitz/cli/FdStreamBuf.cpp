@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <FdStreamBuf.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+FdStreamBuf::FdStreamBuf(const int &fd)
+{
+  this->fd = fd;
+}
+
+FdStreamBuf::int_type
+FdStreamBuf::underflow()
+{
+  if(gptr() < egptr())
+    {
+      return traits_type::to_int_type(*gptr());
+    }
+  if(xsgetn(&ch_buf, 1) != 1)
+    {
+      return traits_type::eof();
+    }
+  // Byte has been consumed by xsgetn, it is returned to get area.
+  setg(&ch_buf, &ch_buf, &ch_buf + 1);
+  return traits_type::to_int_type(ch_buf);
+}
+
+std::streamsize
+FdStreamBuf::xsgetn(char_type *s, std::streamsize n)
+{
+  std::streamsize result = 0;
+  if(gptr() < egptr() && n > 0)
+    {
+      *s = *gptr();
+      gbump(1);
+      result++;
+    }
+  while(result < n)
+    {
+      ssize_t rb = ::pread(fd, s + result, static_cast<size_t>(n - result),
+                           static_cast<off_t>(offset));
+      if(rb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          // Error must not look like end of payload. Exception sets badbit
+          // of stream, so reader fails instead of processing truncated data.
+          throw std::runtime_error("FdStreamBuf::xsgetn: "
+                                   + std::string(std::strerror(errno)));
+        }
+      if(rb == 0)
+        {
+          break;
+        }
+      offset += static_cast<uint64_t>(rb);
+      result += rb;
+    }
+  return result;
+}
+
+FdStreamBuf::int_type
+FdStreamBuf::overflow(int_type ch)
+{
+  if(traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      return traits_type::not_eof(ch);
+    }
+  char c = traits_type::to_char_type(ch);
+  if(xsputn(&c, 1) != 1)
+    {
+      return traits_type::eof();
+    }
+  return ch;
+}
+
+std::streamsize
+FdStreamBuf::xsputn(const char_type *s, std::streamsize n)
+{
+  std::streamsize result = 0;
+  while(result < n)
+    {
+      ssize_t wb = ::pwrite(fd, s + result, static_cast<size_t>(n - result),
+                            static_cast<off_t>(offset));
+      if(wb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          break;
+        }
+      offset += static_cast<uint64_t>(wb);
+      result += wb;
+    }
+  return result;
+}
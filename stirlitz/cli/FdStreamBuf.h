@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FDSTREAMBUF_H
+#define FDSTREAMBUF_H
+
+#include <cstdint>
+#include <streambuf>
+
+// Unbuffered stream buffer over descriptor of regular file (memfd). Data is
+// read (written) by pread (pwrite) from the beginning of file directly
+// to (from) caller's buffer, so file offset shared with other processes is
+// not changed.
+class FdStreamBuf : public std::streambuf
+{
+public:
+  FdStreamBuf(const int &fd);
+
+protected:
+  int_type
+  underflow() override;
+
+  std::streamsize
+  xsgetn(char_type *s, std::streamsize n) override;
+
+  int_type
+  overflow(int_type ch) override;
+
+  std::streamsize
+  xsputn(const char_type *s, std::streamsize n) override;
+
+private:
+  int fd;
+  uint64_t offset = 0;
+  char ch_buf;
+};
+
+#endif // FDSTREAMBUF_H
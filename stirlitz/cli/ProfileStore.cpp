@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ProfileStore.h>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+ProfileStore::ProfileStore(Stirlitz *spy,
+                           const std::filesystem::path &profile_dir)
+{
+  this->spy = spy;
+  this->profile_dir = profile_dir;
+}
+
+std::shared_ptr<gcry_sexp>
+ProfileStore::loadKey(const std::string &profile, const std::string &file_name,
+                      const std::string &username,
+                      const std::string &password)
+{
+  std::filesystem::path p
+      = profilePath(profile) / std::filesystem::u8path(file_name);
+  std::ifstream f(p, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      if(file_name == "owk")
+        {
+          throw std::runtime_error("profile has no key pair");
+        }
+      else
+        {
+          throw std::runtime_error("profile has no interlocutor's key");
+        }
+    }
+  std::string val((std::istreambuf_iterator<char>(f)),
+                  std::istreambuf_iterator<char>());
+  f.close();
+
+  std::shared_ptr<gcry_sexp> result;
+  try
+    {
+      // Own key pair and interlocutor's key are stored in compact binary
+      // form (S-expressions written by older versions are accepted too).
+      val = spy->decryptData(username, password, val);
+      if(file_name == "owk")
+        {
+          result = StirlitzKeyPair::deserialize(val).sexp();
+        }
+      else
+        {
+          result = StirlitzKey::deserialize(val).sexp();
+        }
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("incorrect user name or password");
+    }
+
+  return result;
+}
+
+void
+ProfileStore::saveKey(const std::string &profile, const std::string &file_name,
+                      std::shared_ptr<gcry_sexp> key,
+                      const std::string &username, const std::string &password)
+{
+  std::string val;
+  if(file_name == "owk")
+    {
+      val = StirlitzKeyPair::fromSexp(key).serialize();
+    }
+  else
+    {
+      val = StirlitzKey::fromSexp(key).serialize();
+    }
+  val = spy->encryptData(username, password, val);
+
+  std::filesystem::path p
+      = profilePath(profile) / std::filesystem::u8path(file_name);
+  std::filesystem::create_directories(p.parent_path());
+  std::ofstream f(p, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error("cannot write profile file");
+    }
+  f.write(val.c_str(), val.size());
+  f.close();
+  if(f.fail())
+    {
+      throw std::runtime_error("cannot write profile file");
+    }
+}
+
+bool
+ProfileStore::hasKey(const std::string &profile, const std::string &file_name)
+{
+  return std::filesystem::exists(profilePath(profile)
+                                 / std::filesystem::u8path(file_name));
+}
+
+void
+ProfileStore::loadKeyring(const std::string &profile,
+                          StirlitzKeyring &keyring,
+                          const std::string &username,
+                          const std::string &password)
+{
+  if(!hasKey(profile, "keyring"))
+    {
+      keyring.clear();
+      return void();
+    }
+  try
+    {
+      keyring.load(profilePath(profile) / std::filesystem::u8path("keyring"),
+                   username, password);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("incorrect user name or password");
+    }
+}
+
+void
+ProfileStore::saveKeyring(const std::string &profile,
+                          StirlitzKeyring &keyring,
+                          const std::string &username,
+                          const std::string &password)
+{
+  try
+    {
+      keyring.save(profilePath(profile) / std::filesystem::u8path("keyring"),
+                   username, password);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("cannot write profile file");
+    }
+}
+
+std::filesystem::path
+ProfileStore::profilePath(const std::string &profile)
+{
+  if(profile.empty())
+    {
+      throw std::runtime_error("profile is not set");
+    }
+
+  std::filesystem::path result = profile_dir;
+  if(result.empty())
+    {
+#ifdef _WIN32
+      const char *home = std::getenv("USERPROFILE");
+#else
+      const char *home = std::getenv("HOME");
+#endif
+      if(home == nullptr)
+        {
+          throw std::runtime_error("cannot find home directory");
+        }
+      result = std::filesystem::u8path(home)
+               / std::filesystem::u8path(".local")
+               / std::filesystem::u8path("share")
+               / std::filesystem::u8path("Stirlitz");
+    }
+  result /= std::filesystem::u8path(profile);
+
+  return result;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+
+#include <Stirlitz.h>
+#include <StirlitzKeyring.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+// Profiles storage compatible with Stirlitz GUI: each profile is directory
+// containing own key pair (owk) and interlocutor's public key (otk). Both
+// files are encrypted by profile user name and password. Profile can also
+// contain keyring with many interlocutors' keys (keyring), which is encrypted
+// by the same user name and password.
+class ProfileStore
+{
+public:
+  ProfileStore(Stirlitz *spy, const std::filesystem::path &profile_dir);
+
+  std::shared_ptr<gcry_sexp>
+  loadKey(const std::string &profile, const std::string &file_name,
+          const std::string &username, const std::string &password);
+
+  void
+  saveKey(const std::string &profile, const std::string &file_name,
+          std::shared_ptr<gcry_sexp> key, const std::string &username,
+          const std::string &password);
+
+  bool
+  hasKey(const std::string &profile, const std::string &file_name);
+
+  void
+  loadKeyring(const std::string &profile, StirlitzKeyring &keyring,
+              const std::string &username, const std::string &password);
+
+  void
+  saveKeyring(const std::string &profile, StirlitzKeyring &keyring,
+              const std::string &username, const std::string &password);
+
+  std::filesystem::path
+  profilePath(const std::string &profile);
+
+private:
+  Stirlitz *spy;
+  std::filesystem::path profile_dir;
+};
+
+#endif // PROFILESTORE_H
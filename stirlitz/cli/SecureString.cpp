@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SecureString.h>
+#include <gcrypt.h>
+#include <stdexcept>
+
+SecureString::SecureString(const std::string &val)
+{
+  sz = val.size();
+  if(sz > 0)
+    {
+      data = reinterpret_cast<char *>(gcry_malloc_secure(sz));
+      if(data == nullptr)
+        {
+          throw std::runtime_error(
+              "SecureString: cannot allocate secure memory");
+        }
+      for(size_t i = 0; i < sz; i++)
+        {
+          data[i] = val[i];
+        }
+    }
+}
+
+SecureString::~SecureString()
+{
+  if(data)
+    {
+      gcry_free(data);
+    }
+}
+
+std::string
+SecureString::str() const
+{
+  std::string result;
+  result.resize(sz);
+  for(size_t i = 0; i < sz; i++)
+    {
+      result[i] = data[i];
+    }
+  return result;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SECURESTRING_H
+#define SECURESTRING_H
+
+#include <string>
+
+// String kept in libgcrypt secure memory (not swapped, zeroed on release).
+class SecureString
+{
+public:
+  SecureString(const std::string &val);
+
+  SecureString(const SecureString &other) = delete;
+
+  SecureString &
+  operator=(const SecureString &other)
+      = delete;
+
+  ~SecureString();
+
+  std::string
+  str() const;
+
+private:
+  char *data = nullptr;
+  size_t sz = 0;
+};
+
+#endif // SECURESTRING_H
@@ -0,0 +1,1435 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <CountingStreamBuf.h>
+#include <ProfileStore.h>
+#include <StirlitzArmor.h>
+#include <StirlitzCli.h>
+#include <StirlitzHash.h>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#ifdef __linux__
+#include <DaemonConnection.h>
+#include <FdStreamBuf.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+StirlitzCli::StirlitzCli()
+{
+}
+
+StirlitzCli::~StirlitzCli()
+{
+  delete spy;
+}
+
+int
+StirlitzCli::run(int argc, char *argv[])
+{
+  std::vector<std::string> args;
+  for(int i = 1; i < argc; i++)
+    {
+      args.push_back(argv[i]);
+    }
+
+  if(!parseArgs(args))
+    {
+      std::cerr << "Try 'stirlitz-cli --help' for more information."
+                << std::endl;
+      return 2;
+    }
+  if(help)
+    {
+      usage();
+      return 0;
+    }
+  if(command == Command::NoCommand)
+    {
+      usage();
+      return 2;
+    }
+
+#ifdef _WIN32
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  std::ios_base::sync_with_stdio(false);
+
+  if(daemon)
+    {
+#ifdef __linux__
+      start = std::chrono::steady_clock::now();
+      try
+        {
+          daemonRequest();
+        }
+      catch(std::exception &er)
+        {
+          std::cout.flush();
+          std::cerr << "stirlitz-cli: " << er.what() << std::endl;
+          return 1;
+        }
+      return 0;
+#else
+      std::cerr << "stirlitz-cli: daemon is available only on Linux"
+                << std::endl;
+      return 2;
+#endif
+    }
+  if(command == Command::Unlock || command == Command::Lock)
+    {
+      std::cerr << "stirlitz-cli: command needs --daemon" << std::endl;
+      return 2;
+    }
+
+  try
+    {
+      // Library reports libgcrypt initialization to standard output, which
+      // can be used for result, so report is suppressed.
+      std::streambuf *cout_buf = std::cout.rdbuf(nullptr);
+      try
+        {
+          spy = new Stirlitz;
+        }
+      catch(std::exception &er)
+        {
+          std::cout.rdbuf(cout_buf);
+          std::cout.clear();
+          throw;
+        }
+      std::cout.rdbuf(cout_buf);
+      std::cout.clear();
+
+      start = std::chrono::steady_clock::now();
+      switch(command)
+        {
+        case Command::Encrypt:
+          {
+            if(text_mode)
+              {
+                text(true);
+              }
+            else
+              {
+                data(true);
+              }
+            break;
+          }
+        case Command::Decrypt:
+          {
+            if(text_mode)
+              {
+                text(false);
+              }
+            else
+              {
+                data(false);
+              }
+            break;
+          }
+        case Command::Verify:
+          {
+            verify();
+            break;
+          }
+        case Command::Hash:
+          {
+            hash();
+            break;
+          }
+        case Command::KeyGen:
+          {
+            keyGen();
+            break;
+          }
+        case Command::PubKey:
+          {
+            pubKey();
+            break;
+          }
+        case Command::SetKey:
+          {
+            setKey();
+            break;
+          }
+        case Command::AddPeer:
+          {
+            addPeer();
+            break;
+          }
+        case Command::Peers:
+          {
+            peers();
+            break;
+          }
+        default:
+          break;
+        }
+    }
+  catch(std::exception &er)
+    {
+      std::cout.flush();
+      std::cerr << "stirlitz-cli: " << er.what() << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
+
+bool
+StirlitzCli::parseArgs(const std::vector<std::string> &args)
+{
+  for(size_t i = 0; i < args.size(); i++)
+    {
+      const std::string &arg = args[i];
+      std::string val;
+      auto value = [&args, &i, &arg, &val]
+        {
+          if(i + 1 >= args.size())
+            {
+              std::cerr << "stirlitz-cli: option '" << arg
+                        << "' requires an argument" << std::endl;
+              return false;
+            }
+          i++;
+          val = args[i];
+          return true;
+        };
+
+      if(arg == "-h" || arg == "--help")
+        {
+          help = true;
+          return true;
+        }
+      else if(arg == "-i" || arg == "--input")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          input = val;
+        }
+      else if(arg == "-o" || arg == "--output")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          output = val;
+        }
+      else if(arg == "-t" || arg == "--text")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          text_data = val;
+          text_mode = true;
+        }
+      else if(arg == "-P" || arg == "--profile")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          profile = val;
+        }
+      else if(arg == "--profile-dir")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          profile_dir = std::filesystem::u8path(val);
+        }
+      else if(arg == "-u" || arg == "--username")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          username = val;
+        }
+      else if(arg == "--password-file")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          password_file = std::filesystem::u8path(val);
+        }
+      else if(arg == "-k" || arg == "--key")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          key = val;
+        }
+      else if(arg == "--peer")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          peer = val;
+        }
+      else if(arg == "-r" || arg == "--recipient")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          recipients.push_back(val);
+          multi = true;
+        }
+      else if(arg == "--multi")
+        {
+          multi = true;
+        }
+      else if(arg == "--name")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          peer_name = val;
+        }
+      else if(arg == "-j" || arg == "--threads")
+        {
+          if(!value() || !parseSize(val, options.threads)
+             || options.threads == 0)
+            {
+              std::cerr << "stirlitz-cli: incorrect number of threads"
+                        << std::endl;
+              return false;
+            }
+        }
+      else if(arg == "-f" || arg == "--frame-size")
+        {
+          if(!value() || !parseSize(val, options.frame_size))
+            {
+              std::cerr << "stirlitz-cli: incorrect frame size" << std::endl;
+              return false;
+            }
+        }
+      else if(arg == "-m" || arg == "--memory")
+        {
+          if(!value() || !parseSize(val, options.memory_budget))
+            {
+              std::cerr << "stirlitz-cli: incorrect memory budget"
+                        << std::endl;
+              return false;
+            }
+        }
+      else if(arg == "--algo")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          hash_algo = val;
+        }
+      else if(arg == "--tree")
+        {
+          if(!value() || !parseSize(val, leaf_size) || leaf_size == 0)
+            {
+              std::cerr << "stirlitz-cli: incorrect leaf size" << std::endl;
+              return false;
+            }
+        }
+      else if(arg == "--integrity")
+        {
+          options.integrity = true;
+        }
+      else if(arg == "-a" || arg == "--armor")
+        {
+          options.armor = true;
+        }
+      else if(arg == "--armor-encoding")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          if(val == "hex")
+            {
+              options.armor_encoding = StirlitzArmor::Hex;
+            }
+          else if(val == "base64")
+            {
+              options.armor_encoding = StirlitzArmor::Base64;
+            }
+          else
+            {
+              std::cerr << "stirlitz-cli: incorrect armor encoding"
+                        << std::endl;
+              return false;
+            }
+          options.armor = true;
+        }
+      else if(arg == "--direct")
+        {
+          options.direct_io = true;
+        }
+      else if(arg == "--io-uring")
+        {
+          options.io_backend = Stirlitz::FileOptions::IOUring;
+        }
+      else if(arg == "--queue-depth")
+        {
+          if(!value() || !parseSize(val, options.io_queue_depth))
+            {
+              std::cerr << "stirlitz-cli: incorrect queue depth" << std::endl;
+              return false;
+            }
+        }
+      else if(arg == "--sparse")
+        {
+          options.sparse = true;
+        }
+      else if(arg == "--parts")
+        {
+          size_t part_sz;
+          if(!value() || !parseSize(val, part_sz) || part_sz == 0)
+            {
+              std::cerr << "stirlitz-cli: incorrect part size" << std::endl;
+              return false;
+            }
+          options.part_size = part_sz;
+        }
+      else if(arg == "--part")
+        {
+          if(!value() || !parseSize(val, part))
+            {
+              std::cerr << "stirlitz-cli: incorrect part number"
+                        << std::endl;
+              return false;
+            }
+          single_part = true;
+        }
+      else if(arg == "--sync")
+        {
+          options.durability = Stirlitz::FileOptions::SyncFile;
+        }
+      else if(arg == "--no-preallocate")
+        {
+          options.preallocate = false;
+        }
+      else if(arg == "--in-place")
+        {
+          in_place = true;
+        }
+      else if(arg == "-s" || arg == "--stats")
+        {
+          stats = true;
+        }
+      else if(arg == "-d" || arg == "--daemon")
+        {
+          daemon = true;
+        }
+      else if(arg == "-S" || arg == "--socket")
+        {
+          if(!value())
+            {
+              return false;
+            }
+          socket_path = std::filesystem::u8path(val);
+          daemon = true;
+        }
+      else if(arg == "--simple")
+        {
+          simple = true;
+        }
+      else if(command == Command::NoCommand && arg == "encrypt")
+        {
+          command = Command::Encrypt;
+        }
+      else if(command == Command::NoCommand && arg == "decrypt")
+        {
+          command = Command::Decrypt;
+        }
+      else if(command == Command::NoCommand && arg == "verify")
+        {
+          command = Command::Verify;
+        }
+      else if(command == Command::NoCommand && arg == "hash")
+        {
+          command = Command::Hash;
+        }
+      else if(command == Command::NoCommand && arg == "keygen")
+        {
+          command = Command::KeyGen;
+        }
+      else if(command == Command::NoCommand && arg == "pubkey")
+        {
+          command = Command::PubKey;
+        }
+      else if(command == Command::NoCommand && arg == "setkey")
+        {
+          command = Command::SetKey;
+        }
+      else if(command == Command::NoCommand && arg == "addpeer")
+        {
+          command = Command::AddPeer;
+        }
+      else if(command == Command::NoCommand && arg == "peers")
+        {
+          command = Command::Peers;
+        }
+      else if(command == Command::NoCommand && arg == "unlock")
+        {
+          command = Command::Unlock;
+        }
+      else if(command == Command::NoCommand && arg == "lock")
+        {
+          command = Command::Lock;
+        }
+      else
+        {
+          std::cerr << "stirlitz-cli: unknown argument '" << arg << "'"
+                    << std::endl;
+          return false;
+        }
+    }
+
+  return true;
+}
+
+bool
+StirlitzCli::parseSize(const std::string &val, size_t &result)
+{
+  if(val.empty()
+     || val.find_first_not_of("0123456789") != std::string::npos)
+    {
+      return false;
+    }
+  try
+    {
+      result = static_cast<size_t>(std::stoull(val));
+    }
+  catch(std::exception &er)
+    {
+      return false;
+    }
+  return true;
+}
+
+void
+StirlitzCli::usage()
+{
+  std::cout
+      << "Usage: stirlitz-cli COMMAND [OPTIONS]\n"
+         "\n"
+         "Commands:\n"
+         "  encrypt                 encrypt file, standard input or text\n"
+         "  decrypt                 decrypt file, standard input or text\n"
+         "  verify                  check integrity tags of encrypted file\n"
+         "  hash                    print hash summ of file or standard "
+         "input\n"
+         "  keygen                  generate key pair of profile\n"
+         "  pubkey                  print public key of profile\n"
+         "  setkey                  set interlocutor's public key of profile\n"
+         "  addpeer                 add interlocutor's public key to keyring "
+         "of profile\n"
+         "  peers                   list keys of profile keyring\n"
+         "  unlock                  load keys of profile to stirlitzd\n"
+         "  lock                    remove keys of profile (all profiles if "
+         "profile is not\n"
+         "                          set) from stirlitzd\n"
+         "\n"
+         "Options:\n"
+         "  -i, --input PATH        source file ('-' for standard input, "
+         "default)\n"
+         "  -o, --output PATH       result file ('-' for standard output, "
+         "default)\n"
+         "  -t, --text TEXT         encrypt TEXT and print it in hexadecimal "
+         "format or\n"
+         "                          decrypt hexadecimal TEXT ('-' to read "
+         "standard input)\n"
+         "  -P, --profile NAME      use key pair of profile and "
+         "interlocutor's key\n"
+         "      --profile-dir PATH  profiles directory (default "
+         "~/.local/share/Stirlitz)\n"
+         "  -u, --username NAME     user name (or STIRLITZ_USERNAME "
+         "environment variable)\n"
+         "      --password-file PATH\n"
+         "                          read password from first line of file "
+         "(STIRLITZ_PASSWORD\n"
+         "                          environment variable is used otherwise)\n"
+         "  -k, --key HEX           interlocutor's public key (setkey, "
+         "addpeer)\n"
+         "      --peer FINGERPRINT  use key from profile keyring instead of "
+         "interlocutor's\n"
+         "                          key of profile\n"
+         "      --name NAME         name of key owner (addpeer)\n"
+         "  -r, --recipient FINGERPRINT\n"
+         "                          encrypt file once for several keys from "
+         "profile keyring\n"
+         "                          (can be repeated, own key is always "
+         "added)\n"
+         "      --multi             decrypt file encrypted for several "
+         "recipients\n"
+         "  -j, --threads N         number of threads processing frames "
+         "(default 1)\n"
+         "  -f, --frame-size BYTES  size of encrypted frame (default "
+         "10485760)\n"
+         "  -m, --memory BYTES      limit memory used by frames and I/O "
+         "buffers (threads\n"
+         "                          and io_uring queue are reduced to fit, "
+         "default no limit)\n"
+         "      --algo NAME         hash algorithm (default SHA256)\n"
+         "      --tree BYTES        hash: tree hash with leaves of given "
+         "size, leaves are\n"
+         "                          hashed by --threads threads\n"
+         "      --integrity         add (check) integrity tag of each "
+         "frame\n"
+         "  -a, --armor             write (read) encrypted data as armored "
+         "text\n"
+         "      --armor-encoding E  armor encoding: base64 (default) or hex\n"
+         "      --direct            bypass page cache (O_DIRECT)\n"
+         "      --io-uring          use io_uring I/O backend\n"
+         "      --queue-depth N     io_uring chunks in flight (default 8)\n"
+         "      --no-preallocate    do not preallocate resulting file\n"
+         "      --sparse            skip holes and zero frames (must be set "
+         "for decryption\n"
+         "                          too), decryption recreates holes\n"
+         "      --parts BYTES       split encrypted file into parts of "
+         "given size, output\n"
+         "                          (decryption input) is manifest listing "
+         "parts\n"
+         "      --part N            encrypt (decrypt, verify) only part N "
+         "of --parts set\n"
+         "      --sync              flush resulting file to storage before it "
+         "replaces\n"
+         "                          previous file\n"
+         "      --in-place          encrypt (decrypt) input file in place\n"
+         "  -s, --stats             print statistics to standard error\n"
+         "  -d, --daemon            send request to stirlitzd (Linux only)\n"
+         "  -S, --socket PATH       stirlitzd socket (default "
+         "$XDG_RUNTIME_DIR/stirlitzd.sock)\n"
+         "      --simple            unlock: keep user name and password as "
+         "is, do not load\n"
+         "                          profile keys (encryption without "
+         "profile)\n"
+         "  -h, --help              print this help\n"
+         "\n"
+         "Without profile data is encrypted by user name and password "
+         "directly. With\n"
+         "profile user name and password unlock profile keys and data is "
+         "encrypted by\n"
+         "key derived from own key pair and interlocutor's key. Profiles are "
+         "compatible\n"
+         "with Stirlitz GUI.\n"
+         "\n"
+         "With --daemon keys are kept by stirlitzd: profile is unlocked "
+         "once by unlock\n"
+         "command, following requests need only profile name. Files are "
+         "passed to\n"
+         "stirlitzd as descriptors, no data is copied through socket.\n";
+}
+
+void
+StirlitzCli::data(const bool &encrypt)
+{
+  if(multi)
+    {
+      multiData(encrypt);
+      return void();
+    }
+
+  std::string unm;
+  std::string pwd;
+  if(profile.empty())
+    {
+      credentials(unm, pwd);
+    }
+  else
+    {
+      profileCredentials(encrypt, unm, pwd);
+    }
+
+  if(single_part && options.part_size == 0)
+    {
+      throw std::runtime_error("--part needs --parts");
+    }
+  if(options.part_size != 0 && (in_place || input == "-" || output == "-"))
+    {
+      throw std::runtime_error("--parts needs input and output files");
+    }
+
+  if(in_place)
+    {
+      if(input == "-" || output != "-")
+        {
+          throw std::runtime_error(
+              "--in-place needs input file and no output");
+        }
+      std::filesystem::path p = std::filesystem::u8path(input);
+      uint64_t in_sz = std::filesystem::file_size(p);
+      if(encrypt)
+        {
+          spy->encryptFileInPlace(p, unm, pwd, options);
+        }
+      else
+        {
+          spy->decryptFileInPlace(p, unm, pwd, options);
+        }
+      printStats(in_sz, std::filesystem::file_size(p));
+    }
+  else if(input != "-" && output != "-")
+    {
+      std::filesystem::path source = std::filesystem::u8path(input);
+      std::filesystem::path result = std::filesystem::u8path(output);
+      if(single_part)
+        {
+          if(encrypt)
+            {
+              spy->encryptFilePart(source, result, part, unm, pwd, options);
+            }
+          else
+            {
+              spy->decryptFilePart(source, result, part, unm, pwd, options);
+            }
+        }
+      else if(encrypt)
+        {
+          spy->encryptFile(source, result, unm, pwd, options);
+        }
+      else
+        {
+          spy->decryptFile(source, result, unm, pwd, options);
+        }
+      printStats(std::filesystem::file_size(source),
+                 std::filesystem::file_size(result));
+    }
+  else
+    {
+      std::ifstream f_in;
+      std::streambuf *in_buf = std::cin.rdbuf();
+      if(input != "-")
+        {
+          f_in.open(std::filesystem::u8path(input),
+                    std::ios_base::in | std::ios_base::binary);
+          if(!f_in.is_open())
+            {
+              throw std::runtime_error("cannot open input file");
+            }
+          in_buf = f_in.rdbuf();
+        }
+
+      std::ofstream f_out;
+      std::streambuf *out_buf = std::cout.rdbuf();
+      if(output != "-")
+        {
+          f_out.open(std::filesystem::u8path(output),
+                     std::ios_base::out | std::ios_base::binary);
+          if(!f_out.is_open())
+            {
+              throw std::runtime_error("cannot open output file");
+            }
+          out_buf = f_out.rdbuf();
+        }
+
+      CountingStreamBuf in_cnt(in_buf);
+      CountingStreamBuf out_cnt(out_buf);
+      std::istream in_strm(&in_cnt);
+      std::ostream out_strm(&out_cnt);
+      if(encrypt)
+        {
+          spy->encryptStream(in_strm, out_strm, unm, pwd, options);
+        }
+      else
+        {
+          spy->decryptStream(in_strm, out_strm, unm, pwd, options);
+        }
+      printStats(in_cnt.count(), out_cnt.count());
+    }
+}
+
+void
+StirlitzCli::multiData(const bool &encrypt)
+{
+  if(input == "-" || output == "-" || in_place)
+    {
+      throw std::runtime_error("several recipients mode needs input and "
+                               "output files");
+    }
+  std::shared_ptr<gcry_sexp> key_pair = loadProfileKey("owk");
+
+  std::string unm;
+  std::string pwd;
+  credentials(unm, pwd);
+  ProfileStore store(spy, profile_dir);
+  StirlitzKeyring keyring(*spy);
+  store.loadKeyring(profile, keyring, unm, pwd);
+
+  std::filesystem::path source = std::filesystem::u8path(input);
+  std::filesystem::path result = std::filesystem::u8path(output);
+  if(encrypt)
+    {
+      std::vector<std::shared_ptr<gcry_sexp>> keys;
+      keys.push_back(key_pair);
+      for(auto it = recipients.begin(); it != recipients.end(); it++)
+        {
+          std::shared_ptr<gcry_sexp> key
+              = keyring.publicKey(spy->fromHex(*it));
+          if(!key)
+            {
+              throw std::runtime_error("recipient " + *it
+                                       + " is not found in keyring");
+            }
+          keys.push_back(key);
+        }
+      spy->encryptFileMulti(source, result, key_pair, keys, options);
+    }
+  else
+    {
+      std::string sender
+          = spy->decryptFileMulti(source, result, key_pair, options);
+      if(keyring.find(keyring.fingerprint(sender)) == nullptr
+         && spy->toHex(sender) != spy->getPublicKeyString(key_pair))
+        {
+          std::cerr << "stirlitz-cli: warning: sender is not in keyring ("
+                    << spy->toHex(keyring.fingerprint(sender)) << ")"
+                    << std::endl;
+        }
+    }
+  printStats(std::filesystem::file_size(source),
+             std::filesystem::file_size(result));
+}
+
+void
+StirlitzCli::text(const bool &encrypt)
+{
+  if(multi)
+    {
+      throw std::runtime_error("several recipients mode needs input and "
+                               "output files");
+    }
+  if(options.integrity)
+    {
+      throw std::runtime_error("integrity tags are available only for "
+                               "files");
+    }
+
+  std::string unm;
+  std::string pwd;
+  if(profile.empty())
+    {
+      credentials(unm, pwd);
+    }
+  else
+    {
+      profileCredentials(encrypt, unm, pwd);
+    }
+
+  std::string source = text_data;
+  if(source == "-")
+    {
+      source = std::string(std::istreambuf_iterator<char>(std::cin),
+                           std::istreambuf_iterator<char>());
+    }
+
+  std::string result;
+  if(encrypt)
+    {
+      if(options.armor)
+        {
+          std::string data = spy->encryptData(unm, pwd, source);
+          StirlitzArmor armor(StirlitzArmor::Encode, options.armor_encoding);
+          armor.update(reinterpret_cast<const unsigned char *>(data.c_str()),
+                       data.size(), result);
+          armor.finish(result);
+        }
+      else
+        {
+          result = spy->toHex(spy->encryptData(unm, pwd, source)) + "\n";
+        }
+    }
+  else
+    {
+      // Bare hexadecimal text and armored text are both accepted.
+      StirlitzArmor armor(StirlitzArmor::Decode,
+                          options.armor ? options.armor_encoding
+                                        : StirlitzArmor::Hex);
+      std::string data;
+      armor.update(reinterpret_cast<const unsigned char *>(source.c_str()),
+                   source.size(), data);
+      armor.finish(data);
+      result = spy->decryptData(unm, pwd, data);
+    }
+  std::cout.write(result.c_str(), result.size());
+  std::cout.flush();
+  printStats(source.size(), result.size());
+}
+
+void
+StirlitzCli::verify()
+{
+  if(input == "-" || multi)
+    {
+      throw std::runtime_error("verify needs input file encrypted for one "
+                               "recipient");
+    }
+
+  std::string unm;
+  std::string pwd;
+  if(profile.empty())
+    {
+      credentials(unm, pwd);
+    }
+  else
+    {
+      profileCredentials(false, unm, pwd);
+    }
+
+  std::filesystem::path source = std::filesystem::u8path(input);
+  std::vector<uint64_t> damaged;
+  if(single_part)
+    {
+      if(options.part_size == 0)
+        {
+          throw std::runtime_error("--part needs --parts");
+        }
+      damaged = spy->verifyFilePart(source, part, unm, pwd, options);
+    }
+  else
+    {
+      damaged = spy->verifyFile(source, unm, pwd, options);
+    }
+  for(auto it = damaged.begin(); it != damaged.end(); it++)
+    {
+      std::cout << "damaged frame: " << *it << "\n";
+    }
+  std::cout.flush();
+  printStats(std::filesystem::file_size(source), 0);
+  if(damaged.size() > 0)
+    {
+      throw std::runtime_error(std::to_string(damaged.size())
+                               + " damaged frame(s)");
+    }
+}
+
+void
+StirlitzCli::hash()
+{
+  int algo = gcry_md_map_name(hash_algo.c_str());
+  if(algo == 0)
+    {
+      throw std::runtime_error("unknown hash algorithm '" + hash_algo + "'");
+    }
+
+  std::vector<unsigned char> result;
+  uint64_t in_sz = 0;
+  if(input == "-")
+    {
+      if(leaf_size > 0)
+        {
+          throw std::runtime_error("tree hash needs input file");
+        }
+      StirlitzHash hsh(algo);
+      std::vector<char> buf(1048576);
+      while(std::cin.read(buf.data(), buf.size()) || std::cin.gcount() > 0)
+        {
+          hsh.update(reinterpret_cast<unsigned char *>(buf.data()),
+                     static_cast<size_t>(std::cin.gcount()));
+          in_sz += static_cast<uint64_t>(std::cin.gcount());
+        }
+      result = hsh.result();
+    }
+  else
+    {
+      std::filesystem::path source = std::filesystem::u8path(input);
+      if(leaf_size > 0)
+        {
+          result = spy->hashFileTree(source, algo, leaf_size, options);
+        }
+      else
+        {
+          result = spy->hashFile(source, algo, options);
+        }
+      in_sz = std::filesystem::file_size(source);
+    }
+  std::cout << spy->toHex(result) << "  " << input << std::endl;
+  printStats(in_sz, 0);
+}
+
+void
+StirlitzCli::keyGen()
+{
+  ProfileStore store(spy, profile_dir);
+  if(store.hasKey(profile, "owk"))
+    {
+      throw std::runtime_error("profile already has key pair");
+    }
+
+  std::shared_ptr<gcry_sexp> key_pair = spy->generateKeyPair();
+  saveProfileKey("owk", key_pair);
+  std::cout << spy->getPublicKeyString(key_pair) << std::endl;
+}
+
+void
+StirlitzCli::pubKey()
+{
+  std::cout << spy->getPublicKeyString(loadProfileKey("owk")) << std::endl;
+}
+
+void
+StirlitzCli::setKey()
+{
+  if(key.empty())
+    {
+      throw std::runtime_error("interlocutor's key is not set");
+    }
+  std::shared_ptr<gcry_sexp> other_key
+      = spy->generatePublicKeyExp(spy->fromHex(key));
+  saveProfileKey("otk", other_key);
+}
+
+void
+StirlitzCli::addPeer()
+{
+  if(key.empty())
+    {
+      throw std::runtime_error("interlocutor's key is not set");
+    }
+  std::string unm;
+  std::string pwd;
+  credentials(unm, pwd);
+
+  ProfileStore store(spy, profile_dir);
+  StirlitzKeyring keyring(*spy);
+  store.loadKeyring(profile, keyring, unm, pwd);
+  std::string fingerprint = keyring.add(spy->fromHex(key), peer_name);
+  store.saveKeyring(profile, keyring, unm, pwd);
+  std::cout << spy->toHex(fingerprint) << std::endl;
+}
+
+void
+StirlitzCli::peers()
+{
+  std::string unm;
+  std::string pwd;
+  credentials(unm, pwd);
+
+  ProfileStore store(spy, profile_dir);
+  StirlitzKeyring keyring(*spy);
+  store.loadKeyring(profile, keyring, unm, pwd);
+  const std::vector<StirlitzKeyring::Entry> &entries = keyring.entries();
+  for(auto it = entries.begin(); it != entries.end(); it++)
+    {
+      std::cout << spy->toHex(it->fingerprint) << " " << it->name << "\n";
+    }
+  std::cout.flush();
+}
+
+void
+StirlitzCli::credentials(std::string &username, std::string &password)
+{
+  username = this->username;
+  if(username.empty())
+    {
+      const char *env = std::getenv("STIRLITZ_USERNAME");
+      if(env)
+        {
+          username = env;
+        }
+    }
+  if(username.empty())
+    {
+      throw std::runtime_error("user name is not set");
+    }
+
+  if(!password_file.empty())
+    {
+      std::ifstream f(password_file, std::ios_base::in);
+      if(!f.is_open())
+        {
+          throw std::runtime_error("cannot open password file");
+        }
+      std::getline(f, password);
+      if(!password.empty() && password.back() == '\r')
+        {
+          password.pop_back();
+        }
+    }
+  else
+    {
+      const char *env = std::getenv("STIRLITZ_PASSWORD");
+      if(env)
+        {
+          password = env;
+        }
+    }
+  if(password.empty())
+    {
+      throw std::runtime_error("password is not set");
+    }
+}
+
+void
+StirlitzCli::profileCredentials(const bool &encrypt, std::string &username,
+                                std::string &password)
+{
+  std::shared_ptr<gcry_sexp> key_pair = loadProfileKey("owk");
+  std::shared_ptr<gcry_sexp> other_key;
+  if(peer.empty())
+    {
+      other_key = loadProfileKey("otk");
+    }
+  else
+    {
+      std::string unm;
+      std::string pwd;
+      credentials(unm, pwd);
+
+      ProfileStore store(spy, profile_dir);
+      StirlitzKeyring keyring(*spy);
+      store.loadKeyring(profile, keyring, unm, pwd);
+      other_key = keyring.publicKey(spy->fromHex(peer));
+      if(!other_key)
+        {
+          throw std::runtime_error("peer is not found in keyring");
+        }
+    }
+
+  std::tuple<std::string, std::string> pass_tup;
+  if(encrypt)
+    {
+      pass_tup = spy->genUsernamePasswordEncryption(key_pair, other_key);
+    }
+  else
+    {
+      pass_tup = spy->genUsernamePasswordDecryption(key_pair, other_key);
+    }
+  username = std::get<0>(pass_tup);
+  password = std::get<1>(pass_tup);
+}
+
+std::shared_ptr<gcry_sexp>
+StirlitzCli::loadProfileKey(const std::string &file_name)
+{
+  std::string unm;
+  std::string pwd;
+  credentials(unm, pwd);
+
+  ProfileStore store(spy, profile_dir);
+  return store.loadKey(profile, file_name, unm, pwd);
+}
+
+void
+StirlitzCli::saveProfileKey(const std::string &file_name,
+                            std::shared_ptr<gcry_sexp> key)
+{
+  std::string unm;
+  std::string pwd;
+  credentials(unm, pwd);
+
+  ProfileStore store(spy, profile_dir);
+  store.saveKey(profile, file_name, key, unm, pwd);
+}
+
+void
+StirlitzCli::printStats(const uint64_t &in, const uint64_t &out)
+{
+  if(!stats)
+    {
+      return void();
+    }
+  std::chrono::duration<double> elapsed
+      = std::chrono::steady_clock::now() - start;
+  double secs = elapsed.count();
+  double speed = 0.0;
+  if(secs > 0.0)
+    {
+      speed = static_cast<double>(in) / 1048576.0 / secs;
+    }
+
+  std::cerr.imbue(std::locale("C"));
+  std::cerr << std::fixed << std::setprecision(3) << "input: " << in
+            << " bytes\noutput: " << out << " bytes\ntime: " << secs
+            << " s\nspeed: " << speed << " MiB/s\nthreads: " << options.threads
+            << "\nframe size: " << options.frame_size << " bytes" << std::endl;
+}
+
+#ifdef __linux__
+void
+StirlitzCli::daemonRequest()
+{
+  std::unique_ptr<DaemonConnection> conn = DaemonConnection::connect(
+      socket_path.empty() ? DaemonConnection::defaultSocketPath()
+                          : socket_path);
+
+  DaemonMessage request;
+  request.name = profile;
+  request.threads = static_cast<uint32_t>(options.threads);
+  request.frame_size = static_cast<uint64_t>(options.frame_size);
+
+  uint64_t in_sz = 0;
+  switch(command)
+    {
+    case Command::Unlock:
+      {
+        std::string unm;
+        std::string pwd;
+        credentials(unm, pwd);
+        request.op = DaemonMessage::Unlock;
+        if(simple)
+          {
+            request.flags |= DaemonMessage::SimpleCredentials;
+          }
+        request.data = unm + std::string(1, '\0') + pwd;
+        break;
+      }
+    case Command::Lock:
+      {
+        request.op = DaemonMessage::Lock;
+        break;
+      }
+    case Command::Encrypt:
+    case Command::Decrypt:
+      {
+        if(profile.empty())
+          {
+            throw std::runtime_error("profile is not set");
+          }
+        if(in_place)
+          {
+            throw std::runtime_error("--in-place is not available with "
+                                     "--daemon");
+          }
+        if(!peer.empty() || multi)
+          {
+            throw std::runtime_error("keyring is not available with "
+                                     "--daemon");
+          }
+        if(options.integrity)
+          {
+            throw std::runtime_error("--integrity is not available with "
+                                     "--daemon");
+          }
+        if(options.armor)
+          {
+            throw std::runtime_error("--armor is not available with "
+                                     "--daemon");
+          }
+        if(options.sparse)
+          {
+            throw std::runtime_error("--sparse is not available with "
+                                     "--daemon");
+          }
+        if(options.part_size != 0)
+          {
+            throw std::runtime_error("--parts is not available with "
+                                     "--daemon");
+          }
+        if(options.durability != Stirlitz::FileOptions::NoSync)
+          {
+            throw std::runtime_error("--sync is not available with "
+                                     "--daemon");
+          }
+        if(options.memory_budget != 0)
+          {
+            throw std::runtime_error("--memory is not available with "
+                                     "--daemon (see stirlitzd --memory)");
+          }
+        if(command == Command::Encrypt)
+          {
+            request.op = DaemonMessage::Encrypt;
+          }
+        else
+          {
+            request.op = DaemonMessage::Decrypt;
+          }
+        if(text_mode)
+          {
+            request.flags |= DaemonMessage::Hex | DaemonMessage::WholeData;
+            if(text_data == "-")
+              {
+                request.setFd(payloadFd(in_sz));
+              }
+            else
+              {
+                request.data = text_data;
+                in_sz = text_data.size();
+              }
+          }
+        else
+          {
+            request.setFd(payloadFd(in_sz));
+          }
+        break;
+      }
+    default:
+      {
+        throw std::runtime_error("command is not available with --daemon");
+      }
+    }
+
+  conn->send(request);
+  DaemonMessage response;
+  if(!conn->receive(response))
+    {
+      throw std::runtime_error("stirlitzd has closed connection");
+    }
+  if(response.status != DaemonMessage::Ok)
+    {
+      throw std::runtime_error(response.data);
+    }
+
+  if(request.op == DaemonMessage::Encrypt
+     || request.op == DaemonMessage::Decrypt)
+    {
+      if(text_mode && request.op == DaemonMessage::Encrypt)
+        {
+          response.data += "\n";
+        }
+      uint64_t out_sz = writeResult(response.fd, response.data);
+      printStats(in_sz, out_sz);
+    }
+}
+
+int
+StirlitzCli::payloadFd(uint64_t &sz)
+{
+  int fd;
+  if(input != "-")
+    {
+      fd = ::open(std::filesystem::u8path(input).c_str(),
+                  O_RDONLY | O_CLOEXEC);
+      if(fd < 0)
+        {
+          throw std::runtime_error("cannot open input file");
+        }
+    }
+  else
+    {
+      fd = ::fcntl(0, F_DUPFD_CLOEXEC, 0);
+      if(fd < 0)
+        {
+          throw std::runtime_error("cannot open standard input");
+        }
+    }
+
+  struct stat st;
+  if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+      sz = static_cast<uint64_t>(st.st_size);
+      return fd;
+    }
+
+  // Pipes and terminals are copied to memfd.
+  int m_fd = ::memfd_create("stirlitz-cli", MFD_CLOEXEC);
+  if(m_fd < 0)
+    {
+      ::close(fd);
+      throw std::runtime_error("memfd_create: "
+                               + std::string(std::strerror(errno)));
+    }
+  FdStreamBuf out_buf(m_fd);
+  std::vector<char> buf(1048576);
+  sz = 0;
+  for(;;)
+    {
+      ssize_t rb = ::read(fd, buf.data(), buf.size());
+      if(rb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          ::close(fd);
+          ::close(m_fd);
+          throw std::runtime_error("input read error");
+        }
+      if(rb == 0)
+        {
+          break;
+        }
+      if(out_buf.sputn(buf.data(), rb) != rb)
+        {
+          ::close(fd);
+          ::close(m_fd);
+          throw std::runtime_error("memfd write error");
+        }
+      sz += static_cast<uint64_t>(rb);
+    }
+  ::close(fd);
+
+  return m_fd;
+}
+
+uint64_t
+StirlitzCli::writeResult(const int &fd, const std::string &data)
+{
+  std::ofstream f_out;
+  std::ostream *out = &std::cout;
+  if(output != "-")
+    {
+      f_out.open(std::filesystem::u8path(output),
+                 std::ios_base::out | std::ios_base::binary);
+      if(!f_out.is_open())
+        {
+          throw std::runtime_error("cannot open output file");
+        }
+      out = &f_out;
+    }
+
+  uint64_t result = 0;
+  if(fd >= 0)
+    {
+      FdStreamBuf in_buf(fd);
+      std::vector<char> buf(1048576);
+      for(;;)
+        {
+          std::streamsize rb = in_buf.sgetn(buf.data(), buf.size());
+          if(rb <= 0)
+            {
+              break;
+            }
+          out->write(buf.data(), rb);
+          result += static_cast<uint64_t>(rb);
+        }
+    }
+  else
+    {
+      out->write(data.c_str(), data.size());
+      result = data.size();
+    }
+  out->flush();
+  if(!out->good())
+    {
+      throw std::runtime_error("result write error");
+    }
+
+  return result;
+}
+#endif
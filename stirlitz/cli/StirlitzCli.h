@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZCLI_H
+#define STIRLITZCLI_H
+
+#include <Stirlitz.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+class StirlitzCli
+{
+public:
+  StirlitzCli();
+  ~StirlitzCli();
+
+  int
+  run(int argc, char *argv[]);
+
+private:
+  enum Command
+  {
+    NoCommand,
+    Encrypt,
+    Decrypt,
+    Verify,
+    Hash,
+    KeyGen,
+    PubKey,
+    SetKey,
+    AddPeer,
+    Peers,
+    Unlock,
+    Lock
+  };
+
+  bool
+  parseArgs(const std::vector<std::string> &args);
+
+  void
+  usage();
+
+  bool
+  parseSize(const std::string &val, size_t &result);
+
+  void
+  data(const bool &encrypt);
+
+  void
+  multiData(const bool &encrypt);
+
+  void
+  text(const bool &encrypt);
+
+  void
+  verify();
+
+  void
+  hash();
+
+  void
+  keyGen();
+
+  void
+  pubKey();
+
+  void
+  setKey();
+
+  void
+  addPeer();
+
+  void
+  peers();
+
+  void
+  credentials(std::string &username, std::string &password);
+
+  void
+  profileCredentials(const bool &encrypt, std::string &username,
+                     std::string &password);
+
+  std::shared_ptr<gcry_sexp>
+  loadProfileKey(const std::string &file_name);
+
+  void
+  saveProfileKey(const std::string &file_name, std::shared_ptr<gcry_sexp> key);
+
+  void
+  printStats(const uint64_t &in, const uint64_t &out);
+
+#ifdef __linux__
+  void
+  daemonRequest();
+
+  int
+  payloadFd(uint64_t &sz);
+
+  uint64_t
+  writeResult(const int &fd, const std::string &data);
+#endif
+
+  Stirlitz *spy = nullptr;
+
+  Command command = Command::NoCommand;
+  std::string input = "-";
+  std::string output = "-";
+  std::string text_data;
+  bool text_mode = false;
+  std::string profile;
+  std::filesystem::path profile_dir;
+  std::string username;
+  std::filesystem::path password_file;
+  std::string key;
+  std::string peer;
+  std::string peer_name;
+  std::vector<std::string> recipients;
+  bool multi = false;
+  std::string hash_algo = "SHA256";
+  size_t leaf_size = 0;
+  bool in_place = false;
+  size_t part = 0;
+  bool single_part = false;
+  bool stats = false;
+  bool help = false;
+  bool daemon = false;
+  bool simple = false;
+  std::filesystem::path socket_path;
+  Stirlitz::FileOptions options;
+
+  std::chrono::time_point<std::chrono::steady_clock> start;
+};
+
+#endif // STIRLITZCLI_H
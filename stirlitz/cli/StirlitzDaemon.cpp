@@ -0,0 +1,487 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <FdStreamBuf.h>
+#include <ProfileStore.h>
+#include <StirlitzDaemon.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h> // memfd_create
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+StirlitzDaemon::StirlitzDaemon(const std::filesystem::path &socket_path,
+                               const std::filesystem::path &profile_dir,
+                               const size_t &max_threads,
+                               const size_t &memory_budget)
+    : stopped(false)
+{
+  this->socket_path = socket_path;
+  this->profile_dir = profile_dir;
+  this->max_threads = max_threads == 0 ? 1 : max_threads;
+  this->memory_budget = memory_budget;
+  // Credentials of profiles are kept in secure memory too.
+  spy = new Stirlitz(262144);
+}
+
+StirlitzDaemon::~StirlitzDaemon()
+{
+  reapConnections(true);
+  profiles.clear();
+  if(listen_fd >= 0)
+    {
+      ::close(listen_fd);
+    }
+  delete spy;
+}
+
+void
+StirlitzDaemon::run()
+{
+  listenSocket();
+#ifndef __ANDROID__
+  std::cout << "stirlitzd: listening on " << socket_path << std::endl;
+#endif
+
+  while(!stopped.load())
+    {
+      int c_fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if(c_fd < 0)
+        {
+          if(stopped.load())
+            {
+              break;
+            }
+          if(errno == EINTR || errno == ECONNABORTED || errno == EMFILE
+             || errno == ENFILE)
+            {
+              continue;
+            }
+          throw std::runtime_error("StirlitzDaemon::run: "
+                                   + std::string(std::strerror(errno)));
+        }
+
+      // Only processes of the same user are served.
+      ucred cred;
+      socklen_t len = sizeof(cred);
+      if(::getsockopt(c_fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0
+         || cred.uid != ::getuid())
+        {
+          ::close(c_fd);
+          continue;
+        }
+
+      reapConnections(false);
+
+      std::lock_guard<std::mutex> lglock(connections_mtx);
+      connections.emplace_back();
+      Connection *connection = &connections.back();
+      connection->conn
+          = std::unique_ptr<DaemonConnection>(new DaemonConnection(c_fd));
+      connection->thr
+          = std::thread(&StirlitzDaemon::serve, this, connection);
+    }
+
+  reapConnections(true);
+  ::close(listen_fd);
+  listen_fd = -1;
+  std::filesystem::remove(socket_path);
+}
+
+void
+StirlitzDaemon::stop()
+{
+  // Can be called from signal handler.
+  stopped.store(true);
+  if(listen_fd >= 0)
+    {
+      ::shutdown(listen_fd, SHUT_RDWR);
+    }
+}
+
+void
+StirlitzDaemon::listenSocket()
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::string p = socket_path.string();
+  if(p.size() >= sizeof(addr.sun_path))
+    {
+      throw std::runtime_error(
+          "StirlitzDaemon::listenSocket: socket path is too long");
+    }
+  std::memcpy(addr.sun_path, p.c_str(), p.size());
+
+  // Stale socket of previous run is removed, any other file is kept.
+  std::error_code ec;
+  if(std::filesystem::is_socket(socket_path, ec))
+    {
+      std::filesystem::remove(socket_path, ec);
+    }
+  if(!socket_path.parent_path().empty())
+    {
+      std::filesystem::create_directories(socket_path.parent_path());
+    }
+
+  listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(listen_fd < 0)
+    {
+      throw std::runtime_error("StirlitzDaemon::listenSocket: "
+                               + std::string(std::strerror(errno)));
+    }
+
+  mode_t old_mask = ::umask(0177);
+  int rc = ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr),
+                  sizeof(addr));
+  ::umask(old_mask);
+  if(rc != 0 || ::listen(listen_fd, 64) != 0)
+    {
+      throw std::runtime_error("StirlitzDaemon::listenSocket: " + p + ": "
+                               + std::string(std::strerror(errno)));
+    }
+}
+
+void
+StirlitzDaemon::serve(Connection *connection)
+{
+  try
+    {
+      for(;;)
+        {
+          DaemonMessage request;
+          if(!connection->conn->receive(request))
+            {
+              break;
+            }
+
+          DaemonMessage response;
+          response.op = request.op;
+          try
+            {
+              handle(request, response);
+            }
+          catch(std::exception &er)
+            {
+              response.setFd(-1);
+              response.flags = 0;
+              response.status = DaemonMessage::Error;
+              response.data = er.what();
+            }
+          connection->conn->send(response);
+        }
+    }
+  catch(std::exception &er)
+    {
+#ifndef __ANDROID__
+      std::cout << "StirlitzDaemon::serve: " << er.what() << std::endl;
+#endif
+    }
+
+  std::lock_guard<std::mutex> lglock(connections_mtx);
+  connection->finished = true;
+}
+
+void
+StirlitzDaemon::handle(DaemonMessage &request, DaemonMessage &response)
+{
+  switch(request.op)
+    {
+    case DaemonMessage::Unlock:
+      {
+        unlock(request);
+        break;
+      }
+    case DaemonMessage::Lock:
+      {
+        lock(request);
+        break;
+      }
+    case DaemonMessage::Encrypt:
+    case DaemonMessage::Decrypt:
+      {
+        process(request, response);
+        break;
+      }
+    default:
+      {
+        throw std::runtime_error("unknown operation");
+      }
+    }
+}
+
+void
+StirlitzDaemon::unlock(DaemonMessage &request)
+{
+  if(request.name.empty())
+    {
+      throw std::runtime_error("profile is not set");
+    }
+  size_t pos = request.data.find('\0');
+  if(pos == std::string::npos)
+    {
+      throw std::runtime_error("incorrect credentials");
+    }
+  std::string username = request.data.substr(0, pos);
+  std::string password = request.data.substr(pos + 1);
+
+  Credentials cred;
+  if(request.flags & DaemonMessage::SimpleCredentials)
+    {
+      cred.enc_username
+          = std::unique_ptr<SecureString>(new SecureString(username));
+      cred.enc_password
+          = std::unique_ptr<SecureString>(new SecureString(password));
+      cred.dec_username
+          = std::unique_ptr<SecureString>(new SecureString(username));
+      cred.dec_password
+          = std::unique_ptr<SecureString>(new SecureString(password));
+    }
+  else
+    {
+      ProfileStore store(spy, profile_dir);
+      std::shared_ptr<gcry_sexp> key_pair
+          = store.loadKey(request.name, "owk", username, password);
+      std::shared_ptr<gcry_sexp> other_key
+          = store.loadKey(request.name, "otk", username, password);
+
+      std::tuple<std::string, std::string> pass_tup
+          = spy->genUsernamePasswordEncryption(key_pair, other_key);
+      cred.enc_username = std::unique_ptr<SecureString>(
+          new SecureString(std::get<0>(pass_tup)));
+      cred.enc_password = std::unique_ptr<SecureString>(
+          new SecureString(std::get<1>(pass_tup)));
+
+      pass_tup = spy->genUsernamePasswordDecryption(key_pair, other_key);
+      cred.dec_username = std::unique_ptr<SecureString>(
+          new SecureString(std::get<0>(pass_tup)));
+      cred.dec_password = std::unique_ptr<SecureString>(
+          new SecureString(std::get<1>(pass_tup)));
+    }
+
+  std::lock_guard<std::mutex> lglock(profiles_mtx);
+  profiles[request.name] = std::move(cred);
+}
+
+void
+StirlitzDaemon::lock(DaemonMessage &request)
+{
+  std::lock_guard<std::mutex> lglock(profiles_mtx);
+  if(request.name.empty())
+    {
+      profiles.clear();
+    }
+  else
+    {
+      profiles.erase(request.name);
+    }
+}
+
+void
+StirlitzDaemon::process(DaemonMessage &request, DaemonMessage &response)
+{
+  bool encrypt = request.op == DaemonMessage::Encrypt;
+  std::string username;
+  std::string password;
+  {
+    std::lock_guard<std::mutex> lglock(profiles_mtx);
+    auto it = profiles.find(request.name);
+    if(it == profiles.end())
+      {
+        throw std::runtime_error("profile is not unlocked");
+      }
+    if(encrypt)
+      {
+        username = it->second.enc_username->str();
+        password = it->second.enc_password->str();
+      }
+    else
+      {
+        username = it->second.dec_username->str();
+        password = it->second.dec_password->str();
+      }
+  }
+
+  Stirlitz::FileOptions options;
+  options.threads = std::min(
+      std::max(static_cast<size_t>(request.threads), static_cast<size_t>(1)),
+      max_threads);
+  options.frame_size = static_cast<size_t>(request.frame_size);
+  options.memory_budget = memory_budget;
+
+  bool whole = request.flags & (DaemonMessage::WholeData | DaemonMessage::Hex);
+  if(request.fd >= 0 && !whole)
+    {
+      processFd(request, response, username, password, options);
+      return void();
+    }
+
+  std::string source;
+  if(request.fd >= 0)
+    {
+      struct stat st;
+      if(::fstat(request.fd, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+          throw std::runtime_error(
+              "payload descriptor is not regular file or memfd");
+        }
+      source.resize(static_cast<size_t>(st.st_size));
+      FdStreamBuf buf(request.fd);
+      source.resize(
+          static_cast<size_t>(buf.sgetn(source.data(), source.size())));
+    }
+  else
+    {
+      source = request.data;
+    }
+
+  if(!encrypt && (request.flags & DaemonMessage::Hex))
+    {
+      source.erase(source.find_last_not_of(" \t\r\n") + 1);
+      source.erase(0, source.find_first_not_of(" \t\r\n"));
+      source = spy->fromHex(source);
+    }
+
+  std::string result;
+  if(request.flags & DaemonMessage::WholeData)
+    {
+      if(encrypt)
+        {
+          result = spy->encryptData(username, password, source);
+        }
+      else
+        {
+          result = spy->decryptData(username, password, source);
+        }
+    }
+  else
+    {
+      std::istringstream in(source);
+      std::ostringstream out;
+      if(encrypt)
+        {
+          spy->encryptStream(in, out, username, password, options);
+        }
+      else
+        {
+          spy->decryptStream(in, out, username, password, options);
+        }
+      result = out.str();
+    }
+
+  if(encrypt && (request.flags & DaemonMessage::Hex))
+    {
+      result = spy->toHex(result);
+    }
+
+  if(result.size() > DaemonConnection::inline_max)
+    {
+      int fd = ::memfd_create("stirlitzd", MFD_CLOEXEC);
+      if(fd < 0)
+        {
+          throw std::runtime_error("memfd_create: "
+                                   + std::string(std::strerror(errno)));
+        }
+      response.setFd(fd);
+      FdStreamBuf buf(fd);
+      if(buf.sputn(result.c_str(), result.size())
+         != static_cast<std::streamsize>(result.size()))
+        {
+          throw std::runtime_error("result write error");
+        }
+    }
+  else
+    {
+      response.data = result;
+    }
+}
+
+void
+StirlitzDaemon::processFd(DaemonMessage &request, DaemonMessage &response,
+                          const std::string &username,
+                          const std::string &password,
+                          const Stirlitz::FileOptions &options)
+{
+  struct stat st;
+  if(::fstat(request.fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      throw std::runtime_error(
+          "payload descriptor is not regular file or memfd");
+    }
+
+  int fd = ::memfd_create("stirlitzd", MFD_CLOEXEC);
+  if(fd < 0)
+    {
+      throw std::runtime_error("memfd_create: "
+                               + std::string(std::strerror(errno)));
+    }
+  response.setFd(fd);
+
+  // Payload is read directly to frame buffers and result is written from
+  // them, no intermediate copies are made.
+  FdStreamBuf in_buf(request.fd);
+  FdStreamBuf out_buf(fd);
+  std::istream in(&in_buf);
+  std::ostream out(&out_buf);
+  if(request.op == DaemonMessage::Encrypt)
+    {
+      spy->encryptStream(in, out, username, password, options);
+    }
+  else
+    {
+      spy->decryptStream(in, out, username, password, options);
+    }
+}
+
+void
+StirlitzDaemon::reapConnections(const bool &all)
+{
+  std::list<Connection> finished;
+  {
+    std::lock_guard<std::mutex> lglock(connections_mtx);
+    for(auto it = connections.begin(); it != connections.end();)
+      {
+        if(all || it->finished)
+          {
+            if(all)
+              {
+                it->conn->shutdown();
+              }
+            auto it_next = std::next(it);
+            finished.splice(finished.end(), connections, it);
+            it = it_next;
+          }
+        else
+          {
+            it++;
+          }
+      }
+  }
+
+  for(auto it = finished.begin(); it != finished.end(); it++)
+    {
+      if(it->thr.joinable())
+        {
+          it->thr.join();
+        }
+    }
+}
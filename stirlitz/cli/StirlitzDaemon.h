@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZDAEMON_H
+#define STIRLITZDAEMON_H
+
+#include <DaemonConnection.h>
+#include <SecureString.h>
+#include <Stirlitz.h>
+#include <atomic>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Local encryption service. Keeps libgcrypt initialized and keys of
+// unlocked profiles (derived user names and passwords) in secure memory, so
+// clients do not pay for initialization, key loading and ECDH on each call.
+// Each client connection is served by separate thread, large payloads are
+// passed as descriptors and mapped to memory.
+class StirlitzDaemon
+{
+public:
+  StirlitzDaemon(const std::filesystem::path &socket_path,
+                 const std::filesystem::path &profile_dir,
+                 const size_t &max_threads, const size_t &memory_budget);
+
+  ~StirlitzDaemon();
+
+  void
+  run();
+
+  void
+  stop();
+
+private:
+  struct Credentials
+  {
+    std::unique_ptr<SecureString> enc_username;
+    std::unique_ptr<SecureString> enc_password;
+    std::unique_ptr<SecureString> dec_username;
+    std::unique_ptr<SecureString> dec_password;
+  };
+
+  struct Connection
+  {
+    std::unique_ptr<DaemonConnection> conn;
+    std::thread thr;
+    bool finished = false;
+  };
+
+  void
+  listenSocket();
+
+  void
+  serve(Connection *connection);
+
+  void
+  handle(DaemonMessage &request, DaemonMessage &response);
+
+  void
+  unlock(DaemonMessage &request);
+
+  void
+  lock(DaemonMessage &request);
+
+  void
+  process(DaemonMessage &request, DaemonMessage &response);
+
+  void
+  processFd(DaemonMessage &request, DaemonMessage &response,
+            const std::string &username, const std::string &password,
+            const Stirlitz::FileOptions &options);
+
+  void
+  reapConnections(const bool &all);
+
+  Stirlitz *spy;
+  std::filesystem::path socket_path;
+  std::filesystem::path profile_dir;
+  size_t max_threads;
+  size_t memory_budget;
+
+  int listen_fd = -1;
+  std::atomic<bool> stopped;
+
+  std::mutex profiles_mtx;
+  std::unordered_map<std::string, Credentials> profiles;
+
+  std::mutex connections_mtx;
+  std::list<Connection> connections;
+};
+
+#endif // STIRLITZDAEMON_H
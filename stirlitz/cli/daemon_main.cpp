@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <DaemonConnection.h>
+#include <StirlitzDaemon.h>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static StirlitzDaemon *daemon_ptr = nullptr;
+
+static void
+stopDaemon(int sig)
+{
+  static_cast<void>(sig);
+  if(daemon_ptr)
+    {
+      daemon_ptr->stop();
+    }
+}
+
+static void
+usage()
+{
+  std::cout << "Usage: stirlitzd [OPTIONS]\n"
+               "\n"
+               "Local encryption service for stirlitz-cli --daemon and "
+               "other clients. Runs in\n"
+               "foreground, stops on SIGINT or SIGTERM.\n"
+               "\n"
+               "Options:\n"
+               "  -S, --socket PATH       socket path (default "
+               "$XDG_RUNTIME_DIR/stirlitzd.sock)\n"
+               "      --profile-dir PATH  profiles directory (default "
+               "~/.local/share/Stirlitz)\n"
+               "  -j, --max-threads N     maximum number of threads per "
+               "request (default 4)\n"
+               "  -m, --memory BYTES      memory budget of each request "
+               "(default no limit)\n"
+               "  -h, --help              print this help\n";
+}
+
+int
+main(int argc, char *argv[])
+{
+  std::filesystem::path socket_path;
+  std::filesystem::path profile_dir;
+  size_t max_threads = 4;
+  size_t memory_budget = 0;
+
+  std::vector<std::string> args;
+  for(int i = 1; i < argc; i++)
+    {
+      args.push_back(argv[i]);
+    }
+  for(size_t i = 0; i < args.size(); i++)
+    {
+      if(args[i] == "-h" || args[i] == "--help")
+        {
+          usage();
+          return 0;
+        }
+      if(i + 1 >= args.size())
+        {
+          std::cerr << "stirlitzd: incorrect argument '" << args[i] << "'"
+                    << std::endl;
+          return 2;
+        }
+      if(args[i] == "-S" || args[i] == "--socket")
+        {
+          socket_path = std::filesystem::u8path(args[++i]);
+        }
+      else if(args[i] == "--profile-dir")
+        {
+          profile_dir = std::filesystem::u8path(args[++i]);
+        }
+      else if(args[i] == "-j" || args[i] == "--max-threads")
+        {
+          try
+            {
+              max_threads = static_cast<size_t>(std::stoull(args[++i]));
+            }
+          catch(std::exception &er)
+            {
+              std::cerr << "stirlitzd: incorrect number of threads"
+                        << std::endl;
+              return 2;
+            }
+        }
+      else if(args[i] == "-m" || args[i] == "--memory")
+        {
+          try
+            {
+              memory_budget = static_cast<size_t>(std::stoull(args[++i]));
+            }
+          catch(std::exception &er)
+            {
+              std::cerr << "stirlitzd: incorrect memory budget" << std::endl;
+              return 2;
+            }
+        }
+      else
+        {
+          std::cerr << "stirlitzd: incorrect argument '" << args[i] << "'"
+                    << std::endl;
+          return 2;
+        }
+    }
+  if(socket_path.empty())
+    {
+      socket_path = DaemonConnection::defaultSocketPath();
+    }
+
+  try
+    {
+      StirlitzDaemon daemon(socket_path, profile_dir, max_threads,
+                            memory_budget);
+      daemon_ptr = &daemon;
+
+      struct sigaction act;
+      act.sa_handler = &stopDaemon;
+      sigemptyset(&act.sa_mask);
+      // No SA_RESTART: accept() is interrupted.
+      act.sa_flags = 0;
+      sigaction(SIGINT, &act, nullptr);
+      sigaction(SIGTERM, &act, nullptr);
+      signal(SIGPIPE, SIG_IGN);
+
+      daemon.run();
+      daemon_ptr = nullptr;
+    }
+  catch(std::exception &er)
+    {
+      daemon_ptr = nullptr;
+      std::cerr << "stirlitzd: " << er.what() << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
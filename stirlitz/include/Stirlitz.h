@@ -16,12 +16,32 @@
 #ifndef STIRLITZ_H
 #define STIRLITZ_H
 
+#include <StirlitzArmor.h>
+#include <StirlitzJob.h>
+#include <StirlitzKey.h>
+#include <StirlitzSessionKey.h>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <gcrypt.h>
+#include <istream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
+class BufferPool;
+class FileIO;
+class HoleMap;
+class JobPool;
+class PartSet;
+class ResultFile;
+class StirlitzStream;
+
 /*!
  * \mainpage Stirlitz
  *
@@ -42,15 +62,263 @@
  * \brief The Stirlitz class
  *
  * Base class of Stirlitz library.
+ *
+ * All public methods are thread-safe: one Stirlitz object can be shared
+ * between any number of threads and its methods can be called concurrently.
+ * Cipher handles are not opened and closed on each call, they are taken from
+ * internal pool shared by all threads and returned to it after operation. Frame buffers of file operations are
+ * reused too: they are not zero-filled on each call and are wiped when
+ * operation is finished.
  */
 class Stirlitz
 {
 public:
+  /*!
+   * \brief Options of file encryption and decryption.
+   */
+  struct FileOptions
+  {
+    /*!
+     * \brief File I/O backends.
+     */
+    enum IOBackend
+    {
+      /*!
+       * Synchronous reads and writes (default).
+       */
+      Sync,
+      /*!
+       * Asynchronous I/O by io_uring. Several chunks of file are kept in
+       * flight ahead of cipher. Available only on Linux if library has been
+       * built with liburing, Sync backend is used otherwise.
+       */
+      IOUring
+    };
+
+    /*!
+     * \brief Durability policies of resulting files.
+     */
+    enum Durability
+    {
+      /*!
+       * Resulting file is not flushed to storage (default). Crash shortly
+       * after operation can lose result.
+       */
+      NoSync,
+      /*!
+       * Resulting file is flushed to storage (fsync) before it replaces
+       * previous file, then its directory is flushed.
+       */
+      SyncFile,
+      /*!
+       * Group commit: writeback of resulting file is started, but file
+       * replaces previous one only when commitFiles() is called. All files of
+       * batch are flushed together, then renamed, then their directories are
+       * flushed once, so crash safety of many files costs about one fsync.
+       * Until then file is kept as hidden temporary file ".<name>.<hex>.tmp"
+       * next to result. If process is terminated before commitFiles() call,
+       * such files remain and nothing removes them: they contain complete
+       * results and can be renamed or deleted manually.
+       */
+      SyncBatch
+    };
+
+    /*!
+     * \brief Read and write files bypassing page cache.
+     *
+     * If set to true, source and resulting files are opened with O_DIRECT
+     * flag and all I/O is carried out by block aligned chunks, so encryption
+     * of huge files does not evict other data from page cache. Unaligned tail
+     * of resulting file is written in buffered mode. If file system does not
+     * support O_DIRECT, files are processed through page cache.
+     *
+     * \note Has effect only on Linux. Ignored on other platforms.
+     */
+    bool direct_io = false;
+
+    /*!
+     * \brief I/O backend to be used.
+     */
+    IOBackend io_backend = IOBackend::Sync;
+
+    /*!
+     * \brief Number of 2 MiB chunks kept in flight by IOUring backend.
+     */
+    size_t io_queue_depth = 8;
+
+    /*!
+     * \brief Preallocate resulting file.
+     *
+     * If set to true, exact size of resulting file is allocated before
+     * writing (fallocate), so resulting file is not fragmented and lack of
+     * free space is detected before operation begins.
+     *
+     * \note Has effect only on Linux.
+     */
+    bool preallocate = true;
+
+    /*!
+     * \brief Number of threads processing frames.
+     *
+     * Frames of file are independent from each other, so they can be
+     * encrypted (decrypted) in parallel. If value is greater than 1, source is
+     * read and result is written by separate threads, frames are processed by
+     * given number of worker threads and up to 2 * threads frames are kept in
+     * memory. Result does not depend on number of threads.
+     */
+    size_t threads = 1;
+
+    /*!
+     * \brief Size of encrypted frame in bytes.
+     *
+     * Source is encrypted by independent frames. Each encrypted frame is 16
+     * bytes larger than corresponding part of source. Data encrypted with
+     * non-default frame size can be decrypted only with the same frame size.
+     * Must be at least 32 bytes.
+     */
+    size_t frame_size = 10485760;
+
+    /*!
+     * \brief Add integrity tag to each encrypted frame.
+     *
+     * If set to true, 16 bytes tag (HMAC-SHA256 of frame number and
+     * encrypted frame, truncated) is stored after each encrypted frame and
+     * short trailer containing number of frames is added at the end of
+     * file. Damaged frames are detected by decryption (operation fails) and
+     * can be found without decryption by verifyFile(). Data encrypted with
+     * tags can be decrypted only with this option set to true: file
+     * decryption checks keyed trailer and fails if option does not match
+     * file. Tags can be checked only for files, decryptStream() and in-place
+     * methods do not support this option.
+     */
+    bool integrity = false;
+
+    /*!
+     * \brief Write (read) encrypted data as armored text.
+     *
+     * If set to true, encrypted data is converted to text by StirlitzArmor
+     * (header, lines of 64 characters, trailer) while it is written, and
+     * armored (or bare hexadecimal/Base64) text is converted back while it is
+     * read, so encrypted files can be sent through text-only channels.
+     * Truncated armored text is detected by decryption. Armor can not be used
+     * together with integrity tags, in-place and multi-recipient methods.
+     */
+    bool armor = false;
+
+    /*!
+     * \brief Encoding of armored text.
+     *
+     * Used for encryption. Decryption takes encoding from header of text and
+     * uses this value only for text without header.
+     */
+    StirlitzArmor::Encoding armor_encoding = StirlitzArmor::Base64;
+
+    /*!
+     * \brief Limit of memory used by file operation buffers in bytes.
+     *
+     * If value is not 0, frames in flight, worker threads and io_uring
+     * chunks are reduced so buffers of operation (frames, I/O and armor
+     * buffers) do not exceed given size (for example 8 MiB on mobile
+     * devices). Frame buffers kept for reuse after operation do not exceed
+     * it either. Frame size is not changed: operation fails if budget is
+     * less than single frame and fixed buffers (error names them and
+     * minimal budget), smaller frame_size must be set for such budgets.
+     * 0 means no limit (default).
+     */
+    size_t memory_budget = 0;
+
+    /*!
+     * \brief Durability of resulting file.
+     *
+     * Result is always written to temporary file in the same directory and
+     * replaces previous file by atomic rename only when operation succeeds,
+     * so failed or interrupted operation never leaves truncated file in place
+     * of previous one. This option defines if data is flushed to storage
+     * before rename (see Durability).
+     *
+     * \note Has no effect on in-place and stream methods.
+     */
+    Durability durability = Durability::NoSync;
+
+    /*!
+     * \brief Encrypt holes and zero frames of source compactly.
+     *
+     * If set to true, holes of sparse source file (found by SEEK_DATA where
+     * it is supported) are not read and frames consisting of zeros are not
+     * encrypted: each run of them is stored as its length with keyed tag (25
+     * bytes), other frames are stored with 5 bytes header. Encrypted data
+     * starts with 16 bytes marker "STIRLITZ SPARSE1" and ends with 25 bytes
+     * record holding tagged total size, so forged, moved or dropped records
+     * are detected (content of data frames is not authenticated, as without
+     * integrity tags). Frame size can not exceed 4 GiB. Decryption recreates
+     * zero runs as holes (only for regular files with Sync backend and
+     * without direct_io, zeros are written otherwise). Data encrypted with
+     * this option can be decrypted only with this option set to true,
+     * decryption fails if option does not match marker.
+     *
+     * \warning Positions and lengths of zero runs are not hidden by
+     * encryption.
+     *
+     * \note Can not be used together with integrity tags, in-place and
+     * multi-recipient methods.
+     */
+    bool sparse = false;
+
+    /*!
+     * \brief Split encrypted file into parts of given size in bytes.
+     *
+     * If value is not 0, encryptFile() writes encrypted data to part files
+     * not larger than given size (named as result with ".0000", ".0001"...
+     * suffixes) and small text manifest listing them to result path. Parts
+     * are split at frame boundaries and last part holds integrity trailer,
+     * so concatenation of parts is ordinary encrypted file. Parts can be
+     * produced, verified and decrypted independently (see encryptFilePart(),
+     * verifyFilePart() and decryptFilePart()). For decryptFile() and
+     * verifyFile() any non-zero value means that source is manifest, layout
+     * of parts is taken from it. Value must be at least frame_size + 16
+     * bytes (plus 40 bytes if integrity tags are used).
+     *
+     * \note Can not be used together with armor, sparse files and
+     * multi-recipient methods. Ignored by in-place and stream methods.
+     */
+    uint64_t part_size = 0;
+
+    /*!
+     * \brief Batch of resulting file with SyncBatch durability.
+     *
+     * Token returned by newBatch(). Files of batch are committed only by
+     * commitFiles() call with the same token, so threads sharing Stirlitz
+     * object do not commit files of each other. 0 is default batch.
+     */
+    uint64_t batch = 0;
+  };
+
   /*!
    * \brief Stirlitz constructor
    */
   Stirlitz();
 
+  /*!
+   * \brief Stirlitz constructor.
+   *
+   * Initializes libgcrypt (if it has not been initialized yet) with given
+   * size of secure memory pool. Each cipher handle kept in pool of Stirlitz
+   * object takes about 2 KiB of secure memory, so for N concurrent jobs pool
+   * of about 16 KiB + N * 4 KiB is enough and no auto expansions will be
+   * needed. Default constructor uses 32768 bytes.
+   *
+   * \note Secure memory size has effect only for first Stirlitz object
+   * created in process.
+   *
+   * \param secmem_size Secure memory pool size in bytes.
+   */
+  Stirlitz(const size_t &secmem_size);
+
+  /*!
+   * \brief Stirlitz destructor.
+   */
+  ~Stirlitz();
+
   /*!
    * \brief Calculates hash summ for given string.
    *
@@ -66,6 +334,66 @@ public:
   std::vector<unsigned char>
   hashString(const std::string &data, const int &algo);
 
+  /*!
+   * \brief Calculates hash summ of given file.
+   *
+   * File is read by parts, so files of any size can be processed. Result is
+   * the same as result of hashString() for whole content of file.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file.
+   * \param algo Hash algorithm (see hashString()).
+   * \return Vector containing hash summ.
+   */
+  std::vector<unsigned char>
+  hashFile(const std::filesystem::path &source_file, const int &algo);
+
+  /*!
+   * \brief Calculates hash summ of given file.
+   *
+   * Same as hashFile(), but with additional options. FileOptions::frame_size
+   * is used as size of read part. If FileOptions::threads is greater than 1,
+   * file is read by separate thread, so reading and hashing are overlapped.
+   * FileOptions::preallocate and FileOptions::integrity are ignored.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file.
+   * \param algo Hash algorithm (see hashString()).
+   * \param options File operation options.
+   * \return Vector containing hash summ.
+   */
+  std::vector<unsigned char>
+  hashFile(const std::filesystem::path &source_file, const int &algo,
+           const FileOptions &options);
+
+  /*!
+   * \brief Calculates tree hash summ of given file.
+   *
+   * File is divided into leaves of leaf_size bytes (last leaf can be
+   * shorter). Hash summ of each leaf is calculated as hash of byte 0x00 and
+   * leaf content. Leaves are hashed in parallel by FileOptions::threads
+   * threads. Resulting hash summ is hash of byte 0x01, leaf size and file
+   * size (8 bytes each, little endian) and hash summs of all leaves in file
+   * order.
+   *
+   * Result depends on algorithm and leaf size, but does not depend on number
+   * of threads. It differs from result of hashFile(), so both sides must use
+   * the same method.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file.
+   * \param algo Hash algorithm (see hashString()).
+   * \param leaf_size Size of leaf in bytes (must not be 0).
+   * \param options File operation options.
+   * \return Vector containing hash summ.
+   */
+  std::vector<unsigned char>
+  hashFileTree(const std::filesystem::path &source_file, const int &algo,
+               const size_t &leaf_size, const FileOptions &options);
+
   /*!
    * \brief Converts given data to hexadecimal format.
    * \param data Data to be converted. Can be std::string or
@@ -128,6 +456,78 @@ public:
   decryptData(const std::string &username, const std::string &password,
               const std::string &data);
 
+  /*!
+   * \brief Encrypts given data.
+   *
+   * Same as encryptData(), but reads data from and writes result to caller's
+   * buffers directly, no intermediate copies of data are made. Result is the
+   * same as result of encryptData().
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param username User name.
+   * \param password Password.
+   * \param data Pointer to data to be encrypted.
+   * \param data_sz Size of data in bytes.
+   * \param result Pointer to buffer result to be written to. Buffer size must
+   * be at least data_sz + 16 bytes. Buffer must not overlap data.
+   */
+  void
+  encryptData(const std::string &username, const std::string &password,
+              const unsigned char *data, const size_t &data_sz,
+              unsigned char *result);
+
+  /*!
+   * \brief Decrypts given data.
+   *
+   * Same as decryptData(), but reads data from and writes result to caller's
+   * buffers directly, no intermediate copies of data are made.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param username User name.
+   * \param password Password.
+   * \param data Pointer to data to be decrypted.
+   * \param data_sz Size of data in bytes.
+   * \param result Pointer to buffer result to be written to. Buffer size must
+   * be at least data_sz - 16 bytes. Buffer must not overlap data.
+   * \return Size of decrypted data (0 if data_sz is less than 16).
+   */
+  size_t
+  decryptData(const std::string &username, const std::string &password,
+              const unsigned char *data, const size_t &data_sz,
+              unsigned char *result);
+
+  /*!
+   * \brief Encrypts given data.
+   *
+   * Same as encryptData(), but key is not derived from user name and
+   * password on each call.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param key Session key.
+   * \param data Data to be encrypted.
+   * \return std::string containing encrypted data.
+   */
+  std::string
+  encryptData(const StirlitzSessionKey &key, const std::string &data);
+
+  /*!
+   * \brief Decrypts given data.
+   *
+   * Same as decryptData(), but key is not derived from user name and
+   * password on each call.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param key Session key.
+   * \param data Data to be decrypted.
+   * \return std::string containing decrypted data.
+   */
+  std::string
+  decryptData(const StirlitzSessionKey &key, const std::string &data);
+
   /*!
    * \brief Encrypts given file.
    *
@@ -143,6 +543,24 @@ public:
               const std::filesystem::path &result, const std::string &username,
               const std::string &password);
 
+  /*!
+   * \brief Encrypts given file.
+   *
+   * Same as encryptFile(), but with additional options.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to file result of encryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  encryptFile(const std::filesystem::path &source_file,
+              const std::filesystem::path &result, const std::string &username,
+              const std::string &password, const FileOptions &options);
+
   /*!
    * \brief Decrypts given file.
    *
@@ -158,6 +576,650 @@ public:
               const std::filesystem::path &result, const std::string &username,
               const std::string &password);
 
+  /*!
+   * \brief Decrypts given file.
+   *
+   * Same as decryptFile(), but with additional options.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  decryptFile(const std::filesystem::path &source_file,
+              const std::filesystem::path &result, const std::string &username,
+              const std::string &password, const FileOptions &options);
+
+  /*!
+   * \brief Encrypts data from stream.
+   *
+   * Reads source stream up to the end and writes encrypted data to result
+   * stream. Result has the same format as result of encryptFile(), so
+   * streams and files can be encrypted and decrypted interchangeably. Can be
+   * used for pipes, standard input and output etc. Streams must be opened in
+   * binary mode.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source Stream to be encrypted.
+   * \param result Stream result of encryption to be written to.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  encryptStream(std::istream &source, std::ostream &result,
+                const std::string &username, const std::string &password);
+
+  /*!
+   * \brief Encrypts data from stream.
+   *
+   * Same as encryptStream(), but with additional options. Only
+   * FileOptions::threads and FileOptions::frame_size are taken into account.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source Stream to be encrypted.
+   * \param result Stream result of encryption to be written to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  encryptStream(std::istream &source, std::ostream &result,
+                const std::string &username, const std::string &password,
+                const FileOptions &options);
+
+  /*!
+   * \brief Decrypts data from stream.
+   *
+   * Reads source stream up to the end and writes decrypted data to result
+   * stream. Streams must be opened in binary mode.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source Stream to be decrypted.
+   * \param result Stream result of decryption to be written to.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  decryptStream(std::istream &source, std::ostream &result,
+                const std::string &username, const std::string &password);
+
+  /*!
+   * \brief Decrypts data from stream.
+   *
+   * Same as decryptStream(), but with additional options. Only
+   * FileOptions::threads and FileOptions::frame_size are taken into account.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source Stream to be decrypted.
+   * \param result Stream result of decryption to be written to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  decryptStream(std::istream &source, std::ostream &result,
+                const std::string &username, const std::string &password,
+                const FileOptions &options);
+
+  /*!
+   * \brief Encrypts given file in place.
+   *
+   * Encrypts file into itself, so no free space for second copy of data is
+   * needed (file grows by 16 bytes for each frame). File is resized
+   * once and then processed from end to beginning, so encrypted data never
+   * overwrites data which has not been read yet. Result is the same as
+   * result of encryptFile() and can be decrypted by decryptFile() or
+   * decryptFileInPlace().
+   *
+   * \warning If operation is interrupted (error, power loss etc.), file
+   * becomes damaged.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param file Path to file to be encrypted.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  encryptFileInPlace(const std::filesystem::path &file,
+                     const std::string &username, const std::string &password);
+
+  /*!
+   * \brief Encrypts given file in place.
+   *
+   * Same as encryptFileInPlace(), but with additional options. Only
+   * FileOptions::frame_size is taken into account.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param file Path to file to be encrypted.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  encryptFileInPlace(const std::filesystem::path &file,
+                     const std::string &username, const std::string &password,
+                     const FileOptions &options);
+
+  /*!
+   * \brief Decrypts given file in place.
+   *
+   * Decrypts file into itself. File is processed from beginning to end and
+   * truncated to size of decrypted data after all.
+   *
+   * \warning If operation is interrupted (error, power loss etc.), file
+   * becomes damaged.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param file Path to file to be decrypted.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  decryptFileInPlace(const std::filesystem::path &file,
+                     const std::string &username, const std::string &password);
+
+  /*!
+   * \brief Decrypts given file in place.
+   *
+   * Same as decryptFileInPlace(), but with additional options. Only
+   * FileOptions::frame_size is taken into account.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param file Path to file to be decrypted.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   */
+  void
+  decryptFileInPlace(const std::filesystem::path &file,
+                     const std::string &username, const std::string &password,
+                     const FileOptions &options);
+
+  /*!
+   * \brief Checks integrity tags of file without decryption.
+   *
+   * File must be encrypted with FileOptions::integrity set to true and with
+   * the same frame size. Frames are checked by FileOptions::threads threads,
+   * no decrypted data is written. Encrypted frame k occupies bytes from k *
+   * (frame_size + 16) to (k + 1) * (frame_size + 16) of file (last frame can
+   * be shorter), so only damaged ranges can be transferred again.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be checked.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \return Sorted numbers of damaged frames (empty vector if file is
+   * intact). Number equal to total number of frames means that end of file
+   * is damaged (file has been truncated or extended).
+   */
+  std::vector<uint64_t>
+  verifyFile(const std::filesystem::path &source_file,
+             const std::string &username, const std::string &password,
+             const FileOptions &options);
+
+  /*!
+   * \brief Encrypts single part of file split into parts.
+   *
+   * Writes part number part of result (see FileOptions::part_size, which must
+   * not be 0) and manifest. Part does not depend on other parts, so parts can
+   * be encrypted concurrently (even by different processes) and damaged
+   * part can be encrypted again. Manifest written by each call is the same.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to manifest.
+   * \param part Number of part (from 0).
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \return Number of parts.
+   */
+  uint64_t
+  encryptFilePart(const std::filesystem::path &source_file,
+                  const std::filesystem::path &result, const uint64_t &part,
+                  const std::string &username, const std::string &password,
+                  const FileOptions &options);
+
+  /*!
+   * \brief Decrypts single part of file split into parts.
+   *
+   * Decrypted part is saved to result. Pieces of source decrypted from all
+   * parts in order of their numbers form source file, so parts can be
+   * decrypted concurrently.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to manifest.
+   * \param result Path to file decrypted part to be saved to.
+   * \param part Number of part (from 0).
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \return Offset of decrypted piece in source file.
+   */
+  uint64_t
+  decryptFilePart(const std::filesystem::path &source_file,
+                  const std::filesystem::path &result, const uint64_t &part,
+                  const std::string &username, const std::string &password,
+                  const FileOptions &options);
+
+  /*!
+   * \brief Checks integrity tags of single part of file split into parts.
+   *
+   * See verifyFile(). Frames are numbered from the start of whole file. Part
+   * of incorrect size is reported as damaged entirely.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to manifest.
+   * \param part Number of part (from 0).
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \return Sorted numbers of damaged frames.
+   */
+  std::vector<uint64_t>
+  verifyFilePart(const std::filesystem::path &source_file,
+                 const uint64_t &part, const std::string &username,
+                 const std::string &password, const FileOptions &options);
+
+  /*!
+   * \brief Returns number of parts listed in manifest.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param manifest Path to manifest of file split into parts.
+   */
+  uint64_t
+  partCount(const std::filesystem::path &manifest);
+
+  /*!
+   * \brief Encrypts given file for several recipients.
+   *
+   * File content is encrypted only once by random data key. Data key is
+   * wrapped (AES key wrap) for each recipient by key derived from your key
+   * pair and recipient public key (same way as in
+   * genUsernamePasswordEncryption()) and stored in file header together with
+   * recipient key fingerprint and your public key. Each recipient adds 72
+   * bytes to header. To be able to decrypt file yourself, add your own key to
+   * recipients.
+   *
+   * Resulting file can be decrypted only by decryptFileMulti().
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to file result of encryption to be saved to.
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param recipients Smart pointers to recipients public key S-expression
+   * objects (up to 65535 keys).
+   * \param options File operation options.
+   */
+  void
+  encryptFileMulti(const std::filesystem::path &source_file,
+                   const std::filesystem::path &result,
+                   std::shared_ptr<gcry_sexp> own_key_pair,
+                   const std::vector<std::shared_ptr<gcry_sexp>> &recipients,
+                   const FileOptions &options);
+
+  /*!
+   * \brief Decrypts file encrypted by encryptFileMulti().
+   *
+   * Frame size and presence of integrity tags are taken from file header,
+   * FileOptions::frame_size and FileOptions::integrity are ignored.
+   *
+   * \note This method can throw std::exception in case of errors (including
+   * case, when file has not been encrypted for given key).
+   *
+   * \param source_file Path to file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param options File operation options.
+   * \return Raw public key of sender (32 bytes). It can be checked against
+   * known keys (see StirlitzKeyring).
+   */
+  std::string
+  decryptFileMulti(const std::filesystem::path &source_file,
+                   const std::filesystem::path &result,
+                   std::shared_ptr<gcry_sexp> own_key_pair,
+                   const FileOptions &options);
+
+  /*!
+   * \brief Creates new batch of files with SyncBatch durability.
+   *
+   * \return Token to be set to FileOptions::batch and passed to
+   * commitFiles(). Tokens are unique for Stirlitz object and never equal to
+   * 0.
+   */
+  uint64_t
+  newBatch();
+
+  /*!
+   * \brief Commits resulting files of default batch.
+   *
+   * Same as commitFiles(0).
+   *
+   * \note This method throws std::exception in case of errors.
+   */
+  void
+  commitFiles();
+
+  /*!
+   * \brief Commits resulting files of operations with SyncBatch durability.
+   *
+   * Flushes all files written with FileOptions::SyncBatch durability and
+   * given FileOptions::batch since previous call, replaces previous files by
+   * them and flushes their directories. Files of other batches are not
+   * touched. Files which could not be flushed are removed, other files are
+   * committed anyway. Pending files of all batches are committed by
+   * destructor too, but errors can be reported only by this method. Files of
+   * process terminated before commit remain as hidden temporary files (see
+   * FileOptions::SyncBatch).
+   *
+   * \note This method throws std::exception in case of errors.
+   *
+   * \param batch Token returned by newBatch() or 0 for default batch.
+   */
+  void
+  commitFiles(const uint64_t &batch);
+
+  /*!
+   * \brief Sets number of threads of pool executing asynchronous jobs.
+   *
+   * Pool is created on first call of any "Async" method. By default it has
+   * as many threads as there are hardware threads in system. Each job with
+   * FileOptions::threads greater than 1 uses additional threads for frame
+   * processing, so for many simultaneous jobs it is reasonable to keep
+   * FileOptions::threads equal to 1 and let pool use all cores.
+   *
+   * \note This method throws std::exception if pool has already been created.
+   *
+   * \param threads Number of threads (0 means number of hardware threads).
+   */
+  void
+  setJobThreads(const size_t &threads);
+
+  /*!
+   * \brief Encrypts given file asynchronously.
+   *
+   * Same as encryptFile(), but operation is executed by thread pool of
+   * Stirlitz object (see setJobThreads()). Encryption key is derived before
+   * method returns, credentials are not kept by job. Jobs which have not been
+   * finished before Stirlitz object destruction are cancelled.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to file result of encryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  encryptFileAsync(const std::filesystem::path &source_file,
+                   const std::filesystem::path &result,
+                   const std::string &username, const std::string &password,
+                   const FileOptions &options,
+                   const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Decrypts given file asynchronously.
+   *
+   * Same as decryptFile(), but operation is executed by thread pool of
+   * Stirlitz object (see encryptFileAsync()).
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param options File operation options.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  decryptFileAsync(const std::filesystem::path &source_file,
+                   const std::filesystem::path &result,
+                   const std::string &username, const std::string &password,
+                   const FileOptions &options,
+                   const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Encrypts given data asynchronously.
+   *
+   * Same as encryptData(), but operation is executed by thread pool of
+   * Stirlitz object (see encryptFileAsync()). Data is processed by 1 MiB
+   * parts, so job reports progress and can be cancelled. Result can be
+   * obtained by StirlitzJob::result().
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param username User name.
+   * \param password Password.
+   * \param data Data to be encrypted (pass by std::move() to avoid copy).
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  encryptDataAsync(const std::string &username, const std::string &password,
+                   std::string data, const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Decrypts given data asynchronously.
+   *
+   * Same as decryptData(), but operation is executed by thread pool of
+   * Stirlitz object (see encryptDataAsync()).
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param username User name.
+   * \param password Password.
+   * \param data Data to be decrypted (pass by std::move() to avoid copy).
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  decryptDataAsync(const std::string &username, const std::string &password,
+                   std::string data, const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Encrypts data for interlocutor asynchronously.
+   *
+   * Same as encryptDataAsync(), but username and password are generated by
+   * genUsernamePasswordEncryption() and data is obtained by calling given
+   * function. Both are done in thread of pool, so large data (for example
+   * text of widget) does not block calling thread.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param other_key Smart pointer to interlocutor's public key S-expression
+   * object.
+   * \param data Function returning data to be encrypted. It is called once
+   * from thread of pool.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  encryptDataAsync(std::shared_ptr<gcry_sexp> own_key_pair,
+                   std::shared_ptr<gcry_sexp> other_key,
+                   std::function<std::string()> data,
+                   const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Decrypts hexadecimal or armored text from interlocutor
+   * asynchronously.
+   *
+   * Text is obtained by calling given function, decoded (armored text or
+   * bare hexadecimal text, see StirlitzArmor) and decrypted by username and
+   * password generated by genUsernamePasswordDecryption(). All steps are done
+   * in thread of pool (see encryptDataAsync()).
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param other_key Smart pointer to interlocutor's public key S-expression
+   * object.
+   * \param text Function returning text to be decrypted. It is called once
+   * from thread of pool.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  decryptTextAsync(std::shared_ptr<gcry_sexp> own_key_pair,
+                   std::shared_ptr<gcry_sexp> other_key,
+                   std::function<std::string()> text,
+                   const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Encrypts given file to text file.
+   *
+   * Result is the same as result of encryptData() for whole content of file
+   * converted by toHex(), so it can be decrypted by decryptData() and vice
+   * versa. File is processed by parts, memory usage does not depend on file
+   * size.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to text file result of encryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  encryptFileToText(const std::filesystem::path &source_file,
+                    const std::filesystem::path &result,
+                    const std::string &username, const std::string &password);
+
+  /*!
+   * \brief Decrypts text file.
+   *
+   * Reverse operation to encryptFileToText(). Whitespace characters of text
+   * file are ignored. Armored text (see StirlitzArmor) is accepted too. File
+   * is processed by parts, memory usage does not depend on file size.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to text file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  decryptFileFromText(const std::filesystem::path &source_file,
+                      const std::filesystem::path &result,
+                      const std::string &username,
+                      const std::string &password);
+
+  /*!
+   * \brief Encrypts given file to text file asynchronously.
+   *
+   * Same as encryptFileToText(), but operation is executed by thread pool of
+   * Stirlitz object (see encryptFileAsync()).
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to text file result of encryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  encryptFileToTextAsync(const std::filesystem::path &source_file,
+                         const std::filesystem::path &result,
+                         const std::string &username,
+                         const std::string &password,
+                         const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Decrypts text file asynchronously.
+   *
+   * Same as decryptFileFromText(), but operation is executed by thread pool
+   * of Stirlitz object (see encryptFileAsync()).
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to text file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param username User name.
+   * \param password Password.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  decryptFileFromTextAsync(const std::filesystem::path &source_file,
+                           const std::filesystem::path &result,
+                           const std::string &username,
+                           const std::string &password,
+                           const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Encrypts given file to text file for interlocutor asynchronously.
+   *
+   * Same as encryptFileToTextAsync(), but username and password are
+   * generated by genUsernamePasswordEncryption() in thread of pool, so key
+   * agreement does not block calling thread.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to file to be encrypted.
+   * \param result Path to text file result of encryption to be saved to.
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param other_key Smart pointer to interlocutor's public key S-expression
+   * object.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  encryptFileToTextAsync(const std::filesystem::path &source_file,
+                         const std::filesystem::path &result,
+                         std::shared_ptr<gcry_sexp> own_key_pair,
+                         std::shared_ptr<gcry_sexp> other_key,
+                         const StirlitzJob::Callbacks &callbacks);
+
+  /*!
+   * \brief Decrypts text file from interlocutor asynchronously.
+   *
+   * Same as decryptFileFromTextAsync(), but username and password are
+   * generated by genUsernamePasswordDecryption() in thread of pool.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param source_file Path to text file to be decrypted.
+   * \param result Path to file result of decryption to be saved to.
+   * \param own_key_pair Smart pointer to your key pair S-expression object.
+   * \param other_key Smart pointer to interlocutor's public key S-expression
+   * object.
+   * \param callbacks Job callbacks (can be empty).
+   * \return Job handle.
+   */
+  std::shared_ptr<StirlitzJob>
+  decryptFileFromTextAsync(const std::filesystem::path &source_file,
+                           const std::filesystem::path &result,
+                           std::shared_ptr<gcry_sexp> own_key_pair,
+                           std::shared_ptr<gcry_sexp> other_key,
+                           const StirlitzJob::Callbacks &callbacks);
+
   /*!
    * \brief Converts S-expression object to string.
    * \param exp Smart pointer to S-expression.
@@ -236,9 +1298,234 @@ public:
   genUsernamePasswordDecryption(std::shared_ptr<gcry_sexp> own_key_pair,
                                 std::shared_ptr<gcry_sexp> opponent_key);
 
+  /*!
+   * \brief Generates user name and password from given Ed25519 keys.
+   *
+   * Same as genUsernamePasswordEncryption() for keys kept in raw form.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param own_key_pair Your key pair.
+   * \param opponent_key Opponent public key.
+   * \return std::tuple containing user name and password.
+   */
+  std::tuple<std::string, std::string>
+  genUsernamePasswordEncryption(const StirlitzKeyPair &own_key_pair,
+                                const StirlitzKey &opponent_key);
+
+  /*!
+   * \brief Generates user name and password from given Ed25519 keys.
+   *
+   * Same as genUsernamePasswordDecryption() for keys kept in raw form.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param own_key_pair Your key pair.
+   * \param opponent_key Opponent public key.
+   * \return std::tuple containing user name and password.
+   */
+  std::tuple<std::string, std::string>
+  genUsernamePasswordDecryption(const StirlitzKeyPair &own_key_pair,
+                                const StirlitzKey &opponent_key);
+
 private:
+  void
+  initGcrypt(const size_t &secmem_size);
+
+  std::vector<unsigned char>
+  deriveKey(const std::string &username, const std::string &password);
+
+  void
+  encryptFrame(gcry_cipher_hd_t hd, unsigned char *buf, const size_t &sz,
+               const std::string &prefix);
+
+  void
+  decryptFrame(gcry_cipher_hd_t hd, unsigned char *buf, const size_t &sz,
+               const std::string &prefix);
+
+  size_t
+  frameSize(const FileOptions &options, const std::string &prefix);
+
+  uint64_t
+  encryptedSize(const uint64_t &sz, const FileOptions &options,
+                const std::string &prefix);
+
+  uint64_t
+  decryptedSize(const uint64_t &sz, const FileOptions &options,
+                const std::string &prefix);
+
+  void
+  encryptFileKey(const std::filesystem::path &source_file,
+                 const std::filesystem::path &result,
+                 const std::vector<unsigned char> &key,
+                 const FileOptions &options, StirlitzJob *job);
+
+  void
+  decryptFileKey(const std::filesystem::path &source_file,
+                 const std::filesystem::path &result,
+                 const std::vector<unsigned char> &key,
+                 const FileOptions &options, StirlitzJob *job);
+
+  std::shared_ptr<StirlitzJob>
+  dataAsync(
+      std::function<std::shared_ptr<StirlitzStream>(std::string &)> prepare,
+      const StirlitzJob::Callbacks &callbacks);
+
+  void
+  commitResult(ResultFile &result_file, const FileOptions &options);
+
+  void
+  textFile(StirlitzStream *strm, const bool &encrypt,
+           const std::filesystem::path &source_file,
+           const std::filesystem::path &result, const std::string &prefix,
+           StirlitzJob *job);
+
+  JobPool *
+  jobPool();
+
+  std::vector<unsigned char>
+  wrappingKey(std::shared_ptr<gcry_sexp> own_key_pair,
+              std::shared_ptr<gcry_sexp> other_key, const bool &encrypt);
+
+  /*
+   * Frames processed by single call: number of first frame (frame tags
+   * depend on it), limit of source bytes to be encrypted and presence of
+   * integrity trailer (only last part of file holds it).
+   */
+  struct FrameRange
+  {
+    uint64_t first = 0;
+    uint64_t limit = UINT64_MAX;
+    bool trailer = true;
+  };
+
+  uint64_t
+  encryptIO(FileIO *source, FileIO *result,
+            const std::vector<unsigned char> &key, const FileOptions &options,
+            const std::string &prefix, const FrameRange &range,
+            StirlitzJob *job);
+
+  uint64_t
+  decryptIO(FileIO *source, FileIO *result,
+            const std::vector<unsigned char> &key, const FileOptions &options,
+            const std::string &prefix, const uint64_t &source_sz,
+            const FrameRange &range, StirlitzJob *job);
+
+  std::vector<uint64_t>
+  verifyIO(FileIO *source, const uint64_t &source_sz,
+           const std::vector<unsigned char> &key, const FileOptions &options,
+           const FrameRange &range, const std::string &prefix);
+
+  uint64_t
+  encryptParts(const std::filesystem::path &source_file,
+               const std::filesystem::path &result,
+               const std::vector<unsigned char> &key,
+               const FileOptions &options, const uint64_t &part,
+               const std::string &prefix, StirlitzJob *job);
+
+  uint64_t
+  decryptParts(const std::filesystem::path &source_file,
+               const std::filesystem::path &result,
+               const std::vector<unsigned char> &key,
+               const FileOptions &options, const uint64_t &part,
+               const std::string &prefix, StirlitzJob *job);
+
+  std::vector<uint64_t>
+  verifyParts(const std::filesystem::path &source_file,
+              const std::vector<unsigned char> &key,
+              const FileOptions &options, const uint64_t &part,
+              const std::string &prefix);
+
+  std::unique_ptr<PartSet>
+  loadParts(const std::filesystem::path &manifest,
+            const FileOptions &options, const std::string &prefix);
+
+  uint64_t
+  encryptSparseIO(FileIO *source, HoleMap *holes, const uint64_t &source_sz,
+                  FileIO *result, const std::vector<unsigned char> &key,
+                  const FileOptions &options, const std::string &prefix,
+                  StirlitzJob *job);
+
+  uint64_t
+  decryptSparseIO(FileIO *source, FileIO *result,
+                  const std::vector<unsigned char> &key,
+                  const FileOptions &options, const std::string &prefix,
+                  StirlitzJob *job);
+
+  void
+  sparseRecord(gcry_mac_hd_t hd, const unsigned char &type,
+               const uint64_t &value, const uint64_t &index,
+               unsigned char *record, const std::string &prefix);
+
+  static bool
+  isZero(const unsigned char *buf, const size_t &sz);
+
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+  cipherHandle(const std::vector<unsigned char> &key,
+               const std::string &prefix);
+
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+  cipherHandle(const unsigned char *key, const size_t &key_sz,
+               const std::string &prefix);
+
+  void
+  encryptDataKey(gcry_cipher_hd_t hd, const unsigned char *data,
+                 const size_t &data_sz, unsigned char *result);
+
+  size_t
+  decryptDataKey(gcry_cipher_hd_t hd, const unsigned char *data,
+                 const size_t &data_sz, unsigned char *result);
+
+  void
+  releaseCipherHandle(gcry_cipher_hd_t handle);
+
+  std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>
+  macHandle(const std::vector<unsigned char> &key, const std::string &prefix);
+
+  void
+  frameTag(gcry_mac_hd_t hd, const unsigned char *buf, const size_t &sz,
+           const uint64_t &index, unsigned char *tag,
+           const std::string &prefix);
+
+  void
+  frameTrailer(gcry_mac_hd_t hd, const uint64_t &frames,
+               unsigned char *trailer, const std::string &prefix);
+
+  bool
+  hasTrailer(const std::filesystem::path &source_file, const uint64_t &fsz,
+             const std::vector<unsigned char> &key,
+             const FileOptions &options, const std::string &prefix);
+
+  static constexpr size_t frame_tag_sz = 16;
+  static constexpr size_t sparse_hdr_sz = 9;
+  static constexpr size_t sparse_rec_sz = sparse_hdr_sz + frame_tag_sz;
+  static constexpr size_t sparse_magic_sz = 16;
+  static constexpr char sparse_magic[] = "STIRLITZ SPARSE1";
+  static constexpr size_t frame_trailer_sz = 8 + frame_tag_sz;
+
   void
   printGcryptError(const gcry_error_t &err, const std::string &prefix);
+
+  std::mutex handles_mtx;
+  // Idle cipher handles, their keys are overwritten.
+  std::vector<gcry_cipher_hd_t> handles;
+  size_t max_idle_handles = 16;
+
+  std::unique_ptr<BufferPool> buffers;
+
+  std::mutex batch_mtx;
+  // Temporary and resulting paths of files waiting for commitFiles(), by
+  // batch.
+  std::map<uint64_t, std::vector<std::tuple<std::filesystem::path,
+                                            std::filesystem::path>>>
+      batches;
+  uint64_t last_batch = 0;
+
+  std::mutex pool_mtx;
+  std::unique_ptr<JobPool> pool;
+  size_t job_threads = 0;
 };
 
 #endif // STIRLITZ_H
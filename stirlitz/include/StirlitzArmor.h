@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZARMOR_H
+#define STIRLITZARMOR_H
+
+#include <cstdint>
+#include <string>
+
+/*!
+ * \brief The StirlitzArmor class
+ *
+ * Streaming text ("armor") encoding of binary data. Encoder converts data to
+ * hexadecimal or Base64 form split to lines of fixed length and optionally
+ * enclosed between header and trailer lines:
+ *
+ * \code
+ * -----BEGIN STIRLITZ MESSAGE-----
+ * Encoding: base64
+ *
+ * ...
+ * -----END STIRLITZ MESSAGE-----
+ * \endcode
+ *
+ * Decoder accepts both armored and bare text. If header is present, encoding
+ * is taken from it, otherwise encoding given in constructor is used.
+ * Whitespace between digits is ignored. Truncated armored text (without
+ * trailer) is treated as error.
+ *
+ * Data can be passed by pieces of any size. Object is not thread-safe.
+ */
+class StirlitzArmor
+{
+public:
+  /*!
+   * \brief Text encodings.
+   */
+  enum Encoding
+  {
+    Hex,
+    Base64
+  };
+
+  /*!
+   * \brief Conversion direction.
+   */
+  enum Mode
+  {
+    Encode,
+    Decode
+  };
+
+  /*!
+   * \brief StirlitzArmor constructor.
+   * \param mode Conversion direction.
+   * \param encoding Text encoding. In Decode mode it is used only if text
+   * does not have header.
+   * \param header If \a true, encoder adds header and trailer lines. Ignored
+   * in Decode mode.
+   * \param line_length Length of text lines created by encoder. \a 0 means
+   * "do not split to lines". Ignored in Decode mode.
+   */
+  StirlitzArmor(const Mode &mode, const Encoding &encoding,
+                const bool &header = true, const size_t &line_length = 64);
+
+  /*!
+   * \brief Converts next piece of data.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param data Pointer to data.
+   * \param data_sz Size of data in bytes.
+   * \param result Result of conversion will be appended to this string.
+   */
+  void
+  update(const unsigned char *data, const size_t &data_sz,
+         std::string &result);
+
+  /*!
+   * \brief Finishes conversion.
+   *
+   * Encoder flushes buffered bytes and adds trailer. Decoder checks, that
+   * text was complete. reset() must be called before passing new data.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param result Rest of result will be appended to this string.
+   */
+  void
+  finish(std::string &result);
+
+  /*!
+   * \brief Starts new conversion.
+   */
+  void
+  reset();
+
+  /*!
+   * \brief Returns current encoding.
+   *
+   * In Decode mode it can be changed by header of text.
+   */
+  Encoding
+  encoding() const;
+
+private:
+  void
+  encode(const unsigned char *data, const size_t &data_sz,
+         std::string &result);
+
+  void
+  putChar(const char &ch, std::string &result);
+
+  void
+  decode(const unsigned char *data, const size_t &data_sz,
+         std::string &result);
+
+  void
+  decodeChar(const unsigned char &ch, std::string &result);
+
+  void
+  flushBase64(std::string &result);
+
+  void
+  parseLine();
+
+  Mode mode;
+  Encoding enc;
+  Encoding default_enc;
+  bool header;
+  size_t line_length;
+
+  enum State
+  {
+    Start,
+    Begin,
+    Headers,
+    Data,
+    Trailer,
+    End
+  };
+
+  State state = Start;
+  bool armored = false;
+  bool line_start = true;
+  bool padded = false;
+  std::string line;
+  uint32_t bits = 0;
+  size_t bits_count = 0;
+  size_t column = 0;
+};
+
+#endif // STIRLITZARMOR_H
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZC_H
+#define STIRLITZC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * \file StirlitzC.h
+ * \brief C interface of Stirlitz library.
+ *
+ * Stable C interface for use from other languages. All objects are opaque
+ * handles. Data is passed by pointer and size and is read from (written to)
+ * caller's memory directly. Functions return STIRLITZ_OK on success or
+ * error code, text of last error of calling thread can be obtained by
+ * stirlitz_last_error(). If output buffer is too small,
+ * STIRLITZ_BUFFER_TOO_SMALL is returned and required size is written to
+ * out_len.
+ *
+ * stirlitz_ctx can be shared between threads, stirlitz_stream and
+ * stirlitz_key objects must not be used by several threads simultaneously.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /*!
+   * \brief Library context (Stirlitz object).
+   */
+  typedef struct stirlitz_ctx stirlitz_ctx;
+
+  /*!
+   * \brief Key pair or public key.
+   */
+  typedef struct stirlitz_key stirlitz_key;
+
+  /*!
+   * \brief Incremental encryption (decryption) of one message.
+   */
+  typedef struct stirlitz_stream stirlitz_stream;
+
+  /*!
+   * \brief Return codes.
+   */
+  enum stirlitz_status
+  {
+    STIRLITZ_OK = 0,
+    STIRLITZ_ERROR = 1,
+    STIRLITZ_INVALID_ARGUMENT = 2,
+    STIRLITZ_BUFFER_TOO_SMALL = 3
+  };
+
+  /*!
+   * \brief Operation modes.
+   */
+  enum stirlitz_mode
+  {
+    STIRLITZ_ENCRYPT = 0,
+    STIRLITZ_DECRYPT = 1
+  };
+
+  /*!
+   * \brief Armor modes of encrypted files.
+   */
+  enum stirlitz_armor
+  {
+    STIRLITZ_ARMOR_NONE = 0,
+    STIRLITZ_ARMOR_HEX = 1,
+    STIRLITZ_ARMOR_BASE64 = 2
+  };
+
+  /*!
+   * \brief Durability policies of resulting files (see
+   * Stirlitz::FileOptions::Durability).
+   */
+  enum stirlitz_durability
+  {
+    STIRLITZ_SYNC_NONE = 0,
+    STIRLITZ_SYNC_FILE = 1,
+    STIRLITZ_SYNC_BATCH = 2
+  };
+
+  /*!
+   * \brief File operation options (see Stirlitz::FileOptions).
+   *
+   * Must be initialized by stirlitz_file_options_init() before use. New
+   * fields are appended only, each with reserved padding if needed, so
+   * every version of structure has distinct size and library reads only
+   * fields which caller's version contains.
+   */
+  typedef struct stirlitz_file_options
+  {
+    /*!
+     * Size of caller's structure, set by stirlitz_file_options_init().
+     */
+    size_t struct_size;
+    int direct_io;
+    int io_uring;
+    size_t io_queue_depth;
+    int preallocate;
+    size_t threads;
+    size_t frame_size;
+    /*!
+     * Per-frame integrity tags (see Stirlitz::FileOptions::integrity).
+     */
+    int integrity;
+    int reserved1;
+    /*!
+     * Armored text (see Stirlitz::FileOptions::armor): one of
+     * stirlitz_armor values.
+     */
+    int armor;
+    int reserved2;
+    /*!
+     * Memory budget in bytes, 0 for no limit (see
+     * Stirlitz::FileOptions::memory_budget).
+     */
+    size_t memory_budget;
+    /*!
+     * Durability of resulting file: one of stirlitz_durability values.
+     */
+    int durability;
+    int reserved3;
+    /*!
+     * Compact encryption of holes and zeros (see
+     * Stirlitz::FileOptions::sparse).
+     */
+    int sparse;
+    int reserved4;
+    /*!
+     * Size of parts in bytes, 0 for single file (see
+     * Stirlitz::FileOptions::part_size).
+     */
+    uint64_t part_size;
+    /*!
+     * Batch of STIRLITZ_SYNC_BATCH files: token of stirlitz_new_batch() or
+     * 0 for default batch (see Stirlitz::FileOptions::batch).
+     */
+    uint64_t batch;
+  } stirlitz_file_options;
+
+  /*!
+   * \brief Returns text of last error of calling thread.
+   */
+  const char *
+  stirlitz_last_error(void);
+
+  /*!
+   * \brief Creates library context.
+   * \param secmem_size Secure memory pool size in bytes (0 for default).
+   * \return Context or NULL in case of error.
+   */
+  stirlitz_ctx *
+  stirlitz_ctx_new(size_t secmem_size);
+
+  /*!
+   * \brief Destroys library context.
+   */
+  void
+  stirlitz_ctx_free(stirlitz_ctx *ctx);
+
+  /*!
+   * \brief Returns size of encrypted data for given data size.
+   */
+  size_t
+  stirlitz_encrypted_size(size_t data_len);
+
+  /*!
+   * \brief Returns size of decrypted data for given encrypted data size.
+   */
+  size_t
+  stirlitz_decrypted_size(size_t data_len);
+
+  /*!
+   * \brief Encrypts data (see Stirlitz::encryptData()).
+   *
+   * Output buffer must not overlap data.
+   */
+  int
+  stirlitz_encrypt_data(stirlitz_ctx *ctx, const char *username,
+                        size_t username_len, const char *password,
+                        size_t password_len, const uint8_t *data,
+                        size_t data_len, uint8_t *out, size_t out_cap,
+                        size_t *out_len);
+
+  /*!
+   * \brief Decrypts data (see Stirlitz::decryptData()).
+   *
+   * Output buffer must not overlap data.
+   */
+  int
+  stirlitz_decrypt_data(stirlitz_ctx *ctx, const char *username,
+                        size_t username_len, const char *password,
+                        size_t password_len, const uint8_t *data,
+                        size_t data_len, uint8_t *out, size_t out_cap,
+                        size_t *out_len);
+
+  /*!
+   * \brief Creates stream (see StirlitzStream).
+   * \return Stream or NULL in case of error.
+   */
+  stirlitz_stream *
+  stirlitz_stream_new(stirlitz_ctx *ctx, int mode, const char *username,
+                      size_t username_len, const char *password,
+                      size_t password_len);
+
+  /*!
+   * \brief Maximum output of stirlitz_stream_update() for given data size.
+   */
+  size_t
+  stirlitz_stream_update_size(size_t data_len);
+
+  /*!
+   * \brief Maximum output of stirlitz_stream_final().
+   */
+  size_t
+  stirlitz_stream_final_size(void);
+
+  /*!
+   * \brief Processes next piece of data.
+   *
+   * out_cap must be at least stirlitz_stream_update_size(data_len).
+   */
+  int
+  stirlitz_stream_update(stirlitz_stream *stream, const uint8_t *data,
+                         size_t data_len, uint8_t *out, size_t out_cap,
+                         size_t *out_len);
+
+  /*!
+   * \brief Finishes message.
+   *
+   * out_cap must be at least stirlitz_stream_final_size().
+   */
+  int
+  stirlitz_stream_final(stirlitz_stream *stream, uint8_t *out,
+                        size_t out_cap, size_t *out_len);
+
+  /*!
+   * \brief Destroys stream.
+   */
+  void
+  stirlitz_stream_free(stirlitz_stream *stream);
+
+  /*!
+   * \brief Fills options by default values.
+   *
+   * Only fields which fit into struct_size bytes are written, so structure
+   * of older version is never overrun.
+   *
+   * \param options Options to be filled.
+   * \param struct_size Size of caller's structure: sizeof(*options).
+   */
+  void
+  stirlitz_file_options_init(stirlitz_file_options *options,
+                             size_t struct_size);
+
+  /*!
+   * \brief Encrypts file (see Stirlitz::encryptFile()).
+   *
+   * Paths are in UTF-8. options can be NULL.
+   */
+  int
+  stirlitz_encrypt_file(stirlitz_ctx *ctx, const char *source_path,
+                        const char *result_path, const char *username,
+                        size_t username_len, const char *password,
+                        size_t password_len,
+                        const stirlitz_file_options *options);
+
+  /*!
+   * \brief Decrypts file (see Stirlitz::decryptFile()).
+   *
+   * Paths are in UTF-8. options can be NULL.
+   */
+  int
+  stirlitz_decrypt_file(stirlitz_ctx *ctx, const char *source_path,
+                        const char *result_path, const char *username,
+                        size_t username_len, const char *password,
+                        size_t password_len,
+                        const stirlitz_file_options *options);
+
+  /*!
+   * \brief Creates new batch of STIRLITZ_SYNC_BATCH files (see
+   * Stirlitz::newBatch()).
+   */
+  int
+  stirlitz_new_batch(stirlitz_ctx *ctx, uint64_t *batch);
+
+  /*!
+   * \brief Commits files of default batch written with STIRLITZ_SYNC_BATCH
+   * durability (see Stirlitz::commitFiles()).
+   */
+  int
+  stirlitz_commit_files(stirlitz_ctx *ctx);
+
+  /*!
+   * \brief Commits files of given batch written with STIRLITZ_SYNC_BATCH
+   * durability (see Stirlitz::commitFiles()).
+   */
+  int
+  stirlitz_commit_batch(stirlitz_ctx *ctx, uint64_t batch);
+
+  /*!
+   * \brief Generates Ed25519 key pair.
+   */
+  int
+  stirlitz_key_generate(stirlitz_ctx *ctx, stirlitz_key **key);
+
+  /*!
+   * \brief Creates public key from raw data (32 bytes).
+   */
+  int
+  stirlitz_key_from_public(stirlitz_ctx *ctx, const uint8_t *public_key,
+                           size_t public_key_len, stirlitz_key **key);
+
+  /*!
+   * \brief Creates key from S-expression string representation.
+   */
+  int
+  stirlitz_key_import(stirlitz_ctx *ctx, const char *sexp, size_t sexp_len,
+                      stirlitz_key **key);
+
+  /*!
+   * \brief Writes S-expression string representation of key.
+   */
+  int
+  stirlitz_key_export(stirlitz_ctx *ctx, const stirlitz_key *key, char *out,
+                      size_t out_cap, size_t *out_len);
+
+  /*!
+   * \brief Writes raw public key (32 bytes).
+   */
+  int
+  stirlitz_key_public(stirlitz_ctx *ctx, const stirlitz_key *key,
+                      uint8_t *out, size_t out_cap, size_t *out_len);
+
+  /*!
+   * \brief Destroys key.
+   */
+  void
+  stirlitz_key_free(stirlitz_key *key);
+
+  /*!
+   * \brief Derives user name and password from keys (see
+   * Stirlitz::genUsernamePasswordEncryption() and
+   * Stirlitz::genUsernamePasswordDecryption()).
+   *
+   * \param mode STIRLITZ_ENCRYPT or STIRLITZ_DECRYPT.
+   */
+  int
+  stirlitz_derive_credentials(stirlitz_ctx *ctx,
+                              const stirlitz_key *own_key_pair,
+                              const stirlitz_key *opponent_key, int mode,
+                              char *username, size_t username_cap,
+                              size_t *username_len, char *password,
+                              size_t password_cap, size_t *password_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STIRLITZC_H
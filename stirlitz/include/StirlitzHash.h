@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZHASH_H
+#define STIRLITZHASH_H
+
+#include <functional>
+#include <gcrypt.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief The StirlitzHash class
+ *
+ * Incremental variant of Stirlitz::hashString(). Data can be passed by
+ * pieces of any size, result is the same as result of
+ * Stirlitz::hashString() for concatenated data. Data is not copied and not
+ * kept inside object.
+ *
+ * libgcrypt must be initialized (Stirlitz object must be created) before
+ * object construction. Object is not thread-safe.
+ */
+class StirlitzHash
+{
+public:
+  /*!
+   * \brief StirlitzHash constructor.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param algo Hash algorithm (see Stirlitz::hashString()).
+   */
+  StirlitzHash(const int &algo);
+
+  /*!
+   * \brief Passes next piece of data to hash function.
+   * \param data Pointer to data.
+   * \param data_sz Size of data in bytes.
+   */
+  void
+  update(const unsigned char *data, const size_t &data_sz);
+
+  /*!
+   * \brief Passes next piece of data to hash function.
+   * \param data Data.
+   */
+  void
+  update(const std::string &data);
+
+  /*!
+   * \brief Returns hash summ of all data passed after construction or last
+   * reset() call.
+   *
+   * Hash function is finished by this call, reset() must be called before
+   * passing new data.
+   *
+   * \return Vector containing hash summ.
+   */
+  std::vector<unsigned char>
+  result();
+
+  /*!
+   * \brief Starts new hash calculation.
+   */
+  void
+  reset();
+
+  /*!
+   * \brief Returns size of hash summ in bytes.
+   */
+  size_t
+  size() const;
+
+private:
+  void
+  printGcryptError(const gcry_error_t &err, const std::string &prefix);
+
+  int algo;
+  std::unique_ptr<gcry_md_handle, std::function<void(gcry_md_handle *)>> hd;
+};
+
+#endif // STIRLITZHASH_H
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZJOB_H
+#define STIRLITZJOB_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/*!
+ * \brief The StirlitzJob class
+ *
+ * Handle of asynchronous operation started by one of Stirlitz "Async" methods
+ * (Stirlitz::encryptFileAsync() etc). Jobs are executed by thread pool owned
+ * by Stirlitz object. Handle can be used to track progress, wait for
+ * completion and cancel job. All methods of this class are thread-safe.
+ */
+class StirlitzJob
+{
+public:
+  /*!
+   * \brief Job states.
+   */
+  enum State
+  {
+    /*!
+     * Job is waiting for free thread of pool.
+     */
+    Queued,
+    /*!
+     * Job is being executed.
+     */
+    Running,
+    /*!
+     * Job has been finished successfully.
+     */
+    Finished,
+    /*!
+     * Job has been finished with error (see error()).
+     */
+    Failed,
+    /*!
+     * Job has been cancelled.
+     */
+    Cancelled
+  };
+
+  /*!
+   * \brief Job callbacks.
+   *
+   * Callbacks are called from threads of pool, they must not block for long
+   * time and must not wait for the same job.
+   */
+  struct Callbacks
+  {
+    /*!
+     * \brief Called after each processed part of data.
+     *
+     * Arguments are number of processed bytes of source and total size of
+     * source.
+     */
+    std::function<void(const uint64_t &processed, const uint64_t &total)>
+        progress;
+
+    /*!
+     * \brief Called once after job has been finished, failed or cancelled.
+     */
+    std::function<void(StirlitzJob &job)> finished;
+  };
+
+  StirlitzJob(const StirlitzJob &other) = delete;
+
+  StirlitzJob &
+  operator=(const StirlitzJob &other) = delete;
+
+  /*!
+   * \brief Returns current job state.
+   */
+  State
+  state();
+
+  /*!
+   * \brief Returns number of processed bytes of source.
+   */
+  uint64_t
+  processed();
+
+  /*!
+   * \brief Returns total size of source in bytes.
+   *
+   * Returns 0 if size is not known yet.
+   */
+  uint64_t
+  total();
+
+  /*!
+   * \brief Requests cancellation of job.
+   *
+   * Queued job is never started, running job is stopped after current part
+   * of data. Partially written resulting file is removed. Method does not
+   * wait for job stop, use wait() for this.
+   */
+  void
+  cancel();
+
+  /*!
+   * \brief Blocks calling thread until job is finished, failed or
+   * cancelled.
+   *
+   * Returns after Callbacks::finished has been called.
+   */
+  void
+  wait();
+
+  /*!
+   * \brief Blocks calling thread until job is finished, failed or cancelled
+   * or until timeout expires.
+   * \return \a true if job has been completed, \a false otherwise.
+   */
+  bool
+  waitFor(const std::chrono::milliseconds &timeout);
+
+  /*!
+   * \brief Returns error message if job has failed.
+   */
+  std::string
+  error();
+
+  /*!
+   * \brief Returns result of data job (Stirlitz::encryptDataAsync() and
+   * Stirlitz::decryptDataAsync()).
+   *
+   * Result is moved out of job, so it can be obtained only once. Returns empty
+   * string for file jobs or if job has not been finished.
+   */
+  std::string
+  result();
+
+private:
+  friend class Stirlitz;
+  friend class JobPool;
+
+  StirlitzJob(std::function<void(StirlitzJob &job)> work,
+              const Callbacks &callbacks);
+
+  void
+  execute();
+
+  bool
+  cancelled();
+
+  void
+  setTotal(const uint64_t &total);
+
+  void
+  addProgress(const uint64_t &sz);
+
+  void
+  complete(const State &state);
+
+  std::function<void(StirlitzJob &job)> work;
+  Callbacks callbacks;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  State st = State::Queued;
+  bool done = false;
+  std::atomic<bool> cancel_requested;
+  std::atomic<uint64_t> processed_b;
+  std::atomic<uint64_t> total_b;
+  std::string error_msg;
+  std::string result_data;
+};
+
+#endif // STIRLITZJOB_H
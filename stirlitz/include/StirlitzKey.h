@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZKEY_H
+#define STIRLITZKEY_H
+
+#include <gcrypt.h>
+#include <memory>
+#include <string>
+
+/*!
+ * \brief The StirlitzKey class
+ *
+ * Ed25519 public key kept in raw form (32 bytes) together with its
+ * fingerprint (BLAKE2s-256 hash summ of raw key, the same as
+ * StirlitzKeyring::fingerprint()). Fingerprint is calculated once on
+ * construction. Objects are cheap to copy and compare, S-expression of key is
+ * created only by sexp() call (at libgcrypt boundary).
+ *
+ * libgcrypt must be initialized (Stirlitz object must be created) before
+ * creation of non-empty objects.
+ */
+class StirlitzKey
+{
+public:
+  /*!
+   * \brief Creates empty key.
+   */
+  StirlitzKey();
+
+  /*!
+   * \brief StirlitzKey constructor.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param public_key Raw public key (32 bytes, NOT in hexadecimal format).
+   */
+  StirlitzKey(const std::string &public_key);
+
+  /*!
+   * \brief Extracts public key from S-expression.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param key Smart pointer to public key S-expression or to key pair
+   * S-expression.
+   * \return Key object.
+   */
+  static StirlitzKey
+  fromSexp(std::shared_ptr<gcry_sexp> key);
+
+  /*!
+   * \brief Creates public key S-expression.
+   * \return Smart pointer to S-expression (empty pointer for empty key).
+   */
+  std::shared_ptr<gcry_sexp>
+  sexp() const;
+
+  /*!
+   * \brief Returns raw public key (32 bytes).
+   */
+  const std::string &
+  raw() const;
+
+  /*!
+   * \brief Returns fingerprint of key (raw BLAKE2s-256 hash summ, 32 bytes).
+   */
+  const std::string &
+  fingerprint() const;
+
+  /*!
+   * \brief Returns \a true if object does not contain key.
+   */
+  bool
+  empty() const;
+
+  /*!
+   * \brief Serializes key to compact binary form (33 bytes).
+   */
+  std::string
+  serialize() const;
+
+  /*!
+   * \brief Restores key from result of serialize().
+   *
+   * Public key S-expressions created by Stirlitz::sexpToString() are
+   * accepted too.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param data Serialized key.
+   * \return Key object.
+   */
+  static StirlitzKey
+  deserialize(const std::string &data);
+
+  bool
+  operator==(const StirlitzKey &other) const;
+
+  bool
+  operator!=(const StirlitzKey &other) const;
+
+private:
+  friend class StirlitzKeyPair;
+
+  static std::string
+  token(gcry_sexp *exp, const std::string &section, const std::string &name,
+        const std::string &prefix);
+
+  std::string key;
+  std::string fpr;
+};
+
+/*!
+ * \brief The StirlitzKeyPair class
+ *
+ * Ed25519 key pair kept in raw form: public key (see StirlitzKey) and 32
+ * bytes of secret key. Secret key is kept in libgcrypt secure memory and is
+ * shared (not copied) by copies of object. Compact binary form of key pair
+ * takes 65 bytes.
+ *
+ * libgcrypt must be initialized (Stirlitz object must be created) before
+ * creation of non-empty objects.
+ */
+class StirlitzKeyPair
+{
+public:
+  /*!
+   * \brief Creates empty key pair.
+   */
+  StirlitzKeyPair();
+
+  /*!
+   * \brief StirlitzKeyPair constructor.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param public_key Raw public key (32 bytes).
+   * \param secret_key Raw secret key (32 bytes).
+   */
+  StirlitzKeyPair(const std::string &public_key,
+                  const std::string &secret_key);
+
+  /*!
+   * \brief Generates new key pair.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \return Key pair object.
+   */
+  static StirlitzKeyPair
+  generate();
+
+  /*!
+   * \brief Extracts key pair from S-expression.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param key Smart pointer to key pair S-expression (see
+   * Stirlitz::generateKeyPair()).
+   * \return Key pair object.
+   */
+  static StirlitzKeyPair
+  fromSexp(std::shared_ptr<gcry_sexp> key);
+
+  /*!
+   * \brief Creates key pair S-expression.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \return Smart pointer to S-expression (empty pointer for empty key
+   * pair).
+   */
+  std::shared_ptr<gcry_sexp>
+  sexp() const;
+
+  /*!
+   * \brief Returns public key of pair.
+   */
+  const StirlitzKey &
+  publicKey() const;
+
+  /*!
+   * \brief Returns \a true if object does not contain key pair.
+   */
+  bool
+  empty() const;
+
+  /*!
+   * \brief Serializes key pair to compact binary form (65 bytes).
+   *
+   * Result contains secret key and must be encrypted before storing.
+   */
+  std::string
+  serialize() const;
+
+  /*!
+   * \brief Restores key pair from result of serialize().
+   *
+   * Key pair S-expressions created by Stirlitz::sexpToString() are accepted
+   * too.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param data Serialized key pair.
+   * \return Key pair object.
+   */
+  static StirlitzKeyPair
+  deserialize(const std::string &data);
+
+private:
+  StirlitzKey pub;
+  std::shared_ptr<unsigned char> secret;
+};
+
+#endif // STIRLITZKEY_H
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZKEYRING_H
+#define STIRLITZKEYRING_H
+
+#include <Stirlitz.h>
+#include <filesystem>
+#include <gcrypt.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * \brief The StirlitzKeyring class
+ *
+ * Storage of many interlocutors' Ed25519 public keys. Keys are kept in raw
+ * form (32 bytes) together with optional names and are indexed by
+ * fingerprints (BLAKE2s-256 hash summ of raw public key), so search of key
+ * takes constant time regardless of keyring size. Keyring is saved to file in
+ * compact binary form encrypted as a whole by encryptData() algorithm, so it
+ * is loaded by single decryption and no S-expression parsing is needed.
+ * S-expression of key is created only when it is requested by publicKey().
+ *
+ * Object is not thread-safe.
+ */
+class StirlitzKeyring
+{
+public:
+  /*!
+   * \brief Keyring entry.
+   */
+  struct Entry
+  {
+    /*!
+     * Raw public key (32 bytes).
+     */
+    std::string public_key;
+    /*!
+     * Fingerprint of key (raw BLAKE2s-256 hash summ, 32 bytes).
+     */
+    std::string fingerprint;
+    /*!
+     * Name of key owner (can be empty).
+     */
+    std::string name;
+  };
+
+  /*!
+   * \brief StirlitzKeyring constructor.
+   * \param spy Stirlitz object (libgcrypt must be initialized).
+   */
+  StirlitzKeyring(Stirlitz &spy);
+
+  /*!
+   * \brief Adds key to keyring.
+   *
+   * If key is already in keyring, its name is replaced.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param public_key Raw public key (32 bytes, NOT in hexadecimal format).
+   * \param name Name of key owner (up to 65535 bytes).
+   * \return Fingerprint of key.
+   */
+  std::string
+  add(const std::string &public_key, const std::string &name);
+
+  /*!
+   * \brief Adds key to keyring.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param key Smart pointer to public key S-expression or to key pair
+   * S-expression.
+   * \param name Name of key owner (up to 65535 bytes).
+   * \return Fingerprint of key.
+   */
+  std::string
+  add(std::shared_ptr<gcry_sexp> key, const std::string &name);
+
+  /*!
+   * \brief Removes key from keyring.
+   *
+   * Order of remaining entries can be changed.
+   *
+   * \param fingerprint Fingerprint of key.
+   * \return \a true if key has been removed, \a false if key was not found.
+   */
+  bool
+  remove(const std::string &fingerprint);
+
+  /*!
+   * \brief Searches key by fingerprint.
+   * \param fingerprint Fingerprint of key (raw, NOT in hexadecimal format).
+   * \return Pointer to entry or \a nullptr if key was not found. Pointer is
+   * valid until next modification of keyring.
+   */
+  const Entry *
+  find(const std::string &fingerprint) const;
+
+  /*!
+   * \brief Creates public key S-expression of key with given fingerprint.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param fingerprint Fingerprint of key.
+   * \return Smart pointer to public key S-expression or empty pointer if key
+   * was not found.
+   */
+  std::shared_ptr<gcry_sexp>
+  publicKey(const std::string &fingerprint);
+
+  /*!
+   * \brief Returns all entries of keyring.
+   */
+  const std::vector<Entry> &
+  entries() const;
+
+  /*!
+   * \brief Returns number of keys in keyring.
+   */
+  size_t
+  size() const;
+
+  /*!
+   * \brief Removes all keys from keyring.
+   */
+  void
+  clear();
+
+  /*!
+   * \brief Calculates fingerprint of raw public key.
+   * \param public_key Raw public key.
+   * \return Fingerprint (32 bytes).
+   */
+  std::string
+  fingerprint(const std::string &public_key);
+
+  /*!
+   * \brief Serializes keyring to compact binary form (not encrypted).
+   */
+  std::string
+  serialize() const;
+
+  /*!
+   * \brief Replaces content of keyring by content of serialized keyring.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param data Result of serialize().
+   */
+  void
+  deserialize(const std::string &data);
+
+  /*!
+   * \brief Loads keyring from file.
+   *
+   * \note This method can throw std::exception in case of errors (including
+   * incorrect user name or password).
+   *
+   * \param file Path to keyring file.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  load(const std::filesystem::path &file, const std::string &username,
+       const std::string &password);
+
+  /*!
+   * \brief Saves keyring to file.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param file Path to keyring file.
+   * \param username User name.
+   * \param password Password.
+   */
+  void
+  save(const std::filesystem::path &file, const std::string &username,
+       const std::string &password);
+
+private:
+  Stirlitz *spy;
+  std::vector<Entry> keys;
+  std::unordered_map<std::string, size_t> index;
+};
+
+#endif // STIRLITZKEYRING_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZSESSIONKEY_H
+#define STIRLITZSESSIONKEY_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*!
+ * \brief The StirlitzSessionKey class
+ *
+ * Key derived from user name and password the same way as by
+ * Stirlitz::encryptData(). Key is derived once on construction and is kept
+ * in libgcrypt secure memory, user name and password are not kept at all.
+ * Data encrypted by Stirlitz::encryptData() with session key can be
+ * decrypted by Stirlitz::decryptData() with user name and password and vice
+ * versa. Copies of object share the same key.
+ *
+ * libgcrypt must be initialized (Stirlitz object must be created) before
+ * creation of non-empty objects.
+ */
+class StirlitzSessionKey
+{
+public:
+  /*!
+   * \brief Creates empty key.
+   */
+  StirlitzSessionKey();
+
+  /*!
+   * \brief StirlitzSessionKey constructor.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param username User name.
+   * \param password Password.
+   */
+  StirlitzSessionKey(const std::string &username,
+                     const std::string &password);
+
+  /*!
+   * \brief Returns pointer to key (nullptr for empty key).
+   */
+  const unsigned char *
+  data() const;
+
+  /*!
+   * \brief Returns size of key in bytes (0 for empty key).
+   */
+  size_t
+  size() const;
+
+  /*!
+   * \brief Returns \a true if object does not contain key.
+   */
+  bool
+  empty() const;
+
+  /*!
+   * \brief Forgets key.
+   *
+   * Memory is cleared when last copy of object forgets key.
+   */
+  void
+  clear();
+
+private:
+  std::shared_ptr<unsigned char> key;
+  size_t key_sz = 0;
+};
+
+#endif // STIRLITZSESSIONKEY_H
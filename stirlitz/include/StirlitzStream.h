@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STIRLITZSTREAM_H
+#define STIRLITZSTREAM_H
+
+#include <Stirlitz.h>
+#include <functional>
+#include <gcrypt.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief The StirlitzStream class
+ *
+ * Incremental variant of Stirlitz::encryptData() and
+ * Stirlitz::decryptData(). Data can be passed by pieces of any size, result
+ * is the same as result of one-shot methods for concatenated data. Data is
+ * read from and result is written to caller's buffers directly, only last 32
+ * bytes or less of data are kept inside object (they are needed for cipher
+ * text stealing at the end of message).
+ *
+ * One object processes one message. Object is not thread-safe.
+ */
+class StirlitzStream
+{
+public:
+  /*!
+   * \brief Stream modes.
+   */
+  enum Mode
+  {
+    /*!
+     * Encryption.
+     */
+    Encrypt,
+    /*!
+     * Decryption.
+     */
+    Decrypt
+  };
+
+  /*!
+   * \brief StirlitzStream constructor.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param spy Stirlitz object (libgcrypt must be initialized).
+   * \param mode Stream mode.
+   * \param username User name.
+   * \param password Password.
+   */
+  StirlitzStream(Stirlitz &spy, const Mode &mode, const std::string &username,
+                 const std::string &password);
+
+  /*!
+   * \brief Processes next piece of data.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param data Pointer to data.
+   * \param data_sz Size of data in bytes.
+   * \param result Pointer to buffer result to be written to. Buffer size must
+   * be at least updateSize(data_sz) bytes. Buffer must not overlap data.
+   * \return Number of bytes written to result (can be 0).
+   */
+  size_t
+  update(const unsigned char *data, const size_t &data_sz,
+         unsigned char *result);
+
+  /*!
+   * \brief Finishes message.
+   *
+   * Processes data kept inside object. No more data can be passed after
+   * this call.
+   *
+   * \note This method can throw std::exception in case of errors.
+   *
+   * \param result Pointer to buffer result to be written to. Buffer size must
+   * be at least finishSize() bytes.
+   * \return Number of bytes written to result.
+   */
+  size_t
+  finish(unsigned char *result);
+
+  /*!
+   * \brief Maximum size of result of update() call.
+   * \param data_sz Size of data to be passed to update().
+   * \return Size in bytes.
+   */
+  static size_t
+  updateSize(const size_t &data_sz);
+
+  /*!
+   * \brief Maximum size of result of finish() call.
+   * \return Size in bytes.
+   */
+  static size_t
+  finishSize();
+
+private:
+  void
+  process(const unsigned char *data, unsigned char *result, const size_t &sz);
+
+  void
+  printGcryptError(const gcry_error_t &err, const std::string &prefix);
+
+  Mode mode;
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      cbc;
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      cts;
+
+  std::vector<unsigned char> tail;
+  std::vector<unsigned char> last_block;
+  size_t block_sz;
+  bool processed = false;
+  bool skip_first = false;
+  bool finished = false;
+};
+
+#endif // STIRLITZSTREAM_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ArmorFileIO.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+ArmorFileIO::ArmorFileIO(FileIO *io, const Mode &mode,
+                         const StirlitzArmor::Encoding &encoding)
+    : armor(mode == Read ? StirlitzArmor::Decode : StirlitzArmor::Encode,
+            encoding)
+{
+  this->io = io;
+  this->mode = mode;
+  if(mode == Read)
+    {
+      text.resize(65536);
+    }
+}
+
+size_t
+ArmorFileIO::read(unsigned char *buf, const size_t &sz)
+{
+  if(mode != Read)
+    {
+      throw std::runtime_error("ArmorFileIO::read: object is not readable");
+    }
+  size_t result = 0;
+  while(result < sz)
+    {
+      if(decoded_pos == decoded.size())
+        {
+          if(eof)
+            {
+              break;
+            }
+          decoded.clear();
+          decoded_pos = 0;
+          size_t rb = io->read(text.data(), text.size());
+          if(rb > 0)
+            {
+              armor.update(text.data(), rb, decoded);
+            }
+          else
+            {
+              armor.finish(decoded);
+              eof = true;
+            }
+          continue;
+        }
+      size_t n = std::min(sz - result, decoded.size() - decoded_pos);
+      std::memcpy(buf + result, decoded.data() + decoded_pos, n);
+      decoded_pos += n;
+      result += n;
+    }
+  return result;
+}
+
+void
+ArmorFileIO::write(const unsigned char *buf, const size_t &sz)
+{
+  if(mode != Write)
+    {
+      throw std::runtime_error("ArmorFileIO::write: object is not writable");
+    }
+  std::string result;
+  armor.update(buf, sz, result);
+  io->write(reinterpret_cast<const unsigned char *>(result.data()),
+            result.size());
+}
+
+void
+ArmorFileIO::close()
+{
+  if(mode == Write)
+    {
+      std::string result;
+      armor.finish(result);
+      io->write(reinterpret_cast<const unsigned char *>(result.data()),
+                result.size());
+    }
+}
+
+uint64_t
+ArmorFileIO::size()
+{
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ARMORFILEIO_H
+#define ARMORFILEIO_H
+
+#include <FileIO.h>
+#include <StirlitzArmor.h>
+#include <string>
+#include <vector>
+
+// Adapter converting data of other FileIO object to or from armored text (see
+// StirlitzArmor). Wrapped object is not owned and is not closed by close().
+// Size of decoded data is not known in advance, so size() always returns 0.
+class ArmorFileIO : public FileIO
+{
+public:
+  ArmorFileIO(FileIO *io, const Mode &mode,
+              const StirlitzArmor::Encoding &encoding);
+
+  size_t
+  read(unsigned char *buf, const size_t &sz) override;
+
+  void
+  write(const unsigned char *buf, const size_t &sz) override;
+
+  void
+  close() override;
+
+  uint64_t
+  size() override;
+
+private:
+  FileIO *io;
+  Mode mode;
+  StirlitzArmor armor;
+  std::string decoded;
+  size_t decoded_pos = 0;
+  std::vector<unsigned char> text;
+  bool eof = false;
+};
+
+#endif // ARMORFILEIO_H
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <BufferPool.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+BufferPool::BufferPool(const size_t &max_idle)
+{
+  this->max_idle = max_idle;
+}
+
+BufferPool::~BufferPool()
+{
+  for(auto it = idle.begin(); it != idle.end(); it++)
+    {
+      deallocate(it->second);
+    }
+}
+
+std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+BufferPool::get(const size_t &sz, const size_t &max_idle)
+{
+  // Sizes are rounded to pages, so frames of slightly different sizes
+  // (encryption, decryption, tags) share the same buffers. Only buffers of
+  // the same capacity are reused to keep memory usage predictable (see
+  // FileOptions::memory_budget).
+  size_t capacity = sz == 0 ? 1 : sz;
+  capacity = (capacity + page_sz - 1) / page_sz * page_sz;
+
+  unsigned char *buf = nullptr;
+  std::multimap<size_t, unsigned char *> unused;
+  std::unique_lock<std::mutex> ulock(idle_mtx);
+  auto it = idle.find(capacity);
+  if(it != idle.end())
+    {
+      buf = it->second;
+      idle_sz -= capacity;
+      idle.erase(it);
+    }
+  else
+    {
+      // Buffers of other sizes are freed before new allocation, so idle
+      // buffers do not add to memory used by operation.
+      unused.swap(idle);
+      idle_sz = 0;
+    }
+  ulock.unlock();
+
+  for(it = unused.begin(); it != unused.end(); it++)
+    {
+      deallocate(it->second);
+    }
+
+  if(buf == nullptr)
+    {
+      buf = allocate(capacity);
+    }
+
+  return std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>(
+      buf,
+      [this, capacity, sz, max_idle](unsigned char *buf)
+        {
+          release(buf, capacity, sz, max_idle);
+        });
+}
+
+void
+BufferPool::release(unsigned char *buf, const size_t &capacity,
+                    const size_t &sz, const size_t &max_idle)
+{
+  // Rest of buffer has been wiped by previous release.
+  wipe(buf, sz);
+
+  size_t limit = this->max_idle;
+  if(max_idle != 0 && max_idle < limit)
+    {
+      limit = max_idle;
+    }
+  std::unique_lock<std::mutex> ulock(idle_mtx);
+  if(idle_sz + capacity <= limit)
+    {
+      idle.emplace(capacity, buf);
+      idle_sz += capacity;
+      return void();
+    }
+  ulock.unlock();
+  deallocate(buf);
+}
+
+unsigned char *
+BufferPool::allocate(const size_t &capacity)
+{
+#ifdef __linux__
+  if(capacity >= huge_page_sz)
+    {
+      void *ptr;
+      if(posix_memalign(&ptr, huge_page_sz, capacity) != 0)
+        {
+          throw std::bad_alloc();
+        }
+      // Only a hint: huge pages can be disabled or unavailable.
+      madvise(ptr, capacity, MADV_HUGEPAGE);
+      return reinterpret_cast<unsigned char *>(ptr);
+    }
+#endif
+  void *ptr = std::malloc(capacity);
+  if(ptr == nullptr)
+    {
+      throw std::bad_alloc();
+    }
+  return reinterpret_cast<unsigned char *>(ptr);
+}
+
+void
+BufferPool::deallocate(unsigned char *buf)
+{
+  std::free(buf);
+}
+
+void
+BufferPool::wipe(unsigned char *buf, const size_t &sz)
+{
+  // Call through volatile pointer can not be removed by optimizer.
+  static void *(*const volatile wipe_func)(void *, int, size_t) = std::memset;
+  wipe_func(buf, 0, sz);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/*
+ * Pool of frame buffers reused by file operations. Buffers are not
+ * initialized, so frames are not zero-filled on each call. Large buffers are
+ * aligned to 2 MiB and marked for transparent huge pages on Linux. Buffers
+ * can contain plain text, so used part of each buffer is wiped when it is
+ * returned to pool. Idle buffers are kept while their total size does not
+ * exceed limit of pool and limit of operation which has used them, other
+ * buffers are freed.
+ */
+class BufferPool
+{
+public:
+  BufferPool(const size_t &max_idle);
+
+  BufferPool(const BufferPool &other) = delete;
+
+  BufferPool &
+  operator=(const BufferPool &other)
+      = delete;
+
+  ~BufferPool();
+
+  /*
+   * Returns buffer of at least sz bytes. Buffer is returned to pool by
+   * deleter of resulting object and is kept only if total size of idle
+   * buffers does not exceed max_idle (0 means limit of pool only), so memory
+   * budget of operation also bounds memory held after it.
+   */
+  std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+  get(const size_t &sz, const size_t &max_idle);
+
+private:
+  void
+  release(unsigned char *buf, const size_t &capacity, const size_t &sz,
+          const size_t &max_idle);
+
+  static unsigned char *
+  allocate(const size_t &capacity);
+
+  static void
+  deallocate(unsigned char *buf);
+
+  static void
+  wipe(unsigned char *buf, const size_t &sz);
+
+  std::mutex idle_mtx;
+  // Idle buffers by capacity.
+  std::multimap<size_t, unsigned char *> idle;
+  size_t idle_sz = 0;
+  size_t max_idle;
+
+  static constexpr size_t page_sz = 4096;
+  static constexpr size_t huge_page_sz = 2097152;
+};
+
+#endif // BUFFERPOOL_H
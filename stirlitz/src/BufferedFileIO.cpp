@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <BufferedFileIO.h>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+BufferedFileIO::BufferedFileIO(const std::filesystem::path &p,
+                               const Mode &mode)
+{
+  this->p = p;
+  switch(mode)
+    {
+    case Mode::Read:
+      {
+        f.open(p, std::ios_base::in | std::ios_base::binary);
+        break;
+      }
+    case Mode::Write:
+      {
+        f.open(p, std::ios_base::out | std::ios_base::binary);
+        break;
+      }
+    default:
+      break;
+    }
+  if(!f.is_open())
+    {
+      throw std::runtime_error("BufferedFileIO: cannot open file");
+    }
+}
+
+size_t
+BufferedFileIO::read(unsigned char *buf, const size_t &sz)
+{
+  f.read(reinterpret_cast<char *>(buf), sz);
+  return static_cast<size_t>(f.gcount());
+}
+
+void
+BufferedFileIO::write(const unsigned char *buf, const size_t &sz)
+{
+  f.write(reinterpret_cast<const char *>(buf), sz);
+  if(!f.good())
+    {
+      throw std::runtime_error("BufferedFileIO::write: write error");
+    }
+  zero_tail = false;
+}
+
+void
+BufferedFileIO::close()
+{
+  if(zero_tail)
+    {
+      // Last zero byte is written to set file size, rest is left as hole.
+      f.seekp(-1, std::ios_base::cur);
+      f.put(0);
+      zero_tail = false;
+    }
+  f.close();
+  if(f.fail())
+    {
+      throw std::runtime_error("BufferedFileIO::close: write error");
+    }
+}
+
+uint64_t
+BufferedFileIO::size()
+{
+  std::streampos pos = f.tellg();
+  f.seekg(0, std::ios_base::end);
+  uint64_t result = static_cast<uint64_t>(f.tellg());
+  f.seekg(pos, std::ios_base::beg);
+  return result;
+}
+
+void
+BufferedFileIO::preallocate(const uint64_t &sz)
+{
+#ifdef __linux__
+  int fd = ::open(p.c_str(), O_WRONLY | O_CLOEXEC);
+  if(fd >= 0)
+    {
+      try
+        {
+          allocate(fd, sz);
+        }
+      catch(std::exception &er)
+        {
+          ::close(fd);
+          throw;
+        }
+      ::close(fd);
+    }
+#else
+  static_cast<void>(sz);
+#endif
+}
+
+void
+BufferedFileIO::skip(const uint64_t &sz)
+{
+  f.seekg(static_cast<std::streamoff>(sz), std::ios_base::cur);
+  if(!f.good())
+    {
+      throw std::runtime_error("BufferedFileIO::skip: read error");
+    }
+}
+
+void
+BufferedFileIO::writeZeros(const uint64_t &sz)
+{
+  if(sz == 0)
+    {
+      return void();
+    }
+  // Seek beyond written data leaves hole in file.
+  f.seekp(static_cast<std::streamoff>(sz), std::ios_base::cur);
+  if(!f.good())
+    {
+      throw std::runtime_error("BufferedFileIO::writeZeros: write error");
+    }
+  zero_tail = true;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUFFEREDFILEIO_H
+#define BUFFEREDFILEIO_H
+
+#include <FileIO.h>
+#include <fstream>
+
+class BufferedFileIO : public FileIO
+{
+public:
+  BufferedFileIO(const std::filesystem::path &p, const Mode &mode);
+
+  size_t
+  read(unsigned char *buf, const size_t &sz) override;
+
+  void
+  write(const unsigned char *buf, const size_t &sz) override;
+
+  void
+  close() override;
+
+  uint64_t
+  size() override;
+
+  void
+  preallocate(const uint64_t &sz) override;
+
+  void
+  skip(const uint64_t &sz) override;
+
+  void
+  writeZeros(const uint64_t &sz) override;
+
+private:
+  std::fstream f;
+  std::filesystem::path p;
+  // File ends by skipped zeros, which are not written yet.
+  bool zero_tail = false;
+};
+
+#endif // BUFFEREDFILEIO_H
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <DirectFileIO.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+DirectFileIO::DirectFileIO(const std::filesystem::path &p, const Mode &mode)
+{
+  this->mode = mode;
+  int flags;
+  switch(mode)
+    {
+    case Mode::Read:
+      {
+        flags = O_RDONLY;
+        break;
+      }
+    case Mode::Write:
+    default:
+      {
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+        break;
+      }
+    }
+  fd = ::open(p.c_str(), flags | O_DIRECT | O_CLOEXEC, 0666);
+  if(fd < 0 && errno == EINVAL)
+    {
+      // File system does not support O_DIRECT. Same aligned chunks are used,
+      // but through page cache.
+      fd = ::open(p.c_str(), flags | O_CLOEXEC, 0666);
+    }
+  if(fd < 0)
+    {
+      throw std::runtime_error("DirectFileIO: cannot open file: "
+                               + std::string(std::strerror(errno)));
+    }
+
+  void *ptr;
+  if(posix_memalign(&ptr, align, stage_sz) != 0)
+    {
+      ::close(fd);
+      throw std::runtime_error("DirectFileIO: cannot allocate buffer");
+    }
+  stage = reinterpret_cast<unsigned char *>(ptr);
+}
+
+DirectFileIO::~DirectFileIO()
+{
+  if(fd >= 0)
+    {
+      ::close(fd);
+    }
+  // Staging buffer holds plain text of source or result, so it is wiped as
+  // frame buffers of BufferPool. Call through volatile pointer can not be
+  // removed by optimizer.
+  static void *(*const volatile wipe_func)(void *, int, size_t) = std::memset;
+  wipe_func(stage, 0, stage_sz);
+  free(stage);
+}
+
+size_t
+DirectFileIO::read(unsigned char *buf, const size_t &sz)
+{
+  size_t result = 0;
+  while(result < sz)
+    {
+      if(stage_pos == stage_len)
+        {
+          if(eof)
+            {
+              break;
+            }
+          fillStage();
+          if(stage_len == 0)
+            {
+              break;
+            }
+        }
+      size_t cp = std::min(sz - result, stage_len - stage_pos);
+      std::memcpy(buf + result, stage + stage_pos, cp);
+      stage_pos += cp;
+      result += cp;
+    }
+  return result;
+}
+
+void
+DirectFileIO::write(const unsigned char *buf, const size_t &sz)
+{
+  size_t written = 0;
+  while(written < sz)
+    {
+      size_t cp = std::min(sz - written, stage_sz - stage_len);
+      std::memcpy(stage + stage_len, buf + written, cp);
+      stage_len += cp;
+      written += cp;
+      if(stage_len == stage_sz)
+        {
+          flushStage(stage_sz);
+        }
+    }
+}
+
+void
+DirectFileIO::close()
+{
+  if(fd < 0)
+    {
+      return void();
+    }
+  if(mode == Mode::Write && stage_len > 0)
+    {
+      size_t aligned = stage_len - stage_len % align;
+      if(aligned > 0)
+        {
+          flushStage(aligned);
+        }
+      if(stage_len > 0)
+        {
+          // Unaligned tail: O_DIRECT is switched off for last write.
+          int flags = fcntl(fd, F_GETFL);
+          if(flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) < 0)
+            {
+              throw std::runtime_error("DirectFileIO::close: "
+                                       + std::string(std::strerror(errno)));
+            }
+          flushStage(stage_len);
+        }
+    }
+  int res = ::close(fd);
+  fd = -1;
+  if(res != 0)
+    {
+      throw std::runtime_error("DirectFileIO::close: "
+                               + std::string(std::strerror(errno)));
+    }
+}
+
+uint64_t
+DirectFileIO::size()
+{
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    {
+      throw std::runtime_error("DirectFileIO::size: "
+                               + std::string(std::strerror(errno)));
+    }
+  return static_cast<uint64_t>(st.st_size);
+}
+
+void
+DirectFileIO::preallocate(const uint64_t &sz)
+{
+  allocate(fd, sz);
+}
+
+void
+DirectFileIO::skip(const uint64_t &sz)
+{
+  size_t cp = static_cast<size_t>(
+      std::min(sz, static_cast<uint64_t>(stage_len - stage_pos)));
+  stage_pos += cp;
+  uint64_t left = sz - cp;
+  if(left > 0 && !eof)
+    {
+      // Stage is empty, aligned part is skipped by moving offset.
+      uint64_t aligned = left - left % align;
+      file_off += aligned;
+      left -= aligned;
+    }
+  FileIO::skip(left);
+}
+
+void
+DirectFileIO::fillStage()
+{
+  stage_pos = 0;
+  stage_len = 0;
+  while(stage_len < stage_sz)
+    {
+      ssize_t rb = pread(fd, stage + stage_len, stage_sz - stage_len,
+                         static_cast<off_t>(file_off));
+      if(rb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          throw std::runtime_error("DirectFileIO::read: "
+                                   + std::string(std::strerror(errno)));
+        }
+      if(rb == 0 || rb % align != 0)
+        {
+          stage_len += static_cast<size_t>(rb);
+          file_off += static_cast<uint64_t>(rb);
+          eof = true;
+          break;
+        }
+      stage_len += static_cast<size_t>(rb);
+      file_off += static_cast<uint64_t>(rb);
+    }
+}
+
+void
+DirectFileIO::flushStage(const size_t &sz)
+{
+  size_t written = 0;
+  while(written < sz)
+    {
+      ssize_t wb = pwrite(fd, stage + written, sz - written,
+                          static_cast<off_t>(file_off));
+      if(wb < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          throw std::runtime_error("DirectFileIO::write: "
+                                   + std::string(std::strerror(errno)));
+        }
+      written += static_cast<size_t>(wb);
+      file_off += static_cast<uint64_t>(wb);
+    }
+  if(written < stage_len)
+    {
+      std::memmove(stage, stage + written, stage_len - written);
+    }
+  stage_len -= written;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DIRECTFILEIO_H
+#define DIRECTFILEIO_H
+
+#include <FileIO.h>
+
+/*
+ * Reads and writes files bypassing page cache (O_DIRECT). All device I/O is
+ * carried out by aligned chunks through aligned staging buffer, so callers
+ * can read and write blocks of any size. Unaligned tail of written file is
+ * written in buffered mode.
+ */
+class DirectFileIO : public FileIO
+{
+public:
+  DirectFileIO(const std::filesystem::path &p, const Mode &mode);
+
+  ~DirectFileIO();
+
+  size_t
+  read(unsigned char *buf, const size_t &sz) override;
+
+  void
+  write(const unsigned char *buf, const size_t &sz) override;
+
+  void
+  close() override;
+
+  uint64_t
+  size() override;
+
+  void
+  preallocate(const uint64_t &sz) override;
+
+  void
+  skip(const uint64_t &sz) override;
+
+private:
+  void
+  fillStage();
+
+  void
+  flushStage(const size_t &sz);
+
+  int fd = -1;
+  Mode mode;
+
+  unsigned char *stage = nullptr;
+  size_t stage_sz = 4194304;
+  size_t stage_pos = 0;
+  size_t stage_len = 0;
+  uint64_t file_off = 0;
+  bool eof = false;
+
+  const size_t align = 4096;
+};
+
+#endif // DIRECTFILEIO_H
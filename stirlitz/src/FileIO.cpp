@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <BufferedFileIO.h>
+#include <FileIO.h>
+#include <MemoryBudget.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef __linux__
+#include <DirectFileIO.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#endif
+
+#ifdef STIRLITZ_IO_URING
+#include <UringFileIO.h>
+#endif
+
+FileIO::~FileIO()
+{
+}
+
+void
+FileIO::preallocate(const uint64_t &sz)
+{
+  static_cast<void>(sz);
+}
+
+void
+FileIO::skip(const uint64_t &sz)
+{
+  std::vector<unsigned char> buf(static_cast<size_t>(
+      std::min(sz, static_cast<uint64_t>(65536))));
+  uint64_t left = sz;
+  while(left > 0)
+    {
+      size_t part = static_cast<size_t>(
+          std::min(left, static_cast<uint64_t>(buf.size())));
+      size_t rb = read(buf.data(), part);
+      if(rb == 0)
+        {
+          break;
+        }
+      left -= rb;
+    }
+}
+
+void
+FileIO::writeZeros(const uint64_t &sz)
+{
+  std::vector<unsigned char> buf(static_cast<size_t>(
+      std::min(sz, static_cast<uint64_t>(65536))));
+  uint64_t left = sz;
+  while(left > 0)
+    {
+      size_t wb = static_cast<size_t>(
+          std::min(left, static_cast<uint64_t>(buf.size())));
+      write(buf.data(), wb);
+      left -= wb;
+    }
+}
+
+std::unique_ptr<FileIO>
+FileIO::open(const std::filesystem::path &p, const Mode &mode,
+             const Stirlitz::FileOptions &options)
+{
+  std::unique_ptr<FileIO> result;
+#ifdef STIRLITZ_IO_URING
+  // Queue depth can be reduced (down to synchronous I/O) by memory budget.
+  size_t queue_depth = MemoryBudget(options).ioQueueDepth();
+  if(options.io_backend == Stirlitz::FileOptions::IOUring && queue_depth > 0
+     && UringFileIO::isAvailable())
+    {
+      result = std::unique_ptr<FileIO>(
+          new UringFileIO(p, mode, options.direct_io, queue_depth));
+      return result;
+    }
+#endif
+#ifdef __linux__
+  if(options.direct_io)
+    {
+      result = std::unique_ptr<FileIO>(new DirectFileIO(p, mode));
+    }
+  else
+    {
+      result = std::unique_ptr<FileIO>(new BufferedFileIO(p, mode));
+    }
+#else
+  result = std::unique_ptr<FileIO>(new BufferedFileIO(p, mode));
+#endif
+  return result;
+}
+
+void
+FileIO::allocate(const int &fd, const uint64_t &sz)
+{
+#ifdef __linux__
+  // File size is kept, blocks are just reserved for following writes.
+  if(fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(sz)) != 0)
+    {
+      if(errno == ENOSPC || errno == EFBIG)
+        {
+          throw std::runtime_error("FileIO::preallocate: "
+                                   + std::string(std::strerror(errno)));
+        }
+    }
+#else
+  static_cast<void>(fd);
+  static_cast<void>(sz);
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <Stirlitz.h>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+class FileIO
+{
+public:
+  enum Mode
+  {
+    Read,
+    Write
+  };
+
+  virtual ~FileIO();
+
+  virtual size_t
+  read(unsigned char *buf, const size_t &sz)
+      = 0;
+
+  virtual void
+  write(const unsigned char *buf, const size_t &sz)
+      = 0;
+
+  virtual void
+  close()
+      = 0;
+
+  virtual uint64_t
+  size()
+      = 0;
+
+  virtual void
+  preallocate(const uint64_t &sz);
+
+  /*
+   * Skips sz bytes of source (they are read by default).
+   */
+  virtual void
+  skip(const uint64_t &sz);
+
+  /*
+   * Writes sz zero bytes. Regular files can leave hole instead of them.
+   */
+  virtual void
+  writeZeros(const uint64_t &sz);
+
+  static std::unique_ptr<FileIO>
+  open(const std::filesystem::path &p, const Mode &mode,
+       const Stirlitz::FileOptions &options);
+
+protected:
+  static void
+  allocate(const int &fd, const uint64_t &sz);
+};
+
+#endif // FILEIO_H
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <FramePipeline.h>
+
+FramePipeline::FramePipeline(const size_t &workers, const size_t &depth,
+                             const size_t &buf_sz, BufferPool *pool,
+                             const size_t &max_idle)
+{
+  this->workers = workers == 0 ? 1 : workers;
+  slots.resize(depth < this->workers ? this->workers : depth);
+  for(auto it = slots.begin(); it != slots.end(); it++)
+    {
+      it->buf = pool->get(buf_sz, max_idle);
+    }
+}
+
+void
+FramePipeline::run(
+    std::function<size_t(unsigned char *buf)> read_func,
+    std::function<void(unsigned char *buf, const size_t &len,
+                       const uint64_t &seq, const size_t &worker)>
+        process_func,
+    std::function<void(unsigned char *buf, const size_t &len)> write_func)
+{
+  std::vector<std::thread> threads;
+  threads.reserve(workers + 1);
+  for(size_t i = 0; i < workers; i++)
+    {
+      threads.emplace_back(&FramePipeline::worker, this, i, process_func);
+    }
+  threads.emplace_back(&FramePipeline::writer, this, write_func);
+
+  try
+    {
+      for(;;)
+        {
+          std::unique_lock<std::mutex> ulock(mtx);
+          auto it = slots.end();
+          cv.wait(ulock,
+                  [this, &it]
+                    {
+                      if(error)
+                        {
+                          return true;
+                        }
+                      for(it = slots.begin(); it != slots.end(); it++)
+                        {
+                          if(it->state == SlotState::Free)
+                            {
+                              return true;
+                            }
+                        }
+                      return false;
+                    });
+          if(error)
+            {
+              break;
+            }
+          ulock.unlock();
+
+          size_t len = read_func(it->buf.get());
+
+          ulock.lock();
+          if(len == 0)
+            {
+              read_finished = true;
+              cv.notify_all();
+              break;
+            }
+          it->len = len;
+          it->seq = read_seq;
+          it->state = SlotState::Filled;
+          read_seq++;
+          cv.notify_all();
+        }
+    }
+  catch(...)
+    {
+      setError(std::current_exception());
+    }
+
+  for(auto it = threads.begin(); it != threads.end(); it++)
+    {
+      it->join();
+    }
+
+  if(error)
+    {
+      std::rethrow_exception(error);
+    }
+}
+
+void
+FramePipeline::worker(
+    const size_t &index,
+    std::function<void(unsigned char *buf, const size_t &len,
+                       const uint64_t &seq, const size_t &worker)>
+        process_func)
+{
+  for(;;)
+    {
+      std::unique_lock<std::mutex> ulock(mtx);
+      auto it = slots.end();
+      cv.wait(ulock,
+              [this, &it]
+                {
+                  if(error)
+                    {
+                      return true;
+                    }
+                  // Oldest frame first.
+                  for(auto it_s = slots.begin(); it_s != slots.end(); it_s++)
+                    {
+                      if(it_s->state == SlotState::Filled
+                         && (it == slots.end() || it_s->seq < it->seq))
+                        {
+                          it = it_s;
+                        }
+                    }
+                  return it != slots.end()
+                         || (read_finished && write_seq == read_seq);
+                });
+      if(error || it == slots.end())
+        {
+          break;
+        }
+      it->state = SlotState::Processing;
+      ulock.unlock();
+
+      try
+        {
+          process_func(it->buf.get(), it->len, it->seq, index);
+        }
+      catch(...)
+        {
+          setError(std::current_exception());
+          break;
+        }
+
+      ulock.lock();
+      it->state = SlotState::Processed;
+      cv.notify_all();
+    }
+}
+
+void
+FramePipeline::writer(
+    std::function<void(unsigned char *buf, const size_t &len)> write_func)
+{
+  for(;;)
+    {
+      std::unique_lock<std::mutex> ulock(mtx);
+      auto it = slots.end();
+      cv.wait(ulock,
+              [this, &it]
+                {
+                  if(error)
+                    {
+                      return true;
+                    }
+                  for(it = slots.begin(); it != slots.end(); it++)
+                    {
+                      if(it->state == SlotState::Processed
+                         && it->seq == write_seq)
+                        {
+                          return true;
+                        }
+                    }
+                  return read_finished && write_seq == read_seq;
+                });
+      if(error || it == slots.end())
+        {
+          cv.notify_all();
+          break;
+        }
+      ulock.unlock();
+
+      try
+        {
+          write_func(it->buf.get(), it->len);
+        }
+      catch(...)
+        {
+          setError(std::current_exception());
+          break;
+        }
+
+      ulock.lock();
+      it->state = SlotState::Free;
+      write_seq++;
+      cv.notify_all();
+    }
+}
+
+void
+FramePipeline::setError(std::exception_ptr er)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  if(!error)
+    {
+      error = er;
+    }
+  cv.notify_all();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <BufferPool.h>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Processes sequence of independent frames by several worker threads. Calling
+ * thread reads frames, workers process them in any order, separate thread
+ * writes processed frames in original order. Number of frames in flight is
+ * limited by depth, frame buffers are taken from given pool (see
+ * BufferPool::get() for max_idle).
+ */
+class FramePipeline
+{
+public:
+  FramePipeline(const size_t &workers, const size_t &depth,
+                const size_t &buf_sz, BufferPool *pool,
+                const size_t &max_idle);
+
+  /*
+   * read_func fills given buffer and returns number of bytes (0 means end of
+   * data). process_func is called by worker threads with frame number
+   * (starting from 0) and worker index. Both write_func and read_func are
+   * called sequentially in frames order.
+   */
+  void
+  run(std::function<size_t(unsigned char *buf)> read_func,
+      std::function<void(unsigned char *buf, const size_t &len,
+                         const uint64_t &seq, const size_t &worker)>
+          process_func,
+      std::function<void(unsigned char *buf, const size_t &len)> write_func);
+
+private:
+  enum SlotState
+  {
+    Free,
+    Filled,
+    Processing,
+    Processed
+  };
+
+  struct Slot
+  {
+    std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+        buf;
+    size_t len = 0;
+    uint64_t seq = 0;
+    SlotState state = SlotState::Free;
+  };
+
+  void
+  worker(const size_t &index,
+         std::function<void(unsigned char *buf, const size_t &len,
+                            const uint64_t &seq, const size_t &worker)>
+             process_func);
+
+  void
+  writer(std::function<void(unsigned char *buf, const size_t &len)>
+             write_func);
+
+  void
+  setError(std::exception_ptr er);
+
+  size_t workers;
+  std::vector<Slot> slots;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  uint64_t read_seq = 0;
+  uint64_t write_seq = 0;
+  bool read_finished = false;
+  std::exception_ptr error;
+};
+
+#endif // FRAMEPIPELINE_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <HoleMap.h>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+HoleMap::HoleMap(const std::filesystem::path &p)
+{
+#if !defined(_WIN32) && defined(SEEK_DATA)
+  fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+  static_cast<void>(p);
+#endif
+}
+
+HoleMap::~HoleMap()
+{
+#ifndef _WIN32
+  if(fd >= 0)
+    {
+      ::close(fd);
+    }
+#endif
+}
+
+bool
+HoleMap::isHole(const uint64_t &offset, const uint64_t &sz)
+{
+#if !defined(_WIN32) && defined(SEEK_DATA)
+  if(fd < 0)
+    {
+      return false;
+    }
+  // Ranges are requested in increasing order, so lseek() is needed only
+  // when previously found data region has been passed.
+  if(next_data > offset)
+    {
+      return next_data >= offset + sz;
+    }
+  off_t res = lseek(fd, static_cast<off_t>(offset), SEEK_DATA);
+  if(res < 0)
+    {
+      if(errno == ENXIO)
+        {
+          // No data after offset.
+          next_data = UINT64_MAX;
+          return true;
+        }
+      // Holes are not supported.
+      ::close(fd);
+      fd = -1;
+      return false;
+    }
+  next_data = static_cast<uint64_t>(res);
+  return next_data >= offset + sz;
+#else
+  static_cast<void>(offset);
+  static_cast<void>(sz);
+  return false;
+#endif
+}
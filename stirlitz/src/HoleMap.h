@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOLEMAP_H
+#define HOLEMAP_H
+
+#include <cstdint>
+#include <filesystem>
+
+/*
+ * Finds holes of sparse file by lseek(SEEK_DATA). If file system (or
+ * platform) does not report holes, whole file is considered as data.
+ */
+class HoleMap
+{
+public:
+  HoleMap(const std::filesystem::path &p);
+
+  HoleMap(const HoleMap &other) = delete;
+
+  HoleMap &
+  operator=(const HoleMap &other)
+      = delete;
+
+  ~HoleMap();
+
+  /*
+   * Returns true if range [offset, offset + sz) does not contain data.
+   */
+  bool
+  isHole(const uint64_t &offset, const uint64_t &sz);
+
+private:
+  int fd = -1;
+  // Start of next data region found by previous call.
+  uint64_t next_data = 0;
+};
+
+#endif // HOLEMAP_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <JobPool.h>
+#include <algorithm>
+
+JobPool::JobPool(const size_t &threads)
+{
+  size_t count = threads == 0 ? 1 : threads;
+  this->threads.reserve(count);
+  for(size_t i = 0; i < count; i++)
+    {
+      this->threads.emplace_back(&JobPool::worker, this);
+    }
+}
+
+JobPool::~JobPool()
+{
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    stop = true;
+    for(auto it = queue.begin(); it != queue.end(); it++)
+      {
+        (*it)->cancel();
+      }
+    for(auto it = running.begin(); it != running.end(); it++)
+      {
+        (*it)->cancel();
+      }
+  }
+  cv.notify_all();
+  for(auto it = threads.begin(); it != threads.end(); it++)
+    {
+      it->join();
+    }
+}
+
+void
+JobPool::submit(std::shared_ptr<StirlitzJob> job)
+{
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    queue.push_back(job);
+  }
+  cv.notify_one();
+}
+
+size_t
+JobPool::size()
+{
+  return threads.size();
+}
+
+void
+JobPool::worker()
+{
+  std::unique_lock<std::mutex> ulock(mtx);
+  for(;;)
+    {
+      cv.wait(ulock,
+              [this]
+                {
+                  return stop || !queue.empty();
+                });
+      if(queue.empty())
+        {
+          break;
+        }
+      std::shared_ptr<StirlitzJob> job = queue.front();
+      queue.pop_front();
+      running.push_back(job);
+      ulock.unlock();
+
+      job->execute();
+
+      ulock.lock();
+      running.erase(std::find(running.begin(), running.end(), job));
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+#include <StirlitzJob.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed size pool of threads executing StirlitzJob objects in order of
+ * submission. Destructor cancels all queued and running jobs and waits for
+ * threads.
+ */
+class JobPool
+{
+public:
+  JobPool(const size_t &threads);
+
+  ~JobPool();
+
+  void
+  submit(std::shared_ptr<StirlitzJob> job);
+
+  size_t
+  size();
+
+private:
+  void
+  worker();
+
+  std::vector<std::thread> threads;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<std::shared_ptr<StirlitzJob>> queue;
+  std::vector<std::shared_ptr<StirlitzJob>> running;
+  bool stop = false;
+};
+
+#endif // JOBPOOL_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <MemoryBudget.h>
+#include <algorithm>
+
+MemoryBudget::MemoryBudget(const Stirlitz::FileOptions &options)
+{
+  size_t threads = options.threads > 1 ? options.threads : 1;
+  bool io_uring = options.io_backend == Stirlitz::FileOptions::IOUring;
+  if(options.memory_budget == 0)
+    {
+      io_depth = io_uring ? std::max(options.io_queue_depth,
+                                     static_cast<size_t>(1))
+                          : 0;
+      worker_count = threads;
+      frames = 2 * threads;
+      return;
+    }
+
+  size_t frame_sz = options.frame_size + tag_sz;
+  size_t fixed = 0;
+  if(options.direct_io)
+    {
+      // Source and result files.
+      fixed += 2 * stage_sz;
+      needed += ", O_DIRECT staging buffers";
+    }
+  if(options.armor)
+    {
+      // Encoded frame is about 4/3 of its size (plus line breaks).
+      fixed += options.frame_size + options.frame_size / 2 + armor_text_sz;
+      needed += ", armor text buffers";
+    }
+  if(options.memory_budget < fixed
+     || options.memory_budget - fixed < frame_sz)
+    {
+      fit = false;
+      minimum = fixed + frame_sz;
+      return;
+    }
+  size_t avail = options.memory_budget - fixed;
+
+  if(io_uring)
+    {
+      // Each chunk of queue is allocated for source and for result.
+      io_depth = std::min(options.io_queue_depth,
+                          (avail - frame_sz) / 2 / (2 * io_chunk_sz));
+      avail -= io_depth * 2 * io_chunk_sz;
+    }
+
+  size_t slots = avail / frame_sz;
+  worker_count = std::min(threads, slots);
+  if(worker_count < 2)
+    {
+      worker_count = 1;
+    }
+  frames = std::min(2 * worker_count, slots);
+}
+
+bool
+MemoryBudget::fits() const
+{
+  return fit;
+}
+
+std::string
+MemoryBudget::shortage() const
+{
+  return "memory budget is less than " + std::to_string(minimum)
+         + " bytes needed for " + needed;
+}
+
+size_t
+MemoryBudget::ioQueueDepth() const
+{
+  return io_depth;
+}
+
+size_t
+MemoryBudget::workers() const
+{
+  return worker_count;
+}
+
+size_t
+MemoryBudget::depth() const
+{
+  return frames;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <Stirlitz.h>
+#include <string>
+
+/*
+ * Distributes FileOptions::memory_budget between buffers of file operation.
+ * One frame buffer and fixed buffers (O_DIRECT staging buffers, armor text)
+ * are always needed. Rest of budget is shared by io_uring chunks (not more
+ * than half of it) and frames in flight, number of workers and pipeline depth
+ * are reduced to fit. Frame size is never changed, because data encrypted
+ * with other frame size can not be decrypted. Result depends only on options,
+ * so the same distribution is obtained by all parts of operation.
+ */
+class MemoryBudget
+{
+public:
+  MemoryBudget(const Stirlitz::FileOptions &options);
+
+  /*
+   * Returns false if budget is less than single frame and fixed buffers.
+   */
+  bool
+  fits() const;
+
+  /*
+   * Describes budget which does not fit: buffers which are always needed and
+   * minimal budget.
+   */
+  std::string
+  shortage() const;
+
+  /*
+   * Number of io_uring chunks in flight, 0 means that io_uring queue does not
+   * fit into budget and synchronous backend must be used.
+   */
+  size_t
+  ioQueueDepth() const;
+
+  /*
+   * Number of worker threads (1 means sequential processing).
+   */
+  size_t
+  workers() const;
+
+  /*
+   * Number of frames kept in memory by FramePipeline.
+   */
+  size_t
+  depth() const;
+
+private:
+  bool fit = true;
+  size_t minimum = 0;
+  std::string needed = "frame";
+  size_t io_depth = 0;
+  size_t worker_count = 1;
+  size_t frames = 1;
+
+  // Chunk of UringFileIO and staging buffer of DirectFileIO.
+  const size_t io_chunk_sz = 2097152;
+  const size_t stage_sz = 4194304;
+  const size_t tag_sz = 16;
+  const size_t armor_text_sz = 131072;
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <PartSet.h>
+#include <algorithm>
+#include <fstream>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+PartSet::PartSet(const std::filesystem::path &manifest, const uint64_t &sz,
+                 const size_t &source_frame_sz,
+                 const size_t &encrypted_frame_sz, const size_t &trailer_sz,
+                 const uint64_t &part_sz)
+{
+  dir = manifest.parent_path();
+  source_sz = sz;
+  source_frame = source_frame_sz;
+  encrypted_frame = encrypted_frame_sz;
+  trailer = trailer_sz;
+  if(source_frame == 0 || encrypted_frame < source_frame
+     || part_sz < static_cast<uint64_t>(encrypted_frame) + trailer)
+    {
+      throw std::runtime_error(
+          "PartSet::PartSet: part size is less than frame size");
+    }
+  frames_per_part = (part_sz - trailer) / encrypted_frame;
+
+  frames = source_sz / source_frame;
+  if(source_sz % source_frame != 0)
+    {
+      frames++;
+    }
+  uint64_t parts = std::max(
+      (frames + frames_per_part - 1) / frames_per_part,
+      static_cast<uint64_t>(1));
+  std::string base = manifest.filename().u8string();
+  for(uint64_t i = 0; i < parts; i++)
+    {
+      names.emplace_back(partName(base, i, parts));
+    }
+}
+
+PartSet::PartSet(const std::filesystem::path &manifest)
+{
+  dir = manifest.parent_path();
+  std::fstream f;
+  f.open(manifest, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error("PartSet::PartSet: cannot open manifest");
+    }
+
+  std::string line;
+  std::getline(f, line);
+  if(line != "STIRLITZ PARTS 1")
+    {
+      throw std::runtime_error("PartSet::PartSet: incorrect manifest");
+    }
+
+  std::vector<uint64_t> sizes;
+  bool frame_found = false;
+  while(std::getline(f, line))
+    {
+      if(line.empty())
+        {
+          continue;
+        }
+      std::stringstream strm(line);
+      strm.imbue(std::locale("C"));
+      std::string key;
+      strm >> key;
+      bool ok = true;
+      if(key == "source_size")
+        {
+          ok = static_cast<bool>(strm >> source_sz);
+        }
+      else if(key == "frame")
+        {
+          ok = static_cast<bool>(strm >> source_frame >> encrypted_frame);
+          frame_found = true;
+        }
+      else if(key == "trailer")
+        {
+          ok = static_cast<bool>(strm >> trailer);
+        }
+      else if(key == "frames_per_part")
+        {
+          ok = static_cast<bool>(strm >> frames_per_part);
+        }
+      else if(key == "part")
+        {
+          // Name is the rest of line, it can contain spaces.
+          uint64_t part_sz;
+          ok = static_cast<bool>(strm >> part_sz) && strm.get() == ' ';
+          std::string name;
+          std::getline(strm, name);
+          ok = ok && validName(name);
+          sizes.push_back(part_sz);
+          names.emplace_back(name);
+        }
+      if(!ok)
+        {
+          throw std::runtime_error("PartSet::PartSet: incorrect manifest");
+        }
+    }
+
+  // Layout is checked against values it is derived from.
+  if(!frame_found || source_frame == 0 || encrypted_frame < source_frame
+     || frames_per_part == 0
+     || frames_per_part > UINT64_MAX / 2 / encrypted_frame)
+    {
+      throw std::runtime_error("PartSet::PartSet: incorrect manifest");
+    }
+  frames = source_sz / source_frame;
+  if(source_sz % source_frame != 0)
+    {
+      frames++;
+    }
+  uint64_t parts = std::max(
+      (frames + frames_per_part - 1) / frames_per_part,
+      static_cast<uint64_t>(1));
+  if(names.size() != parts)
+    {
+      throw std::runtime_error("PartSet::PartSet: incorrect manifest");
+    }
+  for(uint64_t i = 0; i < parts; i++)
+    {
+      if(sizes[i] != size(i))
+        {
+          throw std::runtime_error("PartSet::PartSet: incorrect manifest");
+        }
+    }
+}
+
+void
+PartSet::save(const std::filesystem::path &p) const
+{
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << "STIRLITZ PARTS 1\n";
+  strm << "source_size " << source_sz << "\n";
+  strm << "frame " << source_frame << " " << encrypted_frame << "\n";
+  strm << "trailer " << trailer << "\n";
+  strm << "frames_per_part " << frames_per_part << "\n";
+  for(size_t i = 0; i < names.size(); i++)
+    {
+      strm << "part " << size(i) << " " << names[i] << "\n";
+    }
+
+  std::fstream f;
+  f.open(p, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error("PartSet::save: cannot write manifest");
+    }
+  std::string data = strm.str();
+  f.write(data.c_str(), data.size());
+  f.close();
+  if(f.fail())
+    {
+      throw std::runtime_error("PartSet::save: cannot write manifest");
+    }
+}
+
+bool
+PartSet::matches(const size_t &source_frame_sz,
+                 const size_t &encrypted_frame_sz,
+                 const size_t &trailer_sz) const
+{
+  return source_frame == source_frame_sz
+         && encrypted_frame == encrypted_frame_sz && trailer == trailer_sz;
+}
+
+uint64_t
+PartSet::count() const
+{
+  return static_cast<uint64_t>(names.size());
+}
+
+uint64_t
+PartSet::framesPerPart() const
+{
+  return frames_per_part;
+}
+
+uint64_t
+PartSet::sourceSize() const
+{
+  return source_sz;
+}
+
+std::filesystem::path
+PartSet::path(const uint64_t &part) const
+{
+  return dir / std::filesystem::u8path(names[part]);
+}
+
+uint64_t
+PartSet::size(const uint64_t &part) const
+{
+  uint64_t result = sourceSize(part)
+                    + frameCount(part) * (encrypted_frame - source_frame);
+  if(isLast(part))
+    {
+      result += trailer;
+    }
+  return result;
+}
+
+uint64_t
+PartSet::firstFrame(const uint64_t &part) const
+{
+  return part * frames_per_part;
+}
+
+uint64_t
+PartSet::sourceOffset(const uint64_t &part) const
+{
+  return firstFrame(part) * source_frame;
+}
+
+uint64_t
+PartSet::sourceSize(const uint64_t &part) const
+{
+  uint64_t offset = std::min(sourceOffset(part), source_sz);
+  return std::min(frames_per_part * source_frame, source_sz - offset);
+}
+
+bool
+PartSet::isLast(const uint64_t &part) const
+{
+  return part + 1 == count();
+}
+
+uint64_t
+PartSet::frameCount(const uint64_t &part) const
+{
+  uint64_t first = std::min(firstFrame(part), frames);
+  return std::min(frames_per_part, frames - first);
+}
+
+std::string
+PartSet::partName(const std::string &base, const uint64_t &part,
+                  const uint64_t &parts)
+{
+  // Numbers have equal width, so parts are listed in order by name.
+  size_t width = std::to_string(parts - 1).size();
+  std::string num = std::to_string(part);
+  if(num.size() < std::max(width, static_cast<size_t>(4)))
+    {
+      num.insert(0, std::max(width, static_cast<size_t>(4)) - num.size(),
+                 '0');
+    }
+  return base + "." + num;
+}
+
+bool
+PartSet::validName(const std::string &name)
+{
+  // Parts can be only in the directory of manifest.
+  return !name.empty() && name != "." && name != ".."
+         && name.find_first_of("/\\") == std::string::npos;
+}
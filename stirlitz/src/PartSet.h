@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PARTSET_H
+#define PARTSET_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+ * Layout of encrypted file split into parts. Each part holds whole encrypted
+ * frames (part k begins with frame k * framesPerPart()), last part also holds
+ * trailer, so concatenation of parts is ordinary encrypted file. Manifest is
+ * small text file describing layout and names of parts. Parts are kept in
+ * the directory of manifest.
+ */
+class PartSet
+{
+public:
+  /*
+   * Layout of new part set for source of sz bytes. Frame of source_frame_sz
+   * bytes of source takes encrypted_frame_sz bytes, trailer_sz bytes are
+   * added to last part. Parts do not exceed part_sz bytes.
+   */
+  PartSet(const std::filesystem::path &manifest, const uint64_t &sz,
+          const size_t &source_frame_sz, const size_t &encrypted_frame_sz,
+          const size_t &trailer_sz, const uint64_t &part_sz);
+
+  /*
+   * Reads manifest.
+   */
+  PartSet(const std::filesystem::path &manifest);
+
+  /*
+   * Writes manifest to p.
+   */
+  void
+  save(const std::filesystem::path &p) const;
+
+  /*
+   * Returns true if layout has been made for given frame and trailer sizes.
+   */
+  bool
+  matches(const size_t &source_frame_sz, const size_t &encrypted_frame_sz,
+          const size_t &trailer_sz) const;
+
+  uint64_t
+  count() const;
+
+  uint64_t
+  framesPerPart() const;
+
+  uint64_t
+  sourceSize() const;
+
+  std::filesystem::path
+  path(const uint64_t &part) const;
+
+  /*
+   * Size of encrypted part.
+   */
+  uint64_t
+  size(const uint64_t &part) const;
+
+  uint64_t
+  firstFrame(const uint64_t &part) const;
+
+  /*
+   * Range of source encrypted to part.
+   */
+  uint64_t
+  sourceOffset(const uint64_t &part) const;
+
+  uint64_t
+  sourceSize(const uint64_t &part) const;
+
+  /*
+   * Number of frames in part.
+   */
+  uint64_t
+  frameCount(const uint64_t &part) const;
+
+  bool
+  isLast(const uint64_t &part) const;
+
+private:
+  static std::string
+  partName(const std::string &base, const uint64_t &part,
+           const uint64_t &parts);
+
+  static bool
+  validName(const std::string &name);
+
+  std::filesystem::path dir;
+  uint64_t source_sz = 0;
+  size_t source_frame = 0;
+  size_t encrypted_frame = 0;
+  size_t trailer = 0;
+  uint64_t frames_per_part = 0;
+  uint64_t frames = 0;
+  std::vector<std::string> names;
+};
+
+#endif // PARTSET_H
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ResultFile.h>
+#include <cerrno>
+#include <cstring>
+#include <gcrypt.h>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ResultFile::ResultFile(const std::filesystem::path &result)
+{
+  result_path = result;
+  if(!result.parent_path().empty())
+    {
+      std::filesystem::create_directories(result.parent_path());
+    }
+
+  unsigned char rnd[6];
+  gcry_create_nonce(rnd, sizeof(rnd));
+  std::string suffix = ".";
+  const char *digits = "0123456789abcdef";
+  for(size_t i = 0; i < sizeof(rnd); i++)
+    {
+      suffix.push_back(digits[rnd[i] >> 4]);
+      suffix.push_back(digits[rnd[i] & 0x0f]);
+    }
+  suffix += ".tmp";
+  temp = result.parent_path()
+         / std::filesystem::u8path("." + result.filename().u8string()
+                                   + suffix);
+}
+
+ResultFile::~ResultFile()
+{
+  if(!done)
+    {
+      std::error_code ec;
+      std::filesystem::remove(temp, ec);
+    }
+}
+
+const std::filesystem::path &
+ResultFile::tempPath() const
+{
+  return temp;
+}
+
+const std::filesystem::path &
+ResultFile::result() const
+{
+  return result_path;
+}
+
+void
+ResultFile::commit(const bool &sync)
+{
+  if(sync)
+    {
+      syncFile(temp);
+    }
+  replace(temp, result_path);
+  done = true;
+  if(sync)
+    {
+      syncDirectory(result_path.parent_path());
+    }
+}
+
+void
+ResultFile::discard()
+{
+  std::error_code ec;
+  std::filesystem::remove(temp, ec);
+  done = true;
+}
+
+void
+ResultFile::release()
+{
+  done = true;
+}
+
+void
+ResultFile::syncFile(const std::filesystem::path &p)
+{
+#ifdef _WIN32
+  int fd = _wopen(p.c_str(), _O_RDWR | _O_BINARY);
+  if(fd < 0)
+    {
+      throw std::runtime_error("ResultFile::syncFile: cannot open file");
+    }
+  int res = _commit(fd);
+  _close(fd);
+#else
+  int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      throw std::runtime_error("ResultFile::syncFile: cannot open file: "
+                               + std::string(std::strerror(errno)));
+    }
+  int res = fsync(fd);
+  ::close(fd);
+#endif
+  if(res != 0)
+    {
+      throw std::runtime_error("ResultFile::syncFile: " + p.u8string()
+                               + ": " + std::string(std::strerror(errno)));
+    }
+}
+
+void
+ResultFile::startSync(const std::filesystem::path &p)
+{
+#ifdef __linux__
+  int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd >= 0)
+    {
+      // Only a hint, errors are reported by following syncFile().
+      sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+      ::close(fd);
+    }
+#else
+  static_cast<void>(p);
+#endif
+}
+
+void
+ResultFile::syncDirectory(const std::filesystem::path &p)
+{
+#ifndef _WIN32
+  std::filesystem::path dir = p.empty() ? std::filesystem::path(".") : p;
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      throw std::runtime_error("ResultFile::syncDirectory: cannot open "
+                               "directory: "
+                               + std::string(std::strerror(errno)));
+    }
+  int res = fsync(fd);
+  ::close(fd);
+  if(res != 0)
+    {
+      throw std::runtime_error("ResultFile::syncDirectory: "
+                               + std::string(std::strerror(errno)));
+    }
+#else
+  static_cast<void>(p);
+#endif
+}
+
+void
+ResultFile::replace(const std::filesystem::path &temp,
+                    const std::filesystem::path &result)
+{
+  // Directory can not be replaced by rename.
+  std::error_code ec;
+  if(std::filesystem::is_directory(
+         std::filesystem::symlink_status(result, ec)))
+    {
+      std::filesystem::remove_all(result);
+    }
+  std::filesystem::rename(temp, result);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTFILE_H
+#define RESULTFILE_H
+
+#include <filesystem>
+
+/*
+ * Resulting file of operation. Data is written to temporary file next to
+ * result (same directory, so rename is atomic), which replaces result only
+ * when operation succeeds, so failed or interrupted operation never leaves
+ * partially written file in place of previous one. Temporary file is removed
+ * by destructor if it has been neither committed nor released.
+ */
+class ResultFile
+{
+public:
+  ResultFile(const std::filesystem::path &result);
+
+  ResultFile(const ResultFile &other) = delete;
+
+  ResultFile &
+  operator=(const ResultFile &other)
+      = delete;
+
+  ~ResultFile();
+
+  /*
+   * Path data must be written to.
+   */
+  const std::filesystem::path &
+  tempPath() const;
+
+  /*
+   * Path of result.
+   */
+  const std::filesystem::path &
+  result() const;
+
+  /*
+   * Replaces result by temporary file. If sync is true, data is flushed to
+   * storage before rename and directory entry after it.
+   */
+  void
+  commit(const bool &sync);
+
+  /*
+   * Removes temporary file.
+   */
+  void
+  discard();
+
+  /*
+   * Temporary file is not removed by destructor any more (it has been passed
+   * to batch commit).
+   */
+  void
+  release();
+
+  /*
+   * Flushes file data to storage.
+   */
+  static void
+  syncFile(const std::filesystem::path &p);
+
+  /*
+   * Starts writeback of file data without waiting for it (Linux only), so
+   * following syncFile() of several files are cheap.
+   */
+  static void
+  startSync(const std::filesystem::path &p);
+
+  /*
+   * Flushes directory entries (has no effect on Windows).
+   */
+  static void
+  syncDirectory(const std::filesystem::path &p);
+
+  /*
+   * Replaces result by temporary file without syncing.
+   */
+  static void
+  replace(const std::filesystem::path &temp,
+          const std::filesystem::path &result);
+
+private:
+  std::filesystem::path result_path;
+  std::filesystem::path temp;
+  bool done = false;
+};
+
+#endif // RESULTFILE_H
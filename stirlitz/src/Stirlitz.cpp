@@ -14,12 +14,25 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <ArmorFileIO.h>
+#include <BufferPool.h>
+#include <FileIO.h>
+#include <FramePipeline.h>
+#include <HoleMap.h>
+#include <JobPool.h>
+#include <MemoryBudget.h>
+#include <PartSet.h>
+#include <ResultFile.h>
 #include <Stirlitz.h>
+#include <StirlitzHash.h>
+#include <StirlitzStream.h>
+#include <StreamFileIO.h>
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
@@ -32,6 +45,50 @@
 
 Stirlitz::Stirlitz()
 {
+  initGcrypt(32768);
+  buffers = std::unique_ptr<BufferPool>(new BufferPool(67108864));
+}
+
+Stirlitz::Stirlitz(const size_t &secmem_size)
+{
+  initGcrypt(secmem_size);
+  buffers = std::unique_ptr<BufferPool>(new BufferPool(67108864));
+}
+
+Stirlitz::~Stirlitz()
+{
+  pool.reset();
+  std::vector<uint64_t> pending;
+  for(auto it = batches.begin(); it != batches.end(); it++)
+    {
+      pending.push_back(it->first);
+    }
+  for(auto it = pending.begin(); it != pending.end(); it++)
+    {
+      try
+        {
+          commitFiles(*it);
+        }
+      catch(std::exception &er)
+        {
+#ifndef __ANDROID__
+          std::cout << er.what() << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME, "%s", er.what());
+#endif
+        }
+    }
+  for(auto it = handles.begin(); it != handles.end(); it++)
+    {
+      gcry_cipher_close(*it);
+    }
+}
+
+void
+Stirlitz::initGcrypt(const size_t &secmem_size)
+{
+  static std::mutex init_mtx;
+  std::lock_guard<std::mutex> lglock(init_mtx);
   gcry_error_t err = gcry_control(GCRYCTL_INITIALIZATION_FINISHED_P, 0);
   if(!err)
     {
@@ -55,13 +112,13 @@ Stirlitz::Stirlitz()
       const char *ver = gcry_check_version(NULL);
       if(ver)
         {
-          err = gcry_control(GCRYCTL_INIT_SECMEM, 32768);
+          err = gcry_control(GCRYCTL_INIT_SECMEM, secmem_size);
           if(err != 0)
             {
               printGcryptError(
                   err, "strilitz: libgcrypt secmem initialization error");
             }
-          err = gcry_control(GCRYCTL_AUTO_EXPAND_SECMEM, 32768);
+          err = gcry_control(GCRYCTL_AUTO_EXPAND_SECMEM, secmem_size);
           if(err != 0)
             {
               printGcryptError(
@@ -122,6 +179,195 @@ Stirlitz::hashString(const std::string &data, const int &algo)
   return result;
 }
 
+std::vector<unsigned char>
+Stirlitz::hashFile(const std::filesystem::path &source_file, const int &algo)
+{
+  return hashFile(source_file, algo, FileOptions());
+}
+
+std::vector<unsigned char>
+Stirlitz::hashFile(const std::filesystem::path &source_file, const int &algo,
+                   const FileOptions &options)
+{
+  size_t buf_sz = frameSize(options, "Stirlitz::hashFile:");
+  StirlitzHash hsh(algo);
+
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("Stirlitz::hashFile: cannot open file");
+    }
+
+  uint64_t fsz = f_source->size();
+  uint64_t read_b = 0;
+  std::function<size_t(unsigned char *)> read_func
+      = [&f_source, buf_sz, &read_b](unsigned char *buf)
+    {
+      size_t sz = f_source->read(buf, buf_sz);
+      read_b += sz;
+      return sz;
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [&hsh](unsigned char *buf, const size_t &len)
+    {
+      hsh.update(buf, len);
+    };
+
+  if(options.threads > 1 && MemoryBudget(options).depth() > 1)
+    {
+      // Hash function is sequential, so only reading is moved to separate
+      // thread (data is hashed by writer in file order).
+      FramePipeline pipeline(1, 2, buf_sz, buffers.get(),
+                             options.memory_budget);
+      pipeline.run(read_func,
+                   [](unsigned char *, const size_t &, const uint64_t &,
+                      const size_t &)
+                     {
+                     },
+                   write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(buf_sz, options.memory_budget);
+      size_t sz;
+      for(;;)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          write_func(buf.get(), sz);
+        }
+    }
+
+  if(read_b != fsz)
+    {
+      throw std::runtime_error("Stirlitz::hashFile: file read error");
+    }
+
+  return hsh.result();
+}
+
+std::vector<unsigned char>
+Stirlitz::hashFileTree(const std::filesystem::path &source_file,
+                       const int &algo, const size_t &leaf_size,
+                       const FileOptions &options)
+{
+  if(leaf_size == 0)
+    {
+      throw std::runtime_error("Stirlitz::hashFileTree: incorrect leaf size");
+    }
+
+  StirlitzHash root(algo);
+  size_t hsh_sz = root.size();
+  size_t buf_sz = std::max(leaf_size, hsh_sz);
+
+  // Leaves take place of frames in memory budget.
+  FileOptions loc_options = options;
+  loc_options.frame_size = buf_sz;
+  MemoryBudget budget(loc_options);
+  if(!budget.fits())
+    {
+      throw std::runtime_error(
+          "Stirlitz::hashFileTree: memory budget is less than leaf size");
+    }
+  size_t workers = budget.workers();
+  std::vector<std::unique_ptr<StirlitzHash>> leaves;
+  for(size_t i = 0; i < workers; i++)
+    {
+      leaves.emplace_back(new StirlitzHash(algo));
+    }
+
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, loc_options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("Stirlitz::hashFileTree: cannot open file");
+    }
+
+  uint64_t fsz = f_source->size();
+  unsigned char hdr[17];
+  hdr[0] = 0x01;
+  for(int i = 0; i < 8; i++)
+    {
+      hdr[1 + i] = static_cast<unsigned char>(
+          (static_cast<uint64_t>(leaf_size) >> (8 * i)) & 0xff);
+      hdr[9 + i] = static_cast<unsigned char>((fsz >> (8 * i)) & 0xff);
+    }
+  root.update(hdr, sizeof(hdr));
+
+  uint64_t read_b = 0;
+  std::function<size_t(unsigned char *)> read_func
+      = [&f_source, leaf_size, &read_b](unsigned char *buf)
+    {
+      size_t sz = f_source->read(buf, leaf_size);
+      read_b += sz;
+      return sz;
+    };
+
+  // Hash summ of leaf replaces leaf content in buffer, writer passes hash
+  // summs to root hash in file order.
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [&leaves, hsh_sz](unsigned char *buf, const size_t &len,
+                                       const uint64_t &, const size_t &worker)
+    {
+      StirlitzHash *leaf = leaves[worker].get();
+      unsigned char leaf_tag = 0x00;
+      leaf->reset();
+      leaf->update(&leaf_tag, 1);
+      leaf->update(buf, len);
+      std::vector<unsigned char> hsh = leaf->result();
+      std::memcpy(buf, hsh.data(), hsh_sz);
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [&root, hsh_sz](unsigned char *buf, const size_t &)
+    {
+      root.update(buf, hsh_sz);
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(), buf_sz,
+                             buffers.get(), options.memory_budget);
+      pipeline.run(read_func, process_func, write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(buf_sz, options.memory_budget);
+      size_t sz;
+      for(;;)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, 0, 0);
+          write_func(buf.get(), sz);
+        }
+    }
+
+  if(read_b != fsz)
+    {
+      throw std::runtime_error("Stirlitz::hashFileTree: file read error");
+    }
+
+  return root.result();
+}
+
 std::string
 Stirlitz::fromHex(const std::string &hex)
 {
@@ -133,19 +379,31 @@ Stirlitz::fromHex(const std::string &hex)
   std::string result;
   result.resize(hex.size() / 2);
 
-  std::locale loc("C");
-  size_t count = 0;
-  for(size_t i = 0; i < hex.size(); i += 2)
+  auto hexValue = [](const char &ch)
     {
-      std::string tmp(hex.begin() + i, hex.begin() + i + 2);
-      std::stringstream strm;
-      strm.imbue(loc);
-      strm.str(tmp);
-      int val;
-      strm >> std::hex >> val;
-      uint8_t val8 = static_cast<uint8_t>(val);
-      std::memcpy(&result[count], &val8, sizeof(val8));
-      count++;
+      if(ch >= '0' && ch <= '9')
+        {
+          return ch - '0';
+        }
+      if(ch >= 'a' && ch <= 'f')
+        {
+          return ch - 'a' + 10;
+        }
+      if(ch >= 'A' && ch <= 'F')
+        {
+          return ch - 'A' + 10;
+        }
+      return -1;
+    };
+  for(size_t i = 0; i < result.size(); i++)
+    {
+      int hi = hexValue(hex[2 * i]);
+      int lo = hexValue(hex[2 * i + 1]);
+      if(hi < 0 || lo < 0)
+        {
+          throw std::runtime_error("Stirlitz::fromHex: incorrect hex value");
+        }
+      result[i] = static_cast<char>((hi << 4) | lo);
     }
 
   return result;
@@ -159,30 +417,17 @@ template <typename T>
 std::string
 Stirlitz::toHex(const T &val)
 {
+  static const char digits[] = "0123456789abcdef";
   std::string result;
   result.resize(val.size() * 2);
   size_t count = 0;
-  std::locale loc("C");
-  std::for_each(val.begin(), val.end(),
-                [&result, &count, loc](auto &el)
-                  {
-                    uint8_t val8;
-                    std::memcpy(&val8, &el, sizeof(el));
-                    std::stringstream strm;
-                    strm.imbue(loc);
-                    strm << std::hex << static_cast<int>(val8);
-                    if(val8 <= 15)
-                      {
-                        result[count] = '0';
-                        result[count + 1] = strm.str()[0];
-                      }
-                    else
-                      {
-                        result[count] = strm.str()[0];
-                        result[count + 1] = strm.str()[1];
-                      }
-                    count += 2;
-                  });
+  for(auto it = val.begin(); it != val.end(); it++)
+    {
+      uint8_t val8 = static_cast<uint8_t>(*it);
+      result[count] = digits[val8 >> 4];
+      result[count + 1] = digits[val8 & 0x0f];
+      count += 2;
+    }
   return result;
 }
 
@@ -231,129 +476,201 @@ Stirlitz::encryptData(const std::string &username, const std::string &password,
                       const std::string &data)
 {
   std::string result;
+  result.resize(data.size() + gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256));
 
-  gcry_cipher_hd_t handle;
+  encryptData(username, password,
+              reinterpret_cast<const unsigned char *>(data.c_str()),
+              data.size(), reinterpret_cast<unsigned char *>(result.data()));
 
-  gcry_error_t err
-      = gcry_cipher_open(&handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
-                         GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
-  if(err != 0)
+  return result;
+}
+
+std::string
+Stirlitz::decryptData(const std::string &username, const std::string &password,
+                      const std::string &data)
+{
+  std::string result;
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  if(data.size() < block_sz)
     {
-      printGcryptError(err, "Stirlitz::encryptData");
+      return result;
     }
+  result.resize(data.size() - block_sz);
+
+  decryptData(username, password,
+              reinterpret_cast<const unsigned char *>(data.c_str()),
+              data.size(), reinterpret_cast<unsigned char *>(result.data()));
+
+  return result;
+}
 
+void
+Stirlitz::encryptData(const std::string &username, const std::string &password,
+                      const unsigned char *data, const size_t &data_sz,
+                      unsigned char *result)
+{
   std::unique_ptr<gcry_cipher_handle,
                   std::function<void(gcry_cipher_handle *)>>
-      hd(handle,
-         [](gcry_cipher_handle *hd)
-           {
-             gcry_cipher_close(hd);
-           });
+      hd = cipherHandle(deriveKey(username, password),
+                        "Stirlitz::encryptData");
+  encryptDataKey(hd.get(), data, data_sz, result);
+}
 
+size_t
+Stirlitz::decryptData(const std::string &username, const std::string &password,
+                      const unsigned char *data, const size_t &data_sz,
+                      unsigned char *result)
+{
   size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
-  std::vector<unsigned char> hash;
-  hash.resize(block_sz);
-  gcry_create_nonce(hash.data(), hash.size());
-
-  err = gcry_cipher_setiv(hd.get(), hash.data(), hash.size());
-  if(err != 0)
+  if(data_sz < block_sz)
     {
-      printGcryptError(err, "Stirlitz::encryptData");
+      return 0;
     }
 
-  std::string pass_str = username + password;
-  hash = hashString(pass_str, GCRY_MD_BLAKE2S_256);
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      hd = cipherHandle(deriveKey(username, password),
+                        "Stirlitz::decryptData");
+  return decryptDataKey(hd.get(), data, data_sz, result);
+}
 
-  err = gcry_cipher_setkey(hd.get(), hash.data(), hash.size());
-  if(err != 0)
+std::string
+Stirlitz::encryptData(const StirlitzSessionKey &key, const std::string &data)
+{
+  if(key.empty())
     {
-      printGcryptError(err, "Stirlitz::encryptData");
+      throw std::runtime_error("Stirlitz::encryptData: empty session key");
     }
+  std::string result;
+  result.resize(data.size() + gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256));
 
-  std::vector<unsigned char> in;
-  in.reserve(data.size() + block_sz);
-  in.resize(block_sz);
-  gcry_randomize(in.data(), in.size(), GCRY_STRONG_RANDOM);
-
-  in.resize(in.size() + data.size());
-  std::memcpy(in.data() + block_sz, data.c_str(), data.size());
-
-  result.resize(in.size());
-
-  err = gcry_cipher_encrypt(hd.get(),
-                            reinterpret_cast<unsigned char *>(result.data()),
-                            result.size(), in.data(), in.size());
-  if(err != 0)
-    {
-      printGcryptError(err, "Stirlitz::encryptData");
-    }
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      hd = cipherHandle(key.data(), key.size(), "Stirlitz::encryptData");
+  encryptDataKey(hd.get(),
+                 reinterpret_cast<const unsigned char *>(data.c_str()),
+                 data.size(), reinterpret_cast<unsigned char *>(result.data()));
 
   return result;
 }
 
 std::string
-Stirlitz::decryptData(const std::string &username, const std::string &password,
-                      const std::string &data)
+Stirlitz::decryptData(const StirlitzSessionKey &key, const std::string &data)
 {
+  if(key.empty())
+    {
+      throw std::runtime_error("Stirlitz::decryptData: empty session key");
+    }
   std::string result;
   size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
   if(data.size() < block_sz)
     {
       return result;
     }
-
-  gcry_cipher_hd_t handle;
-
-  gcry_error_t err
-      = gcry_cipher_open(&handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
-                         GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
-  if(err != 0)
-    {
-      printGcryptError(err, "Stirlitz::decryptData");
-    }
+  result.resize(data.size() - block_sz);
 
   std::unique_ptr<gcry_cipher_handle,
                   std::function<void(gcry_cipher_handle *)>>
-      hd(handle,
-         [](gcry_cipher_handle *hd)
-           {
-             gcry_cipher_close(hd);
-           });
+      hd = cipherHandle(key.data(), key.size(), "Stirlitz::decryptData");
+  decryptDataKey(hd.get(),
+                 reinterpret_cast<const unsigned char *>(data.c_str()),
+                 data.size(), reinterpret_cast<unsigned char *>(result.data()));
+
+  return result;
+}
 
+void
+Stirlitz::encryptDataKey(gcry_cipher_hd_t hd, const unsigned char *data,
+                         const size_t &data_sz, unsigned char *result)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
   std::vector<unsigned char> hash;
   hash.resize(block_sz);
   gcry_create_nonce(hash.data(), hash.size());
 
-  err = gcry_cipher_setiv(hd.get(), hash.data(), hash.size());
+  gcry_error_t err = gcry_cipher_setiv(hd, hash.data(), hash.size());
   if(err != 0)
     {
-      printGcryptError(err, "Stirlitz::decryptData");
+      printGcryptError(err, "Stirlitz::encryptData");
     }
 
-  std::string pass_str = username + password;
-  hash = hashString(pass_str, GCRY_MD_BLAKE2S_256);
+  // Message is random block followed by data.
+  if(data_sz > block_sz)
+    {
+      // Random block is encrypted separately and data is chained from its
+      // cipher text, so data is encrypted from caller's buffer directly.
+      // Cipher text stealing touches only last two blocks, which both belong
+      // to data here, so result is the same as for whole message.
+      gcry_randomize(result, block_sz, GCRY_STRONG_RANDOM);
+      err = gcry_cipher_encrypt(hd, result, block_sz, nullptr, 0);
+      if(err == 0)
+        {
+          err = gcry_cipher_setiv(hd, result, block_sz);
+        }
+      if(err == 0)
+        {
+          err = gcry_cipher_encrypt(hd, result + block_sz, data_sz,
+                                    data, data_sz);
+        }
+    }
+  else
+    {
+      std::vector<unsigned char> in;
+      in.resize(block_sz);
+      gcry_randomize(in.data(), in.size(), GCRY_STRONG_RANDOM);
+      in.insert(in.end(), data, data + data_sz);
 
-  err = gcry_cipher_setkey(hd.get(), hash.data(), hash.size());
+      err = gcry_cipher_encrypt(hd, result, in.size(), in.data(),
+                                in.size());
+    }
   if(err != 0)
     {
-      printGcryptError(err, "Stirlitz::decryptData");
+      printGcryptError(err, "Stirlitz::encryptData");
     }
+}
 
-  result.resize(data.size());
+size_t
+Stirlitz::decryptDataKey(gcry_cipher_hd_t hd, const unsigned char *data,
+                         const size_t &data_sz, unsigned char *result)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  gcry_error_t err;
+  if(data_sz > 2 * block_sz)
+    {
+      // First block is random, so it is not decrypted at all: its cipher
+      // text is IV for the rest of message.
+      err = gcry_cipher_setiv(hd, data, block_sz);
+      if(err == 0)
+        {
+          err = gcry_cipher_decrypt(hd, result, data_sz - block_sz,
+                                    data + block_sz, data_sz - block_sz);
+        }
+    }
+  else
+    {
+      std::vector<unsigned char> hash;
+      hash.resize(block_sz);
+      gcry_create_nonce(hash.data(), hash.size());
+      err = gcry_cipher_setiv(hd, hash.data(), hash.size());
 
-  err = gcry_cipher_decrypt(
-      hd.get(), reinterpret_cast<unsigned char *>(result.data()),
-      result.size(), reinterpret_cast<const unsigned char *>(data.c_str()),
-      data.size());
+      std::vector<unsigned char> out;
+      out.resize(data_sz);
+      if(err == 0)
+        {
+          err = gcry_cipher_decrypt(hd, out.data(), out.size(), data,
+                                    data_sz);
+        }
+      if(err == 0)
+        {
+          std::memcpy(result, out.data() + block_sz, data_sz - block_sz);
+        }
+    }
   if(err != 0)
     {
       printGcryptError(err, "Stirlitz::decryptData");
     }
 
-  result.erase(result.begin(), result.begin() + block_sz);
-  result.shrink_to_fit();
-
-  return result;
+  return data_sz - block_sz;
 }
 
 void
@@ -361,629 +678,1159 @@ Stirlitz::encryptFile(const std::filesystem::path &source_file,
                       const std::filesystem::path &result,
                       const std::string &username, const std::string &password)
 {
-  gcry_cipher_hd_t handle;
+  encryptFile(source_file, result, username, password, FileOptions());
+}
 
-  gcry_error_t err
-      = gcry_cipher_open(&handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
-                         GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
-  if(err != 0)
-    {
-      printGcryptError(err, "Stirlitz::encryptFile:");
-    }
+void
+Stirlitz::encryptFile(const std::filesystem::path &source_file,
+                      const std::filesystem::path &result,
+                      const std::string &username, const std::string &password,
+                      const FileOptions &options)
+{
+  encryptFileKey(source_file, result, deriveKey(username, password), options,
+                 nullptr);
+}
 
-  std::unique_ptr<gcry_cipher_handle,
-                  std::function<void(gcry_cipher_handle *)>>
-      hd(handle,
-         [](gcry_cipher_handle *hd)
-           {
-             gcry_cipher_close(hd);
-           });
+void
+Stirlitz::decryptFile(const std::filesystem::path &source_file,
+                      const std::filesystem::path &result,
+                      const std::string &username, const std::string &password)
+{
+  decryptFile(source_file, result, username, password, FileOptions());
+}
 
-  std::string pass_str = username + password;
-  std::vector<unsigned char> hash = hashString(pass_str, GCRY_MD_BLAKE2S_256);
+void
+Stirlitz::decryptFile(const std::filesystem::path &source_file,
+                      const std::filesystem::path &result,
+                      const std::string &username, const std::string &password,
+                      const FileOptions &options)
+{
+  decryptFileKey(source_file, result, deriveKey(username, password), options,
+                 nullptr);
+}
 
-  err = gcry_cipher_setkey(hd.get(), hash.data(), hash.size());
-  if(err != 0)
+void
+Stirlitz::encryptStream(std::istream &source, std::ostream &result,
+                        const std::string &username,
+                        const std::string &password)
+{
+  encryptStream(source, result, username, password, FileOptions());
+}
+
+void
+Stirlitz::encryptStream(std::istream &source, std::ostream &result,
+                        const std::string &username,
+                        const std::string &password,
+                        const FileOptions &options)
+{
+  if((options.armor || options.sparse) && options.integrity)
     {
-      printGcryptError(err, "Stirlitz::encryptFile:");
+      throw std::runtime_error("Stirlitz::encryptStream: integrity tags can "
+                               "not be used with armor and sparse files");
     }
-
-  std::fstream f_source;
-  f_source.open(source_file, std::ios_base::in | std::ios_base::binary);
-  if(!f_source.is_open())
+  StreamFileIO f_source(&source);
+  StreamFileIO f_result(&result);
+  ArmorFileIO f_armor(&f_result, FileIO::Write, options.armor_encoding);
+  FileIO *out = options.armor ? static_cast<FileIO *>(&f_armor) : &f_result;
+  if(options.sparse)
     {
-      throw std::runtime_error(
-          "Stirlitz::encryptFile: cannot open source file");
+      encryptSparseIO(&f_source, nullptr, 0, out,
+                      deriveKey(username, password), options,
+                      "Stirlitz::encryptStream:", nullptr);
     }
-
-  std::filesystem::create_directories(result.parent_path());
-  std::filesystem::remove_all(result);
-  std::fstream f_result;
-  f_result.open(result, std::ios_base::out | std::ios_base::binary);
-  if(!f_result.is_open())
+  else
     {
-      f_source.close();
-      throw std::runtime_error(
-          "Stirlitz::encryptFile: cannot write to resulting file");
+      encryptIO(&f_source, out, deriveKey(username, password), options,
+                "Stirlitz::encryptStream:", FrameRange(), nullptr);
     }
-
-  size_t fsz;
-  f_source.seekg(0, std::ios_base::end);
-  fsz = f_source.tellg();
-  f_source.seekg(0, std::ios_base::beg);
-
-  if(fsz == 0)
+  out->close();
+  if(options.armor)
     {
-      f_source.close();
-      throw std::runtime_error("Stirlitz::encryptFile: incorrect file");
+      f_result.close();
     }
+}
 
-  size_t read_b = 0;
-  size_t buf_sz = 10485744;
-  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
-  std::vector<unsigned char> buf;
-  buf.reserve(buf_sz + block_sz);
-  std::vector<unsigned char> result_buf;
-  result_buf.reserve(buf_sz + block_sz);
-
-  size_t dif;
-
-  size_t sz;
+void
+Stirlitz::decryptStream(std::istream &source, std::ostream &result,
+                        const std::string &username,
+                        const std::string &password)
+{
+  decryptStream(source, result, username, password, FileOptions());
+}
 
-  while(read_b < fsz)
-    {
-      err = gcry_cipher_reset(hd.get());
-      if(err != 0)
-        {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::encryptFile gcry_cipher_reset:");
-        }
-
-      hash.clear();
-      hash.resize(block_sz);
-      gcry_create_nonce(hash.data(), hash.size());
-      err = gcry_cipher_setiv(hd.get(), hash.data(), hash.size());
-      if(err != 0)
-        {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::encryptFile gcry_cipher_setiv:");
-        }
-      buf.clear();
-      dif = fsz - read_b;
-      if(buf_sz < dif)
-        {
-          sz = buf_sz;
-          buf.resize(buf_sz + block_sz);
-        }
-      else
-        {
-          sz = dif;
-          buf.resize(dif + block_sz);
-        }
-      gcry_create_nonce(buf.data(), block_sz);
-      f_source.read(reinterpret_cast<char *>(buf.data() + block_sz), sz);
-      read_b += sz;
-
-      result_buf.clear();
-      result_buf.resize(buf.size());
-
-      err = gcry_cipher_encrypt(hd.get(), result_buf.data(), result_buf.size(),
-                                buf.data(), buf.size());
-      if(err != 0)
-        {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::encryptFile:");
-        }
-      f_result.write(reinterpret_cast<char *>(result_buf.data()),
-                     result_buf.size());
+void
+Stirlitz::decryptStream(std::istream &source, std::ostream &result,
+                        const std::string &username,
+                        const std::string &password,
+                        const FileOptions &options)
+{
+  if(options.integrity)
+    {
+      throw std::runtime_error("Stirlitz::decryptStream: integrity tags can "
+                               "be checked only for files");
+    }
+  StreamFileIO f_source(&source);
+  StreamFileIO f_result(&result);
+  ArmorFileIO f_armor(&f_source, FileIO::Read, options.armor_encoding);
+  FileIO *in = options.armor ? static_cast<FileIO *>(&f_armor) : &f_source;
+  if(options.sparse)
+    {
+      decryptSparseIO(in, &f_result, deriveKey(username, password), options,
+                      "Stirlitz::decryptStream:", nullptr);
+    }
+  else
+    {
+      decryptIO(in, &f_result, deriveKey(username, password), options,
+                "Stirlitz::decryptStream:", 0, FrameRange(), nullptr);
     }
-
-  f_source.close();
   f_result.close();
 }
 
 void
-Stirlitz::decryptFile(const std::filesystem::path &source_file,
-                      const std::filesystem::path &result,
-                      const std::string &username, const std::string &password)
+Stirlitz::encryptFileInPlace(const std::filesystem::path &file,
+                             const std::string &username,
+                             const std::string &password)
 {
-  gcry_cipher_hd_t handle;
+  encryptFileInPlace(file, username, password, FileOptions());
+}
 
-  gcry_error_t err
-      = gcry_cipher_open(&handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
-                         GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
-  if(err != 0)
+void
+Stirlitz::encryptFileInPlace(const std::filesystem::path &file,
+                             const std::string &username,
+                             const std::string &password,
+                             const FileOptions &options)
+{
+  if(options.integrity || options.armor || options.sparse)
     {
-      printGcryptError(err, "Stirlitz::decryptFile:");
+      throw std::runtime_error("Stirlitz::encryptFileInPlace: integrity tags, "
+                               "armor and sparse files are not "
+                               "supported");
     }
-
   std::unique_ptr<gcry_cipher_handle,
                   std::function<void(gcry_cipher_handle *)>>
-      hd(handle,
-         [](gcry_cipher_handle *hd)
-           {
-             gcry_cipher_close(hd);
-           });
+      hd = cipherHandle(deriveKey(username, password),
+                        "Stirlitz::encryptFileInPlace:");
 
-  std::string pass_str = username + password;
-  std::vector<unsigned char> hash = hashString(pass_str, GCRY_MD_BLAKE2S_256);
+  std::error_code ec;
+  uint64_t fsz = std::filesystem::file_size(file, ec);
+  if(ec || fsz == 0)
+    {
+      throw std::runtime_error("Stirlitz::encryptFileInPlace: incorrect file");
+    }
 
-  err = gcry_cipher_setkey(hd.get(), hash.data(), hash.size());
-  if(err != 0)
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz
+      = frameSize(options, "Stirlitz::encryptFileInPlace:") - block_sz;
+  uint64_t frames = fsz / buf_sz;
+  if(fsz % buf_sz != 0)
     {
-      printGcryptError(err, "Stirlitz::decryptFile:");
+      frames++;
     }
 
-  std::fstream f_source;
-  f_source.open(source_file, std::ios_base::in | std::ios_base::binary);
-  if(!f_source.is_open())
+  // File is extended once, then frames are processed from last to first.
+  // Encrypted frame k is written at k * (buf_sz + block_sz), so it can only
+  // overwrite plain text of frames which have already been processed.
+  std::filesystem::resize_file(file, fsz + frames * block_sz);
+
+  std::fstream f;
+  f.open(file, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
     {
+      std::filesystem::resize_file(file, fsz);
       throw std::runtime_error(
-          "Stirlitz::decryptFile: cannot open source file");
+          "Stirlitz::encryptFileInPlace: cannot open file");
     }
 
-  std::filesystem::create_directories(result.parent_path());
-  std::filesystem::remove_all(result);
-  std::fstream f_result;
-  f_result.open(result, std::ios_base::out | std::ios_base::binary);
-  if(!f_result.is_open())
+  std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+      buf = buffers->get(buf_sz + block_sz, options.memory_budget);
+  size_t sz;
+  for(uint64_t i = frames; i > 0; i--)
     {
-      f_source.close();
-      throw std::runtime_error(
-          "Stirlitz::decryptFile: cannot write to resulting file");
+      uint64_t frame = i - 1;
+      sz = static_cast<size_t>(std::min(static_cast<uint64_t>(buf_sz),
+                                        fsz - frame * buf_sz));
+      f.seekg(static_cast<std::streamoff>(frame * buf_sz),
+              std::ios_base::beg);
+      f.read(reinterpret_cast<char *>(buf.get() + block_sz), sz);
+      if(!f.good())
+        {
+          throw std::runtime_error(
+              "Stirlitz::encryptFileInPlace: file read error");
+        }
+
+      encryptFrame(hd.get(), buf.get(), sz + block_sz,
+                   "Stirlitz::encryptFileInPlace:");
+
+      f.seekp(static_cast<std::streamoff>(frame * (buf_sz + block_sz)),
+              std::ios_base::beg);
+      f.write(reinterpret_cast<char *>(buf.get()), sz + block_sz);
+      if(!f.good())
+        {
+          throw std::runtime_error(
+              "Stirlitz::encryptFileInPlace: file write error");
+        }
     }
+  f.close();
+}
+
+void
+Stirlitz::decryptFileInPlace(const std::filesystem::path &file,
+                             const std::string &username,
+                             const std::string &password)
+{
+  decryptFileInPlace(file, username, password, FileOptions());
+}
 
-  size_t fsz;
-  f_source.seekg(0, std::ios_base::end);
-  fsz = f_source.tellg();
-  f_source.seekg(0, std::ios_base::beg);
+void
+Stirlitz::decryptFileInPlace(const std::filesystem::path &file,
+                             const std::string &username,
+                             const std::string &password,
+                             const FileOptions &options)
+{
+  if(options.integrity || options.armor || options.sparse)
+    {
+      throw std::runtime_error("Stirlitz::decryptFileInPlace: integrity tags, "
+                               "armor and sparse files are not "
+                               "supported");
+    }
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      hd = cipherHandle(deriveKey(username, password),
+                        "Stirlitz::decryptFileInPlace:");
 
   size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
-  if(fsz < block_sz)
+  std::error_code ec;
+  uint64_t fsz = std::filesystem::file_size(file, ec);
+  if(ec || fsz < block_sz)
     {
-      f_source.close();
-      throw std::runtime_error("Stirlitz::decryptFile: incorrect file(1)");
+      throw std::runtime_error("Stirlitz::decryptFileInPlace: incorrect file");
+    }
+  if(hasTrailer(file, fsz, deriveKey(username, password), options,
+                "Stirlitz::decryptFileInPlace:"))
+    {
+      throw std::runtime_error(
+          "Stirlitz::decryptFileInPlace: file has integrity tags");
     }
 
-  size_t read_b = 0;
-  size_t buf_sz = 10485760;
-  std::vector<unsigned char> buf;
-  buf.reserve(buf_sz);
-  std::vector<unsigned char> result_buf;
-  result_buf.reserve(buf_sz);
+  size_t buf_sz = frameSize(options, "Stirlitz::decryptFileInPlace:");
+  uint64_t frames = fsz / buf_sz;
+  if(fsz % buf_sz != 0)
+    {
+      frames++;
+    }
+  if(fsz - (frames - 1) * buf_sz < block_sz)
+    {
+      throw std::runtime_error("Stirlitz::decryptFileInPlace: incorrect file");
+    }
 
-  size_t dif;
+  std::fstream f;
+  f.open(file, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error(
+          "Stirlitz::decryptFileInPlace: cannot open file");
+    }
 
-  while(read_b < fsz)
+  // Frames are processed from first to last. Decrypted frame k is written at
+  // k * (buf_sz - block_sz), before beginning of encrypted frame k.
+  std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+      buf = buffers->get(buf_sz, options.memory_budget);
+  size_t sz;
+  for(uint64_t frame = 0; frame < frames; frame++)
     {
-      err = gcry_cipher_reset(hd.get());
-      if(err != 0)
+      sz = static_cast<size_t>(
+          std::min(static_cast<uint64_t>(buf_sz), fsz - frame * buf_sz));
+      f.seekg(static_cast<std::streamoff>(frame * buf_sz), std::ios_base::beg);
+      f.read(reinterpret_cast<char *>(buf.get()), sz);
+      if(!f.good())
         {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::decryptFile gcry_cipher_reset:");
+          throw std::runtime_error(
+              "Stirlitz::decryptFileInPlace: file read error");
         }
 
-      hash.clear();
-      hash.resize(block_sz);
-      gcry_create_nonce(hash.data(), hash.size());
-      err = gcry_cipher_setiv(hd.get(), hash.data(), hash.size());
-      if(err != 0)
-        {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::decryptFile gcry_cipher_setiv:");
-        }
-      buf.clear();
-      dif = fsz - read_b;
-      if(buf_sz < dif)
+      if(frame == 0 && sz >= sparse_magic_sz
+         && std::memcmp(buf.get(), sparse_magic, sparse_magic_sz) == 0)
         {
-          buf.resize(buf_sz);
+          throw std::runtime_error(
+              "Stirlitz::decryptFileInPlace: file is sparse");
         }
-      else
-        {
-          buf.resize(dif);
-        }
-      f_source.read(reinterpret_cast<char *>(buf.data()), buf.size());
-      read_b += buf.size();
 
-      result_buf.clear();
-      result_buf.resize(buf.size());
+      decryptFrame(hd.get(), buf.get(), sz, "Stirlitz::decryptFileInPlace:");
 
-      err = gcry_cipher_decrypt(hd.get(), result_buf.data(), result_buf.size(),
-                                buf.data(), buf.size());
-      if(err != 0)
+      f.seekp(static_cast<std::streamoff>(frame * (buf_sz - block_sz)),
+              std::ios_base::beg);
+      f.write(reinterpret_cast<char *>(buf.get() + block_sz), sz - block_sz);
+      if(!f.good())
         {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          printGcryptError(err, "Stirlitz::decryptFile:");
+          throw std::runtime_error(
+              "Stirlitz::decryptFileInPlace: file write error");
         }
-      if(result_buf.size() < block_sz)
-        {
-          f_source.close();
-          f_result.close();
-          std::filesystem::remove_all(result);
-          throw std::runtime_error("Stirlitz::decryptFile: incorrect file");
-        }
-      f_result.write(reinterpret_cast<char *>(result_buf.data() + block_sz),
-                     result_buf.size() - block_sz);
     }
+  f.close();
 
-  f_source.close();
-  f_result.close();
+  std::filesystem::resize_file(file, fsz - frames * block_sz);
 }
 
-std::string
-Stirlitz::sexpToString(std::shared_ptr<gcry_sexp> exp)
+std::vector<uint64_t>
+Stirlitz::verifyFile(const std::filesystem::path &source_file,
+                     const std::string &username, const std::string &password,
+                     const FileOptions &options)
 {
-  std::string result;
+  if(options.armor || options.sparse)
+    {
+      throw std::runtime_error("Stirlitz::verifyFile: armored and sparse "
+                               "files are not supported");
+    }
+  if(options.part_size != 0)
+    {
+      return verifyParts(source_file, deriveKey(username, password), options,
+                         UINT64_MAX, "Stirlitz::verifyFile:");
+    }
 
-  if(exp)
+  std::unique_ptr<FileIO> f_source;
+  try
     {
-      size_t sz
-          = gcry_sexp_sprint(exp.get(), GCRYSEXP_FMT_DEFAULT, nullptr, 0);
-      result.resize(sz);
-      gcry_sexp_sprint(exp.get(), GCRYSEXP_FMT_DEFAULT, result.data(), sz);
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("Stirlitz::verifyFile: cannot open file");
     }
 
-  return result;
+  return verifyIO(f_source.get(), f_source->size(),
+                  deriveKey(username, password), options, FrameRange(),
+                  "Stirlitz::verifyFile:");
 }
 
-std::shared_ptr<gcry_sexp>
-Stirlitz::sexpFromString(const std::string &data)
+uint64_t
+Stirlitz::encryptFilePart(const std::filesystem::path &source_file,
+                          const std::filesystem::path &result,
+                          const uint64_t &part, const std::string &username,
+                          const std::string &password,
+                          const FileOptions &options)
 {
-  std::shared_ptr<gcry_sexp> result;
-
-  gcry_sexp_t exp;
-  gcry_error_t err = gcry_sexp_new(&exp, data.c_str(), data.size(), 1);
-  if(err != 0)
+  if(options.part_size == 0)
     {
-      printGcryptError(err, "Stirlitz::sexpFromString");
+      throw std::runtime_error("Stirlitz::encryptFilePart: part size is "
+                               "not set");
     }
-
-  result = std::shared_ptr<gcry_sexp>(exp,
-                                      [](gcry_sexp *exp)
-                                        {
-                                          gcry_sexp_release(exp);
-                                        });
-
-  return result;
+  return encryptParts(source_file, result, deriveKey(username, password),
+                      options, part, "Stirlitz::encryptFilePart:", nullptr);
 }
 
-std::string
-Stirlitz::getPublicKeyString(std::shared_ptr<gcry_sexp> key)
+uint64_t
+Stirlitz::decryptFilePart(const std::filesystem::path &source_file,
+                          const std::filesystem::path &result,
+                          const uint64_t &part, const std::string &username,
+                          const std::string &password,
+                          const FileOptions &options)
 {
-  std::string result;
+  return decryptParts(source_file, result, deriveKey(username, password),
+                      options, part, "Stirlitz::decryptFilePart:", nullptr);
+}
 
-  std::string find_str = "public-key";
-  gcry_sexp_t exp
-      = gcry_sexp_find_token(key.get(), find_str.c_str(), find_str.size());
-  if(exp == nullptr)
+std::vector<uint64_t>
+Stirlitz::verifyFilePart(const std::filesystem::path &source_file,
+                         const uint64_t &part, const std::string &username,
+                         const std::string &password,
+                         const FileOptions &options)
+{
+  if(options.armor || options.sparse)
     {
-      return result;
+      throw std::runtime_error("Stirlitz::verifyFilePart: armored and "
+                               "sparse files are not supported");
     }
+  return verifyParts(source_file, deriveKey(username, password), options,
+                     part, "Stirlitz::verifyFilePart:");
+}
 
-  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> val(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+uint64_t
+Stirlitz::partCount(const std::filesystem::path &manifest)
+{
+  try
+    {
+      return PartSet(manifest).count();
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("Stirlitz::partCount: cannot read manifest");
+    }
+}
 
-  exp = gcry_sexp_find_token(val.get(), "q", 1);
-  if(exp == nullptr)
+void
+Stirlitz::encryptFileMulti(
+    const std::filesystem::path &source_file,
+    const std::filesystem::path &result,
+    std::shared_ptr<gcry_sexp> own_key_pair,
+    const std::vector<std::shared_ptr<gcry_sexp>> &recipients,
+    const FileOptions &options)
+{
+  frameSize(options, "Stirlitz::encryptFileMulti:");
+  if(options.armor || options.sparse || options.part_size != 0)
     {
-      return result;
+      throw std::runtime_error("Stirlitz::encryptFileMulti: armor, sparse "
+                               "files and parts are not supported");
+    }
+  if(recipients.empty() || recipients.size() > UINT16_MAX)
+    {
+      throw std::runtime_error(
+          "Stirlitz::encryptFileMulti: incorrect number of recipients");
     }
 
-  val = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+  // Header: "STZM", version (1 byte: 1 - frames without integrity tags, 2 -
+  // with tags), number of recipients (2 bytes), frame size (8 bytes), sender
+  // public key (32 bytes), then for each recipient: fingerprint of public key
+  // (32 bytes) and wrapped data key (40 bytes). Integers are little endian.
+  // Header is followed by frames encrypted by data key.
+  std::vector<unsigned char> data_key(32);
+  gcry_randomize(data_key.data(), data_key.size(), GCRY_STRONG_RANDOM);
+
+  std::string header = "STZM";
+  header.push_back(options.integrity ? 2 : 1);
+  header.push_back(static_cast<char>(recipients.size() & 0xff));
+  header.push_back(static_cast<char>(recipients.size() >> 8));
+  uint64_t frame_sz = options.frame_size;
+  for(int i = 0; i < 8; i++)
+    {
+      header.push_back(static_cast<char>((frame_sz >> (8 * i)) & 0xff));
+    }
+  header += StirlitzKey::fromSexp(own_key_pair).raw();
 
-  size_t len;
-  const char *data = gcry_sexp_nth_data(val.get(), 1, &len);
-  if(data)
+  gcry_cipher_hd_t hd;
+  gcry_error_t err = gcry_cipher_open(
+      &hd, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_AESWRAP, GCRY_CIPHER_SECURE);
+  if(err != 0)
     {
-      std::string loc;
-      loc.resize(len);
-      for(size_t i = 0; i < len; i++)
+      printGcryptError(err, "Stirlitz::encryptFileMulti:");
+    }
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      wrap(hd,
+           [](gcry_cipher_handle *hd)
+             {
+               gcry_cipher_close(hd);
+             });
+  unsigned char wrapped[40];
+  for(auto it = recipients.begin(); it != recipients.end(); it++)
+    {
+      const std::string fingerprint
+          = StirlitzKey::fromSexp(*it).fingerprint();
+      std::vector<unsigned char> kek
+          = wrappingKey(own_key_pair, *it, true);
+      err = gcry_cipher_setkey(wrap.get(), kek.data(), kek.size());
+      if(err == 0)
         {
-          loc[i] = data[i];
+          err = gcry_cipher_encrypt(wrap.get(), wrapped, sizeof(wrapped),
+                                    data_key.data(), data_key.size());
         }
-      result = toHex(loc);
+      if(err != 0)
+        {
+          printGcryptError(err, "Stirlitz::encryptFileMulti:");
+        }
+      header.append(fingerprint.begin(), fingerprint.end());
+      header.append(reinterpret_cast<char *>(wrapped), sizeof(wrapped));
     }
-  else
+
+  std::unique_ptr<FileIO> f_source;
+  try
     {
-      throw std::runtime_error("Stirlitz::getPublicKeyString: incorrect data");
+      f_source = FileIO::open(source_file, FileIO::Read, options);
     }
-
-  return result;
-}
-
-std::shared_ptr<gcry_sexp>
-Stirlitz::generatePublicKeyExp(const std::string &key)
-{
-  if(key.size() != 32)
+  catch(std::exception &er)
     {
       throw std::runtime_error(
-          "Stirlitz::generatePublicKeyExp: incorrect key size");
+          "Stirlitz::encryptFileMulti: cannot open source file");
     }
 
-  std::string sexp_format
-      = "(public-key (ecc (curve Ed25519)(flags eddsa)(q %b)))";
-
-  gcry_sexp_t exp;
-  size_t erroffset = 0;
-  gcry_error_t err = gcry_sexp_build(&exp, &erroffset, sexp_format.c_str(),
-                                     static_cast<int>(key.size()),
-                                     const_cast<char *>(key.data()));
-  if(err != 0)
+  uint64_t fsz = f_source->size();
+  if(fsz == 0)
     {
-      std::string prefix("Stirlitz::generatePublicKeyExp error: ");
-      std::stringstream strm;
-      strm.imbue(std::locale("C"));
-      strm << erroffset;
-      prefix += " byte number " + strm.str();
-      printGcryptError(err, prefix);
+      throw std::runtime_error("Stirlitz::encryptFileMulti: incorrect file");
     }
 
-  std::shared_ptr<gcry_sexp> result(exp,
-                                    [](gcry_sexp *exp)
-                                      {
-                                        gcry_sexp_release(exp);
-                                      });
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(
+          "Stirlitz::encryptFileMulti: cannot write to resulting file");
+    }
 
-  return result;
+  try
+    {
+      if(options.preallocate)
+        {
+          f_result->preallocate(
+              header.size()
+              + encryptedSize(fsz, options, "Stirlitz::encryptFileMulti:"));
+        }
+      f_result->write(reinterpret_cast<const unsigned char *>(header.data()),
+                      header.size());
+      if(encryptIO(f_source.get(), f_result.get(), data_key, options,
+                   "Stirlitz::encryptFileMulti:", FrameRange(), nullptr)
+         != fsz)
+        {
+          throw std::runtime_error(
+              "Stirlitz::encryptFileMulti: source file read error");
+        }
+      f_result->close();
+      commitResult(result_file, options);
+    }
+  catch(std::exception &er)
+    {
+      f_result.reset();
+      result_file.discard();
+      throw;
+    }
 }
 
-std::tuple<std::string, std::string>
-Stirlitz::genUsernamePasswordEncryption(
-    std::shared_ptr<gcry_sexp> own_key_pair,
-    std::shared_ptr<gcry_sexp> opponent_key)
+std::string
+Stirlitz::decryptFileMulti(const std::filesystem::path &source_file,
+                           const std::filesystem::path &result,
+                           std::shared_ptr<gcry_sexp> own_key_pair,
+                           const FileOptions &options)
 {
-  std::tuple<std::string, std::string> result;
-
-  gcry_sexp_t exp;
-  gcry_error_t err
-      = gcry_pk_encrypt(&exp, own_key_pair.get(), own_key_pair.get());
-  if(err)
+  if(options.armor || options.sparse || options.part_size != 0)
     {
-      printGcryptError(err, "Stirlitz::genUsernamePasswordEncryption:");
+      throw std::runtime_error("Stirlitz::decryptFileMulti: armor, sparse "
+                               "files and parts are not supported");
     }
-
-  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> shared(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
-
-  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
-  if(exp == nullptr)
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
     {
       throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: cannot find token(1)");
+          "Stirlitz::decryptFileMulti: cannot open source file");
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+  uint64_t fsz = f_source->size();
 
-  exp = gcry_sexp_find_token(shared.get(), "s", 1);
-  if(exp == nullptr)
+  std::string header;
+  header.resize(47);
+  if(fsz < header.size()
+     || f_source->read(reinterpret_cast<unsigned char *>(header.data()),
+                       header.size())
+            != header.size()
+     || header.compare(0, 4, "STZM") != 0
+     || (header[4] != 1 && header[4] != 2))
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: cannot find token(2)");
+      throw std::runtime_error("Stirlitz::decryptFileMulti: incorrect file");
     }
+  const unsigned char *h
+      = reinterpret_cast<const unsigned char *>(header.data());
+  size_t count = h[5] | (static_cast<size_t>(h[6]) << 8);
+  FileOptions loc_options = options;
+  loc_options.integrity = header[4] == 2;
+  uint64_t frame_sz = 0;
+  for(int i = 0; i < 8; i++)
+    {
+      frame_sz |= static_cast<uint64_t>(h[7 + i]) << (8 * i);
+    }
+  if(frame_sz > 1073741824)
+    {
+      throw std::runtime_error("Stirlitz::decryptFileMulti: incorrect file");
+    }
+  loc_options.frame_size = static_cast<size_t>(frame_sz);
+  frameSize(loc_options, "Stirlitz::decryptFileMulti:");
+  std::string sender = header.substr(15, 32);
+
+  std::string entries;
+  entries.resize(count * 72);
+  if(fsz - header.size() < entries.size()
+     || f_source->read(reinterpret_cast<unsigned char *>(entries.data()),
+                       entries.size())
+            != entries.size())
+    {
+      throw std::runtime_error("Stirlitz::decryptFileMulti: incorrect file");
+    }
+  fsz -= header.size() + entries.size();
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
-
-  size_t sz;
-  const char *s_val = gcry_sexp_nth_data(exp, 1, &sz);
-  if(s_val)
+  const std::string own_fp
+      = StirlitzKey::fromSexp(own_key_pair).fingerprint();
+  size_t pos = entries.size();
+  for(size_t i = 0; i < entries.size(); i += 72)
     {
-      std::get<1>(result).resize(sz);
-      char *data = std::get<1>(result).data();
-      for(size_t i = 0; i < sz; i++)
+      if(entries.compare(i, 32, own_fp) == 0)
         {
-          data[i] = s_val[i];
+          pos = i;
+          break;
         }
     }
-  else
+  if(pos == entries.size())
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: incorrect value(1)");
+      throw std::runtime_error("Stirlitz::decryptFileMulti: file has not "
+                               "been encrypted for given key");
     }
 
-  err = gcry_pk_encrypt(&exp, own_key_pair.get(), opponent_key.get());
-  if(err)
+  gcry_cipher_hd_t hd;
+  gcry_error_t err = gcry_cipher_open(
+      &hd, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_AESWRAP, GCRY_CIPHER_SECURE);
+  if(err != 0)
     {
-      printGcryptError(err, "Stirlitz::genUsernamePasswordEncryption:");
+      printGcryptError(err, "Stirlitz::decryptFileMulti:");
     }
-
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
-
-  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
-  if(exp == nullptr)
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      wrap(hd,
+           [](gcry_cipher_handle *hd)
+             {
+               gcry_cipher_close(hd);
+             });
+  std::vector<unsigned char> kek = wrappingKey(
+      own_key_pair, generatePublicKeyExp(sender), false);
+  std::vector<unsigned char> data_key(32);
+  err = gcry_cipher_setkey(wrap.get(), kek.data(), kek.size());
+  if(err == 0)
+    {
+      err = gcry_cipher_decrypt(wrap.get(), data_key.data(), data_key.size(),
+                                entries.data() + pos + 32, 40);
+    }
+  if(err != 0)
     {
       throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: cannot find token(3)");
+          "Stirlitz::decryptFileMulti: cannot unwrap data key");
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  if(fsz < block_sz)
+    {
+      throw std::runtime_error("Stirlitz::decryptFileMulti: incorrect file");
+    }
 
-  exp = gcry_sexp_find_token(shared.get(), "s", 1);
-  if(exp == nullptr)
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              loc_options);
+    }
+  catch(std::exception &er)
     {
       throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: cannot find token(4)");
+          "Stirlitz::decryptFileMulti: cannot write to resulting file");
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
-
-  s_val = gcry_sexp_nth_data(exp, 1, &sz);
-  if(s_val)
+  try
     {
-      std::get<0>(result).resize(sz);
-      char *data = std::get<0>(result).data();
-      for(size_t i = 0; i < sz; i++)
+      uint64_t result_sz = decryptedSize(fsz, loc_options,
+                                         "Stirlitz::decryptFileMulti:");
+      if(loc_options.preallocate && result_sz > 0)
         {
-          data[i] = s_val[i];
+          f_result->preallocate(result_sz);
+        }
+      if(decryptIO(f_source.get(), f_result.get(), data_key, loc_options,
+                   "Stirlitz::decryptFileMulti:", fsz, FrameRange(),
+                   nullptr)
+         != fsz)
+        {
+          throw std::runtime_error(
+              "Stirlitz::decryptFileMulti: source file read error");
         }
+      f_result->close();
+      commitResult(result_file, options);
     }
-  else
+  catch(std::exception &er)
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordEncryption: incorrect value(2)");
+      f_result.reset();
+      result_file.discard();
+      throw;
     }
 
-  return result;
+  return sender;
 }
 
-std::tuple<std::string, std::string>
-Stirlitz::genUsernamePasswordDecryption(
-    std::shared_ptr<gcry_sexp> own_key_pair,
-    std::shared_ptr<gcry_sexp> opponent_key)
+uint64_t
+Stirlitz::newBatch()
 {
-  std::tuple<std::string, std::string> result;
+  std::lock_guard<std::mutex> lglock(batch_mtx);
+  return ++last_batch;
+}
 
-  gcry_sexp_t exp;
-  gcry_error_t err
-      = gcry_pk_encrypt(&exp, own_key_pair.get(), own_key_pair.get());
-  if(err)
+void
+Stirlitz::commitFiles()
+{
+  commitFiles(0);
+}
+
+void
+Stirlitz::commitFiles(const uint64_t &batch)
+{
+  std::vector<std::tuple<std::filesystem::path, std::filesystem::path>>
+      files;
+  std::unique_lock<std::mutex> ulock(batch_mtx);
+  auto it_b = batches.find(batch);
+  if(it_b != batches.end())
     {
-      printGcryptError(err, "Stirlitz::genUsernamePasswordDecryption:");
+      files.swap(it_b->second);
+      batches.erase(it_b);
     }
+  ulock.unlock();
 
-  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> shared(
-      exp,
-      [](gcry_sexp *exp)
+  std::string errors;
+  std::vector<std::filesystem::path> dirs;
+  // Writeback of all files has been started already, so flushing them one by
+  // one mostly waits for the same storage flush.
+  for(auto it = files.begin(); it != files.end(); it++)
+    {
+      try
         {
-          gcry_sexp_release(exp);
-        });
+          ResultFile::syncFile(std::get<0>(*it));
+          ResultFile::replace(std::get<0>(*it), std::get<1>(*it));
+          std::filesystem::path dir = std::get<1>(*it).parent_path();
+          if(std::find(dirs.begin(), dirs.end(), dir) == dirs.end())
+            {
+              dirs.push_back(dir);
+            }
+        }
+      catch(std::exception &er)
+        {
+          std::error_code ec;
+          std::filesystem::remove(std::get<0>(*it), ec);
+          errors += " " + std::get<1>(*it).u8string() + ": " + er.what();
+        }
+    }
 
-  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
-  if(exp == nullptr)
+  for(auto it = dirs.begin(); it != dirs.end(); it++)
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: cannot find token(1)");
+      try
+        {
+          ResultFile::syncDirectory(*it);
+        }
+      catch(std::exception &er)
+        {
+          errors += " " + it->u8string() + ": " + er.what();
+        }
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+  if(!errors.empty())
+    {
+      throw std::runtime_error("Stirlitz::commitFiles:" + errors);
+    }
+}
 
-  exp = gcry_sexp_find_token(shared.get(), "s", 1);
-  if(exp == nullptr)
+void
+Stirlitz::setJobThreads(const size_t &threads)
+{
+  std::lock_guard<std::mutex> lglock(pool_mtx);
+  if(pool)
     {
       throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: cannot find token(2)");
+          "Stirlitz::setJobThreads: pool has already been created");
     }
+  job_threads = threads;
+}
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
+std::shared_ptr<StirlitzJob>
+Stirlitz::encryptFileAsync(const std::filesystem::path &source_file,
+                           const std::filesystem::path &result,
+                           const std::string &username,
+                           const std::string &password,
+                           const FileOptions &options,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  frameSize(options, "Stirlitz::encryptFileAsync:");
+  std::vector<unsigned char> key = deriveKey(username, password);
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, source_file, result, key, options](StirlitzJob &job)
         {
-          gcry_sexp_release(exp);
-        });
+          encryptFileKey(source_file, result, key, options, &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
 
-  size_t sz;
-  const char *s_val = gcry_sexp_nth_data(exp, 1, &sz);
-  if(s_val)
-    {
-      std::get<0>(result).resize(sz);
-      char *data = std::get<0>(result).data();
-      for(size_t i = 0; i < sz; i++)
+std::shared_ptr<StirlitzJob>
+Stirlitz::decryptFileAsync(const std::filesystem::path &source_file,
+                           const std::filesystem::path &result,
+                           const std::string &username,
+                           const std::string &password,
+                           const FileOptions &options,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  frameSize(options, "Stirlitz::decryptFileAsync:");
+  std::vector<unsigned char> key = deriveKey(username, password);
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, source_file, result, key, options](StirlitzJob &job)
         {
-          data[i] = s_val[i];
-        }
-    }
-  else
+          decryptFileKey(source_file, result, key, options, &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+void
+Stirlitz::encryptFileToText(const std::filesystem::path &source_file,
+                            const std::filesystem::path &result,
+                            const std::string &username,
+                            const std::string &password)
+{
+  StirlitzStream strm(*this, StirlitzStream::Encrypt, username, password);
+  textFile(&strm, true, source_file, result, "Stirlitz::encryptFileToText:",
+           nullptr);
+}
+
+void
+Stirlitz::decryptFileFromText(const std::filesystem::path &source_file,
+                              const std::filesystem::path &result,
+                              const std::string &username,
+                              const std::string &password)
+{
+  StirlitzStream strm(*this, StirlitzStream::Decrypt, username, password);
+  textFile(&strm, false, source_file, result,
+           "Stirlitz::decryptFileFromText:", nullptr);
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::encryptFileToTextAsync(const std::filesystem::path &source_file,
+                                 const std::filesystem::path &result,
+                                 const std::string &username,
+                                 const std::string &password,
+                                 const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzStream> strm = std::make_shared<StirlitzStream>(
+      *this, StirlitzStream::Encrypt, username, password);
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, strm, source_file, result](StirlitzJob &job)
+        {
+          textFile(strm.get(), true, source_file, result,
+                   "Stirlitz::encryptFileToTextAsync:", &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::decryptFileFromTextAsync(const std::filesystem::path &source_file,
+                                   const std::filesystem::path &result,
+                                   const std::string &username,
+                                   const std::string &password,
+                                   const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzStream> strm = std::make_shared<StirlitzStream>(
+      *this, StirlitzStream::Decrypt, username, password);
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, strm, source_file, result](StirlitzJob &job)
+        {
+          textFile(strm.get(), false, source_file, result,
+                   "Stirlitz::decryptFileFromTextAsync:", &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::encryptFileToTextAsync(const std::filesystem::path &source_file,
+                                 const std::filesystem::path &result,
+                                 std::shared_ptr<gcry_sexp> own_key_pair,
+                                 std::shared_ptr<gcry_sexp> other_key,
+                                 const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, own_key_pair, other_key, source_file, result](StirlitzJob &job)
+        {
+          std::tuple<std::string, std::string> cred
+              = genUsernamePasswordEncryption(own_key_pair, other_key);
+          StirlitzStream strm(*this, StirlitzStream::Encrypt,
+                              std::get<0>(cred), std::get<1>(cred));
+          textFile(&strm, true, source_file, result,
+                   "Stirlitz::encryptFileToTextAsync:", &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::decryptFileFromTextAsync(const std::filesystem::path &source_file,
+                                   const std::filesystem::path &result,
+                                   std::shared_ptr<gcry_sexp> own_key_pair,
+                                   std::shared_ptr<gcry_sexp> other_key,
+                                   const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [this, own_key_pair, other_key, source_file, result](StirlitzJob &job)
+        {
+          std::tuple<std::string, std::string> cred
+              = genUsernamePasswordDecryption(own_key_pair, other_key);
+          StirlitzStream strm(*this, StirlitzStream::Decrypt,
+                              std::get<0>(cred), std::get<1>(cred));
+          textFile(&strm, false, source_file, result,
+                   "Stirlitz::decryptFileFromTextAsync:", &job);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::encryptDataAsync(const std::string &username,
+                           const std::string &password, std::string data,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzStream> strm = std::make_shared<StirlitzStream>(
+      *this, StirlitzStream::Encrypt, username, password);
+  std::shared_ptr<std::string> source
+      = std::make_shared<std::string>(std::move(data));
+  return dataAsync(
+      [strm, source](std::string &data)
+        {
+          data = std::move(*source);
+          return strm;
+        },
+      callbacks);
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::decryptDataAsync(const std::string &username,
+                           const std::string &password, std::string data,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzStream> strm = std::make_shared<StirlitzStream>(
+      *this, StirlitzStream::Decrypt, username, password);
+  std::shared_ptr<std::string> source
+      = std::make_shared<std::string>(std::move(data));
+  return dataAsync(
+      [strm, source](std::string &data)
+        {
+          data = std::move(*source);
+          return strm;
+        },
+      callbacks);
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::encryptDataAsync(std::shared_ptr<gcry_sexp> own_key_pair,
+                           std::shared_ptr<gcry_sexp> other_key,
+                           std::function<std::string()> data,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  return dataAsync(
+      [this, own_key_pair, other_key, data](std::string &source)
+        {
+          std::tuple<std::string, std::string> cred
+              = genUsernamePasswordEncryption(own_key_pair, other_key);
+          source = data();
+          return std::make_shared<StirlitzStream>(
+              *this, StirlitzStream::Encrypt, std::get<0>(cred),
+              std::get<1>(cred));
+        },
+      callbacks);
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::decryptTextAsync(std::shared_ptr<gcry_sexp> own_key_pair,
+                           std::shared_ptr<gcry_sexp> other_key,
+                           std::function<std::string()> text,
+                           const StirlitzJob::Callbacks &callbacks)
+{
+  return dataAsync(
+      [this, own_key_pair, other_key, text](std::string &source)
+        {
+          std::tuple<std::string, std::string> cred
+              = genUsernamePasswordDecryption(own_key_pair, other_key);
+          // Bare hexadecimal text and armored text are both accepted.
+          std::string txt = text();
+          StirlitzArmor armor(StirlitzArmor::Decode, StirlitzArmor::Hex);
+          armor.update(reinterpret_cast<const unsigned char *>(txt.c_str()),
+                       txt.size(), source);
+          armor.finish(source);
+          return std::make_shared<StirlitzStream>(
+              *this, StirlitzStream::Decrypt, std::get<0>(cred),
+              std::get<1>(cred));
+        },
+      callbacks);
+}
+
+std::string
+Stirlitz::sexpToString(std::shared_ptr<gcry_sexp> exp)
+{
+  std::string result;
+
+  if(exp)
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: incorrect value(1)");
+      size_t sz
+          = gcry_sexp_sprint(exp.get(), GCRYSEXP_FMT_DEFAULT, nullptr, 0);
+      result.resize(sz);
+      gcry_sexp_sprint(exp.get(), GCRYSEXP_FMT_DEFAULT, result.data(), sz);
     }
 
-  err = gcry_pk_encrypt(&exp, own_key_pair.get(), opponent_key.get());
-  if(err)
+  return result;
+}
+
+std::shared_ptr<gcry_sexp>
+Stirlitz::sexpFromString(const std::string &data)
+{
+  std::shared_ptr<gcry_sexp> result;
+
+  gcry_sexp_t exp;
+  gcry_error_t err = gcry_sexp_new(&exp, data.c_str(), data.size(), 1);
+  if(err != 0)
     {
-      printGcryptError(err, "Stirlitz::genUsernamePasswordDecryption:");
+      printGcryptError(err, "Stirlitz::sexpFromString");
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
-      exp,
-      [](gcry_sexp *exp)
-        {
-          gcry_sexp_release(exp);
-        });
+  result = std::shared_ptr<gcry_sexp>(exp,
+                                      [](gcry_sexp *exp)
+                                        {
+                                          gcry_sexp_release(exp);
+                                        });
 
-  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
+  return result;
+}
+
+std::string
+Stirlitz::getPublicKeyString(std::shared_ptr<gcry_sexp> key)
+{
+  std::string result;
+
+  std::string find_str = "public-key";
+  gcry_sexp_t exp
+      = gcry_sexp_find_token(key.get(), find_str.c_str(), find_str.size());
   if(exp == nullptr)
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: cannot find token(3)");
+      return result;
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> val(
       exp,
       [](gcry_sexp *exp)
         {
           gcry_sexp_release(exp);
         });
 
-  exp = gcry_sexp_find_token(shared.get(), "s", 1);
+  exp = gcry_sexp_find_token(val.get(), "q", 1);
   if(exp == nullptr)
     {
-      throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: cannot find token(4)");
+      return result;
     }
 
-  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+  val = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
       exp,
       [](gcry_sexp *exp)
         {
           gcry_sexp_release(exp);
         });
 
-  s_val = gcry_sexp_nth_data(exp, 1, &sz);
+  size_t len;
+  const char *data = gcry_sexp_nth_data(val.get(), 1, &len);
+  if(data)
+    {
+      std::string loc;
+      loc.resize(len);
+      for(size_t i = 0; i < len; i++)
+        {
+          loc[i] = data[i];
+        }
+      result = toHex(loc);
+    }
+  else
+    {
+      throw std::runtime_error("Stirlitz::getPublicKeyString: incorrect data");
+    }
+
+  return result;
+}
+
+std::shared_ptr<gcry_sexp>
+Stirlitz::generatePublicKeyExp(const std::string &key)
+{
+  if(key.size() != 32)
+    {
+      throw std::runtime_error(
+          "Stirlitz::generatePublicKeyExp: incorrect key size");
+    }
+
+  std::string sexp_format
+      = "(public-key (ecc (curve Ed25519)(flags eddsa)(q %b)))";
+
+  gcry_sexp_t exp;
+  size_t erroffset = 0;
+  gcry_error_t err = gcry_sexp_build(&exp, &erroffset, sexp_format.c_str(),
+                                     static_cast<int>(key.size()),
+                                     const_cast<char *>(key.data()));
+  if(err != 0)
+    {
+      std::string prefix("Stirlitz::generatePublicKeyExp error: ");
+      std::stringstream strm;
+      strm.imbue(std::locale("C"));
+      strm << erroffset;
+      prefix += " byte number " + strm.str();
+      printGcryptError(err, prefix);
+    }
+
+  std::shared_ptr<gcry_sexp> result(exp,
+                                    [](gcry_sexp *exp)
+                                      {
+                                        gcry_sexp_release(exp);
+                                      });
+
+  return result;
+}
+
+std::tuple<std::string, std::string>
+Stirlitz::genUsernamePasswordEncryption(
+    std::shared_ptr<gcry_sexp> own_key_pair,
+    std::shared_ptr<gcry_sexp> opponent_key)
+{
+  std::tuple<std::string, std::string> result;
+
+  gcry_sexp_t exp;
+  gcry_error_t err
+      = gcry_pk_encrypt(&exp, own_key_pair.get(), own_key_pair.get());
+  if(err)
+    {
+      printGcryptError(err, "Stirlitz::genUsernamePasswordEncryption:");
+    }
+
+  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> shared(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordEncryption: cannot find token(1)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "s", 1);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordEncryption: cannot find token(2)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  size_t sz;
+  const char *s_val = gcry_sexp_nth_data(exp, 1, &sz);
   if(s_val)
     {
       std::get<1>(result).resize(sz);
@@ -996,12 +1843,2040 @@ Stirlitz::genUsernamePasswordDecryption(
   else
     {
       throw std::runtime_error(
-          "Stirlitz::genUsernamePasswordDecryption: incorrect value(2)");
+          "Stirlitz::genUsernamePasswordEncryption: incorrect value(1)");
+    }
+
+  err = gcry_pk_encrypt(&exp, own_key_pair.get(), opponent_key.get());
+  if(err)
+    {
+      printGcryptError(err, "Stirlitz::genUsernamePasswordEncryption:");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordEncryption: cannot find token(3)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "s", 1);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordEncryption: cannot find token(4)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  s_val = gcry_sexp_nth_data(exp, 1, &sz);
+  if(s_val)
+    {
+      std::get<0>(result).resize(sz);
+      char *data = std::get<0>(result).data();
+      for(size_t i = 0; i < sz; i++)
+        {
+          data[i] = s_val[i];
+        }
+    }
+  else
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordEncryption: incorrect value(2)");
     }
 
   return result;
 }
 
+std::tuple<std::string, std::string>
+Stirlitz::genUsernamePasswordDecryption(
+    std::shared_ptr<gcry_sexp> own_key_pair,
+    std::shared_ptr<gcry_sexp> opponent_key)
+{
+  std::tuple<std::string, std::string> result;
+
+  gcry_sexp_t exp;
+  gcry_error_t err
+      = gcry_pk_encrypt(&exp, own_key_pair.get(), own_key_pair.get());
+  if(err)
+    {
+      printGcryptError(err, "Stirlitz::genUsernamePasswordDecryption:");
+    }
+
+  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> shared(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: cannot find token(1)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "s", 1);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: cannot find token(2)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  size_t sz;
+  const char *s_val = gcry_sexp_nth_data(exp, 1, &sz);
+  if(s_val)
+    {
+      std::get<0>(result).resize(sz);
+      char *data = std::get<0>(result).data();
+      for(size_t i = 0; i < sz; i++)
+        {
+          data[i] = s_val[i];
+        }
+    }
+  else
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: incorrect value(1)");
+    }
+
+  err = gcry_pk_encrypt(&exp, own_key_pair.get(), opponent_key.get());
+  if(err)
+    {
+      printGcryptError(err, "Stirlitz::genUsernamePasswordDecryption:");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "ecdh", 4);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: cannot find token(3)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  exp = gcry_sexp_find_token(shared.get(), "s", 1);
+  if(exp == nullptr)
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: cannot find token(4)");
+    }
+
+  shared = std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>>(
+      exp,
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+
+  s_val = gcry_sexp_nth_data(exp, 1, &sz);
+  if(s_val)
+    {
+      std::get<1>(result).resize(sz);
+      char *data = std::get<1>(result).data();
+      for(size_t i = 0; i < sz; i++)
+        {
+          data[i] = s_val[i];
+        }
+    }
+  else
+    {
+      throw std::runtime_error(
+          "Stirlitz::genUsernamePasswordDecryption: incorrect value(2)");
+    }
+
+  return result;
+}
+
+std::tuple<std::string, std::string>
+Stirlitz::genUsernamePasswordEncryption(const StirlitzKeyPair &own_key_pair,
+                                        const StirlitzKey &opponent_key)
+{
+  return genUsernamePasswordEncryption(own_key_pair.sexp(),
+                                       opponent_key.sexp());
+}
+
+std::tuple<std::string, std::string>
+Stirlitz::genUsernamePasswordDecryption(const StirlitzKeyPair &own_key_pair,
+                                        const StirlitzKey &opponent_key)
+{
+  return genUsernamePasswordDecryption(own_key_pair.sexp(),
+                                       opponent_key.sexp());
+}
+
+void
+Stirlitz::encryptFrame(gcry_cipher_hd_t hd, unsigned char *buf,
+                       const size_t &sz, const std::string &prefix)
+{
+  // Frame: random block followed by data. Random IV is not stored, so
+  // decryption garbles only first (random) block.
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  gcry_error_t err = gcry_cipher_reset(hd);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_cipher_reset:");
+    }
+
+  std::vector<unsigned char> iv(block_sz);
+  gcry_create_nonce(iv.data(), iv.size());
+  err = gcry_cipher_setiv(hd, iv.data(), iv.size());
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_cipher_setiv:");
+    }
+  gcry_create_nonce(buf, block_sz);
+
+  err = gcry_cipher_encrypt(hd, buf, sz, nullptr, 0);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix);
+    }
+}
+
+void
+Stirlitz::decryptFrame(gcry_cipher_hd_t hd, unsigned char *buf,
+                       const size_t &sz, const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  gcry_error_t err = gcry_cipher_reset(hd);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_cipher_reset:");
+    }
+
+  std::vector<unsigned char> iv(block_sz);
+  gcry_create_nonce(iv.data(), iv.size());
+  err = gcry_cipher_setiv(hd, iv.data(), iv.size());
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_cipher_setiv:");
+    }
+
+  err = gcry_cipher_decrypt(hd, buf, sz, nullptr, 0);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix);
+    }
+}
+
+size_t
+Stirlitz::frameSize(const FileOptions &options, const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  if(options.frame_size < 2 * block_sz)
+    {
+      throw std::runtime_error(prefix + " incorrect frame size");
+    }
+  // Sparse data records store size of encrypted frame in 4 bytes.
+  if(options.sparse && options.frame_size > UINT32_MAX)
+    {
+      throw std::runtime_error(prefix + " frame size of sparse files can "
+                                        "not exceed 4 GiB");
+    }
+  MemoryBudget budget(options);
+  if(!budget.fits())
+    {
+      throw std::runtime_error(prefix + " " + budget.shortage());
+    }
+  return options.frame_size;
+}
+
+uint64_t
+Stirlitz::encryptedSize(const uint64_t &sz, const FileOptions &options,
+                        const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz = frameSize(options, prefix) - block_sz;
+  uint64_t frames = sz / buf_sz;
+  if(sz % buf_sz != 0)
+    {
+      frames++;
+    }
+
+  uint64_t result = sz + frames * block_sz;
+  if(options.integrity)
+    {
+      result += frames * frame_tag_sz + frame_trailer_sz;
+    }
+  return result;
+}
+
+uint64_t
+Stirlitz::decryptedSize(const uint64_t &sz, const FileOptions &options,
+                        const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t tag_sz = options.integrity ? frame_tag_sz : 0;
+  size_t buf_sz = frameSize(options, prefix) + tag_sz;
+  uint64_t body_sz = sz;
+  if(options.integrity)
+    {
+      if(body_sz < frame_trailer_sz)
+        {
+          return 0;
+        }
+      body_sz -= frame_trailer_sz;
+    }
+  uint64_t frames = body_sz / buf_sz;
+  if(body_sz % buf_sz != 0)
+    {
+      frames++;
+    }
+
+  uint64_t overhead = frames * (block_sz + tag_sz);
+  if(body_sz <= overhead)
+    {
+      return 0;
+    }
+  return body_sz - overhead;
+}
+
+void
+Stirlitz::encryptFileKey(const std::filesystem::path &source_file,
+                         const std::filesystem::path &result,
+                         const std::vector<unsigned char> &key,
+                         const FileOptions &options, StirlitzJob *job)
+{
+  if(options.part_size != 0)
+    {
+      encryptParts(source_file, result, key, options, UINT64_MAX,
+                   "Stirlitz::encryptFile:", job);
+      return void();
+    }
+  frameSize(options, "Stirlitz::encryptFile:");
+  if((options.armor || options.sparse) && options.integrity)
+    {
+      throw std::runtime_error("Stirlitz::encryptFile: integrity tags can "
+                               "not be used with armor and sparse files");
+    }
+
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(
+          "Stirlitz::encryptFile: cannot open source file");
+    }
+
+  uint64_t fsz = f_source->size();
+  if(fsz == 0)
+    {
+      throw std::runtime_error("Stirlitz::encryptFile: incorrect file");
+    }
+  if(job)
+    {
+      job->setTotal(fsz);
+    }
+
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(
+          "Stirlitz::encryptFile: cannot write to resulting file");
+    }
+
+  std::unique_ptr<ArmorFileIO> f_armor;
+  try
+    {
+      FileIO *out = f_result.get();
+      if(options.armor)
+        {
+          f_armor = std::make_unique<ArmorFileIO>(out, FileIO::Write,
+                                                  options.armor_encoding);
+          out = f_armor.get();
+        }
+      else if(options.preallocate && !options.sparse)
+        {
+          f_result->preallocate(
+              encryptedSize(fsz, options, "Stirlitz::encryptFile:"));
+        }
+      uint64_t read_b;
+      if(options.sparse)
+        {
+          HoleMap holes(source_file);
+          read_b = encryptSparseIO(f_source.get(), &holes, fsz, out, key,
+                                   options, "Stirlitz::encryptFile:", job);
+        }
+      else
+        {
+          read_b = encryptIO(f_source.get(), out, key, options,
+                             "Stirlitz::encryptFile:", FrameRange(), job);
+        }
+      if(read_b != fsz)
+        {
+          throw std::runtime_error(
+              "Stirlitz::encryptFile: source file read error");
+        }
+      if(f_armor)
+        {
+          f_armor->close();
+        }
+      f_result->close();
+      commitResult(result_file, options);
+    }
+  catch(std::exception &er)
+    {
+      f_armor.reset();
+      f_result.reset();
+      result_file.discard();
+      throw;
+    }
+}
+
+void
+Stirlitz::decryptFileKey(const std::filesystem::path &source_file,
+                         const std::filesystem::path &result,
+                         const std::vector<unsigned char> &key,
+                         const FileOptions &options, StirlitzJob *job)
+{
+  if(options.part_size != 0)
+    {
+      decryptParts(source_file, result, key, options, UINT64_MAX,
+                   "Stirlitz::decryptFile:", job);
+      return void();
+    }
+  frameSize(options, "Stirlitz::decryptFile:");
+  if((options.armor || options.sparse) && options.integrity)
+    {
+      throw std::runtime_error("Stirlitz::decryptFile: integrity tags can "
+                               "not be used with armor and sparse files");
+    }
+
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(
+          "Stirlitz::decryptFile: cannot open source file");
+    }
+
+  uint64_t fsz = f_source->size();
+
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  if(fsz < block_sz)
+    {
+      throw std::runtime_error("Stirlitz::decryptFile: incorrect file(1)");
+    }
+  // Nothing but keyed trailer marks file with integrity tags, so it is
+  // checked to avoid garbage output when option does not match file.
+  if(!options.armor && !options.sparse)
+    {
+      bool tagged = hasTrailer(source_file, fsz, key, options,
+                               "Stirlitz::decryptFile:");
+      if(tagged && !options.integrity)
+        {
+          throw std::runtime_error(
+              "Stirlitz::decryptFile: file has integrity tags");
+        }
+      if(!tagged && options.integrity)
+        {
+          throw std::runtime_error("Stirlitz::decryptFile: file has no "
+                                   "integrity tags or its end is damaged");
+        }
+    }
+  // Size of data encoded in armored text is not known before decoding.
+  if(job && !options.armor)
+    {
+      job->setTotal(fsz);
+    }
+
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(
+          "Stirlitz::decryptFile: cannot write to resulting file");
+    }
+
+  std::unique_ptr<ArmorFileIO> f_armor;
+  try
+    {
+      if(options.armor)
+        {
+          f_armor = std::make_unique<ArmorFileIO>(
+              f_source.get(), FileIO::Read, options.armor_encoding);
+        }
+      if(options.sparse)
+        {
+          // Result is not preallocated to keep holes.
+          FileIO *in = f_armor ? f_armor.get() : f_source.get();
+          if(decryptSparseIO(in, f_result.get(), key, options,
+                             "Stirlitz::decryptFile:", job)
+                 != fsz
+             && !f_armor)
+            {
+              throw std::runtime_error(
+                  "Stirlitz::decryptFile: source file read error");
+            }
+        }
+      else if(options.armor)
+        {
+          decryptIO(f_armor.get(), f_result.get(), key, options,
+                    "Stirlitz::decryptFile:", 0, FrameRange(), job);
+        }
+      else
+        {
+          uint64_t result_sz
+              = decryptedSize(fsz, options, "Stirlitz::decryptFile:");
+          if(options.preallocate && result_sz > 0)
+            {
+              f_result->preallocate(result_sz);
+            }
+          if(decryptIO(f_source.get(), f_result.get(), key, options,
+                       "Stirlitz::decryptFile:", fsz, FrameRange(), job)
+             != fsz)
+            {
+              throw std::runtime_error(
+                  "Stirlitz::decryptFile: source file read error");
+            }
+        }
+      f_result->close();
+      commitResult(result_file, options);
+    }
+  catch(std::exception &er)
+    {
+      f_armor.reset();
+      f_result.reset();
+      result_file.discard();
+      throw;
+    }
+}
+
+uint64_t
+Stirlitz::encryptParts(const std::filesystem::path &source_file,
+                       const std::filesystem::path &result,
+                       const std::vector<unsigned char> &key,
+                       const FileOptions &options, const uint64_t &part,
+                       const std::string &prefix, StirlitzJob *job)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t frame_sz = frameSize(options, prefix);
+  if(options.armor || options.sparse)
+    {
+      throw std::runtime_error(prefix + " parts can not be used with armor "
+                                        "and sparse files");
+    }
+
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " cannot open source file");
+    }
+
+  uint64_t fsz = f_source->size();
+  if(fsz == 0)
+    {
+      throw std::runtime_error(prefix + " incorrect file");
+    }
+
+  std::unique_ptr<PartSet> parts;
+  try
+    {
+      parts = std::make_unique<PartSet>(
+          result, fsz, frame_sz - block_sz,
+          frame_sz + (options.integrity ? frame_tag_sz : 0),
+          options.integrity ? frame_trailer_sz : 0, options.part_size);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " part size is less than frame size");
+    }
+
+  uint64_t first = 0;
+  uint64_t last = parts->count();
+  if(part != UINT64_MAX)
+    {
+      if(part >= parts->count())
+        {
+          throw std::runtime_error(prefix + " incorrect part number");
+        }
+      first = part;
+      last = part + 1;
+    }
+  if(job)
+    {
+      job->setTotal(parts->sourceOffset(last - 1)
+                    + parts->sourceSize(last - 1)
+                    - parts->sourceOffset(first));
+    }
+  f_source->skip(parts->sourceOffset(first));
+
+  // Parts replace previous files only when all of them have been written.
+  std::vector<std::unique_ptr<ResultFile>> part_files;
+  for(uint64_t i = first; i < last; i++)
+    {
+      part_files.emplace_back(std::make_unique<ResultFile>(parts->path(i)));
+      std::unique_ptr<FileIO> f_result;
+      try
+        {
+          f_result = FileIO::open(part_files.back()->tempPath(),
+                                  FileIO::Write, options);
+        }
+      catch(std::exception &er)
+        {
+          throw std::runtime_error(prefix
+                                   + " cannot write to resulting file");
+        }
+      if(options.preallocate)
+        {
+          f_result->preallocate(parts->size(i));
+        }
+      FrameRange range;
+      range.first = parts->firstFrame(i);
+      range.limit = parts->sourceSize(i);
+      range.trailer = parts->isLast(i);
+      if(encryptIO(f_source.get(), f_result.get(), key, options, prefix,
+                   range, job)
+         != range.limit)
+        {
+          throw std::runtime_error(prefix + " source file read error");
+        }
+      f_result->close();
+    }
+
+  ResultFile manifest(result);
+  parts->save(manifest.tempPath());
+  for(auto it = part_files.begin(); it != part_files.end(); it++)
+    {
+      commitResult(*(*it), options);
+    }
+  commitResult(manifest, options);
+
+  return parts->count();
+}
+
+uint64_t
+Stirlitz::decryptParts(const std::filesystem::path &source_file,
+                       const std::filesystem::path &result,
+                       const std::vector<unsigned char> &key,
+                       const FileOptions &options, const uint64_t &part,
+                       const std::string &prefix, StirlitzJob *job)
+{
+  if(options.armor || options.sparse)
+    {
+      throw std::runtime_error(prefix + " parts can not be used with armor "
+                                        "and sparse files");
+    }
+  std::unique_ptr<PartSet> parts = loadParts(source_file, options, prefix);
+
+  uint64_t first = 0;
+  uint64_t last = parts->count();
+  if(part != UINT64_MAX)
+    {
+      if(part >= parts->count())
+        {
+          throw std::runtime_error(prefix + " incorrect part number");
+        }
+      first = part;
+      last = part + 1;
+    }
+  if(job)
+    {
+      uint64_t total = 0;
+      for(uint64_t i = first; i < last; i++)
+        {
+          total += parts->size(i);
+        }
+      job->setTotal(total);
+    }
+
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " cannot write to resulting file");
+    }
+
+  try
+    {
+      if(options.preallocate)
+        {
+          f_result->preallocate(parts->sourceOffset(last - 1)
+                                + parts->sourceSize(last - 1)
+                                - parts->sourceOffset(first));
+        }
+      for(uint64_t i = first; i < last; i++)
+        {
+          std::unique_ptr<FileIO> f_part;
+          try
+            {
+              f_part = FileIO::open(parts->path(i), FileIO::Read, options);
+            }
+          catch(std::exception &er)
+            {
+              throw std::runtime_error(prefix + " cannot open part "
+                                       + std::to_string(i));
+            }
+          uint64_t psz = f_part->size();
+          if(psz != parts->size(i))
+            {
+              throw std::runtime_error(prefix + " part " + std::to_string(i)
+                                       + " has incorrect size");
+            }
+          FrameRange range;
+          range.first = parts->firstFrame(i);
+          range.trailer = parts->isLast(i);
+          if(decryptIO(f_part.get(), f_result.get(), key, options, prefix,
+                       psz, range, job)
+             != psz)
+            {
+              throw std::runtime_error(prefix + " source file read error");
+            }
+        }
+      f_result->close();
+      commitResult(result_file, options);
+    }
+  catch(std::exception &er)
+    {
+      f_result.reset();
+      result_file.discard();
+      throw;
+    }
+
+  return parts->sourceOffset(first);
+}
+
+std::vector<uint64_t>
+Stirlitz::verifyParts(const std::filesystem::path &source_file,
+                      const std::vector<unsigned char> &key,
+                      const FileOptions &options, const uint64_t &part,
+                      const std::string &prefix)
+{
+  std::unique_ptr<PartSet> parts = loadParts(source_file, options, prefix);
+
+  uint64_t first = 0;
+  uint64_t last = parts->count();
+  if(part != UINT64_MAX)
+    {
+      if(part >= parts->count())
+        {
+          throw std::runtime_error(prefix + " incorrect part number");
+        }
+      first = part;
+      last = part + 1;
+    }
+
+  std::vector<uint64_t> damaged;
+  for(uint64_t i = first; i < last; i++)
+    {
+      std::unique_ptr<FileIO> f_part;
+      try
+        {
+          f_part = FileIO::open(parts->path(i), FileIO::Read, options);
+        }
+      catch(std::exception &er)
+        {
+          throw std::runtime_error(prefix + " cannot open part "
+                                   + std::to_string(i));
+        }
+      FrameRange range;
+      range.first = parts->firstFrame(i);
+      range.trailer = parts->isLast(i);
+      if(f_part->size() != parts->size(i))
+        {
+          // Frames of truncated part can not be told from missing ones.
+          uint64_t end = range.first + parts->frameCount(i);
+          if(range.trailer)
+            {
+              end++;
+            }
+          for(uint64_t frame = range.first; frame < end; frame++)
+            {
+              damaged.push_back(frame);
+            }
+          continue;
+        }
+      std::vector<uint64_t> part_damaged = verifyIO(
+          f_part.get(), parts->size(i), key, options, range, prefix);
+      damaged.insert(damaged.end(), part_damaged.begin(), part_damaged.end());
+    }
+
+  return damaged;
+}
+
+std::unique_ptr<PartSet>
+Stirlitz::loadParts(const std::filesystem::path &manifest,
+                    const FileOptions &options, const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t frame_sz = frameSize(options, prefix);
+
+  std::unique_ptr<PartSet> result;
+  try
+    {
+      result = std::make_unique<PartSet>(manifest);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " cannot read manifest");
+    }
+  if(!result->matches(frame_sz - block_sz,
+                      frame_sz + (options.integrity ? frame_tag_sz : 0),
+                      options.integrity ? frame_trailer_sz : 0))
+    {
+      throw std::runtime_error(prefix + " parts have been encrypted with "
+                                        "other frame size or integrity "
+                                        "option");
+    }
+
+  return result;
+}
+
+std::shared_ptr<StirlitzJob>
+Stirlitz::dataAsync(
+    std::function<std::shared_ptr<StirlitzStream>(std::string &)> prepare,
+    const StirlitzJob::Callbacks &callbacks)
+{
+  std::shared_ptr<StirlitzJob> job(new StirlitzJob(
+      [prepare](StirlitzJob &job)
+        {
+          // Source is obtained (and decoded) and key is derived in thread of
+          // pool, so caller is not blocked by large data.
+          std::string source;
+          std::shared_ptr<StirlitzStream> strm = prepare(source);
+          size_t part_sz = 1048576;
+          job.setTotal(source.size());
+          std::string result;
+          result.resize(source.size() + 16
+                        + StirlitzStream::updateSize(part_sz));
+          unsigned char *in
+              = reinterpret_cast<unsigned char *>(source.data());
+          unsigned char *out = reinterpret_cast<unsigned char *>(result.data());
+          size_t out_sz = 0;
+          for(size_t i = 0; i < source.size(); i += part_sz)
+            {
+              if(job.cancelled())
+                {
+                  throw std::runtime_error(
+                      "Stirlitz::dataAsync: operation cancelled");
+                }
+              size_t sz = std::min(part_sz, source.size() - i);
+              out_sz += strm->update(in + i, sz, out + out_sz);
+              job.addProgress(sz);
+            }
+          out_sz += strm->finish(out + out_sz);
+          result.resize(out_sz);
+          std::lock_guard<std::mutex> lglock(job.mtx);
+          job.result_data = std::move(result);
+        },
+      callbacks));
+  jobPool()->submit(job);
+  return job;
+}
+
+void
+Stirlitz::textFile(StirlitzStream *strm, const bool &encrypt,
+                   const std::filesystem::path &source_file,
+                   const std::filesystem::path &result,
+                   const std::string &prefix, StirlitzJob *job)
+{
+  FileOptions options;
+  options.preallocate = false;
+  std::unique_ptr<FileIO> f_source;
+  try
+    {
+      f_source = FileIO::open(source_file, FileIO::Read, options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " cannot open source file");
+    }
+
+  uint64_t fsz = f_source->size();
+  if(fsz == 0)
+    {
+      throw std::runtime_error(prefix + " incorrect file");
+    }
+  if(job)
+    {
+      job->setTotal(fsz);
+    }
+
+  ResultFile result_file(result);
+  std::unique_ptr<FileIO> f_result;
+  try
+    {
+      f_result = FileIO::open(result_file.tempPath(), FileIO::Write,
+                              options);
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error(prefix + " cannot write to resulting file");
+    }
+
+  try
+    {
+      size_t part_sz = 1048576;
+      std::vector<unsigned char> buf(part_sz);
+      // Encrypted data is stored as single line of hexadecimal digits.
+      // Armored text (see StirlitzArmor) is accepted for decryption too.
+      StirlitzArmor armor(
+          encrypt ? StirlitzArmor::Encode : StirlitzArmor::Decode,
+          StirlitzArmor::Hex, false, 0);
+      std::string text;
+      std::string out;
+      out.resize(StirlitzStream::updateSize(part_sz));
+      unsigned char *out_ptr = reinterpret_cast<unsigned char *>(out.data());
+      uint64_t read_b = 0;
+      size_t sz;
+      size_t out_sz;
+      for(;;)
+        {
+          if(job && job->cancelled())
+            {
+              throw std::runtime_error(prefix + " operation cancelled");
+            }
+          sz = f_source->read(buf.data(), buf.size());
+          if(sz == 0)
+            {
+              break;
+            }
+          read_b += sz;
+          text.clear();
+          if(encrypt)
+            {
+              out_sz = strm->update(buf.data(), sz, out_ptr);
+              armor.update(out_ptr, out_sz, text);
+              f_result->write(
+                  reinterpret_cast<const unsigned char *>(text.data()),
+                  text.size());
+            }
+          else
+            {
+              armor.update(buf.data(), sz, text);
+              out_sz = strm->update(
+                  reinterpret_cast<const unsigned char *>(text.data()),
+                  text.size(), out_ptr);
+              f_result->write(out_ptr, out_sz);
+            }
+          if(job)
+            {
+              job->addProgress(sz);
+            }
+        }
+      if(read_b != fsz)
+        {
+          throw std::runtime_error(prefix + " source file read error");
+        }
+
+      text.clear();
+      out.resize(std::max(out.size(), StirlitzStream::finishSize()));
+      out_ptr = reinterpret_cast<unsigned char *>(out.data());
+      if(encrypt)
+        {
+          out_sz = strm->finish(out_ptr);
+          armor.update(out_ptr, out_sz, text);
+          armor.finish(text);
+          f_result->write(
+              reinterpret_cast<const unsigned char *>(text.data()),
+              text.size());
+        }
+      else
+        {
+          armor.finish(text);
+          out_sz = strm->update(
+              reinterpret_cast<const unsigned char *>(text.data()),
+              text.size(), out_ptr);
+          f_result->write(out_ptr, out_sz);
+          out_sz = strm->finish(out_ptr);
+          f_result->write(out_ptr, out_sz);
+        }
+      f_result->close();
+      commitResult(result_file, options);
+    }
+  catch(std::exception &er)
+    {
+      f_result.reset();
+      result_file.discard();
+      throw;
+    }
+}
+
+void
+Stirlitz::commitResult(ResultFile &result_file, const FileOptions &options)
+{
+  switch(options.durability)
+    {
+    case FileOptions::SyncBatch:
+      {
+        ResultFile::startSync(result_file.tempPath());
+        std::lock_guard<std::mutex> lglock(batch_mtx);
+        batches[options.batch].emplace_back(result_file.tempPath(),
+                                            result_file.result());
+        result_file.release();
+        break;
+      }
+    case FileOptions::SyncFile:
+      {
+        result_file.commit(true);
+        break;
+      }
+    case FileOptions::NoSync:
+    default:
+      {
+        result_file.commit(false);
+        break;
+      }
+    }
+}
+
+JobPool *
+Stirlitz::jobPool()
+{
+  std::lock_guard<std::mutex> lglock(pool_mtx);
+  if(!pool)
+    {
+      size_t threads = job_threads;
+      if(threads == 0)
+        {
+          threads = std::thread::hardware_concurrency();
+        }
+      pool.reset(new JobPool(threads));
+    }
+  return pool.get();
+}
+
+std::vector<unsigned char>
+Stirlitz::wrappingKey(std::shared_ptr<gcry_sexp> own_key_pair,
+                      std::shared_ptr<gcry_sexp> other_key,
+                      const bool &encrypt)
+{
+  std::tuple<std::string, std::string> cred;
+  if(encrypt)
+    {
+      cred = genUsernamePasswordEncryption(own_key_pair, other_key);
+    }
+  else
+    {
+      cred = genUsernamePasswordDecryption(own_key_pair, other_key);
+    }
+  // Separate key from one used by encryptData() for the same credentials.
+  return hashString("STZM" + std::get<0>(cred) + std::get<1>(cred),
+                    GCRY_MD_BLAKE2S_256);
+}
+
+uint64_t
+Stirlitz::encryptIO(FileIO *source, FileIO *result,
+                    const std::vector<unsigned char> &key,
+                    const FileOptions &options, const std::string &prefix,
+                    const FrameRange &range, StirlitzJob *job)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz = frameSize(options, prefix) - block_sz;
+  size_t tag_sz = options.integrity ? frame_tag_sz : 0;
+  uint64_t limit = range.limit;
+  uint64_t read_b = 0;
+  uint64_t frames = 0;
+
+  std::function<size_t(unsigned char *)> read_func
+      = [source, buf_sz, block_sz, limit, prefix, job, &read_b,
+         &frames](unsigned char *buf)
+    {
+      if(job && job->cancelled())
+        {
+          throw std::runtime_error(prefix + " operation cancelled");
+        }
+      size_t sz = source->read(
+          buf + block_sz,
+          static_cast<size_t>(
+              std::min(static_cast<uint64_t>(buf_sz), limit - read_b)));
+      read_b += sz;
+      if(sz == 0)
+        {
+          return sz;
+        }
+      frames++;
+      return sz + block_sz;
+    };
+
+  MemoryBudget budget(options);
+  size_t workers = budget.workers();
+  std::vector<std::unique_ptr<gcry_cipher_handle,
+                              std::function<void(gcry_cipher_handle *)>>>
+      hds;
+  std::vector<
+      std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>>
+      macs;
+  for(size_t i = 0; i < workers; i++)
+    {
+      hds.emplace_back(cipherHandle(key, prefix));
+      if(options.integrity)
+        {
+          macs.emplace_back(macHandle(key, prefix));
+        }
+    }
+
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [this, &hds, &macs, &range, prefix](
+                         unsigned char *buf, const size_t &len,
+                         const uint64_t &seq, const size_t &worker)
+    {
+      encryptFrame(hds[worker].get(), buf, len, prefix);
+      if(!macs.empty())
+        {
+          frameTag(macs[worker].get(), buf, len, range.first + seq,
+                   buf + len, prefix);
+        }
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [result, block_sz, tag_sz, job](unsigned char *buf, const size_t &len)
+    {
+      result->write(buf, len + tag_sz);
+      if(job)
+        {
+          job->addProgress(len - block_sz);
+        }
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(),
+                             buf_sz + block_sz + tag_sz, buffers.get(),
+                             options.memory_budget);
+      pipeline.run(read_func, process_func, write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(buf_sz + block_sz + tag_sz,
+                             options.memory_budget);
+      size_t sz;
+      for(uint64_t seq = 0;; seq++)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, seq, 0);
+          write_func(buf.get(), sz);
+        }
+    }
+
+  if(options.integrity && range.trailer)
+    {
+      unsigned char trailer[frame_trailer_sz];
+      frameTrailer(macs[0].get(), range.first + frames, trailer, prefix);
+      result->write(trailer, sizeof(trailer));
+    }
+
+  return read_b;
+}
+
+uint64_t
+Stirlitz::decryptIO(FileIO *source, FileIO *result,
+                    const std::vector<unsigned char> &key,
+                    const FileOptions &options, const std::string &prefix,
+                    const uint64_t &source_sz, const FrameRange &range,
+                    StirlitzJob *job)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t tag_sz = options.integrity ? frame_tag_sz : 0;
+  size_t buf_sz = frameSize(options, prefix) + tag_sz;
+  uint64_t body_sz = UINT64_MAX;
+  if(options.integrity)
+    {
+      body_sz = source_sz;
+      if(range.trailer)
+        {
+          if(source_sz < frame_trailer_sz)
+            {
+              throw std::runtime_error(prefix + " incorrect file");
+            }
+          body_sz -= frame_trailer_sz;
+        }
+    }
+  uint64_t read_b = 0;
+  uint64_t frames = 0;
+
+  std::function<size_t(unsigned char *)> read_func
+      = [source, buf_sz, block_sz, tag_sz, body_sz, prefix, job, &range,
+         &read_b, &frames](unsigned char *buf)
+    {
+      if(job && job->cancelled())
+        {
+          throw std::runtime_error(prefix + " operation cancelled");
+        }
+      size_t sz = source->read(
+          buf, static_cast<size_t>(
+                   std::min(static_cast<uint64_t>(buf_sz), body_sz - read_b)));
+      // Random first block of frame can match marker of sparse data only by
+      // negligible chance.
+      if(read_b == 0 && range.first == 0 && sz >= sparse_magic_sz
+         && std::memcmp(buf, sparse_magic, sparse_magic_sz) == 0)
+        {
+          throw std::runtime_error(prefix + " file is sparse");
+        }
+      read_b += sz;
+      if(sz > 0 && sz < block_sz + tag_sz)
+        {
+          throw std::runtime_error(prefix + " incorrect file");
+        }
+      if(sz > 0)
+        {
+          frames++;
+        }
+      return sz;
+    };
+
+  MemoryBudget budget(options);
+  size_t workers = budget.workers();
+  std::vector<std::unique_ptr<gcry_cipher_handle,
+                              std::function<void(gcry_cipher_handle *)>>>
+      hds;
+  std::vector<
+      std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>>
+      macs;
+  for(size_t i = 0; i < workers; i++)
+    {
+      hds.emplace_back(cipherHandle(key, prefix));
+      if(options.integrity)
+        {
+          macs.emplace_back(macHandle(key, prefix));
+        }
+    }
+
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [this, &hds, &macs, &range, tag_sz, prefix](
+                         unsigned char *buf, const size_t &len,
+                         const uint64_t &seq, const size_t &worker)
+    {
+      size_t data_sz = len - tag_sz;
+      if(!macs.empty())
+        {
+          unsigned char tag[frame_tag_sz];
+          frameTag(macs[worker].get(), buf, data_sz, range.first + seq, tag,
+                   prefix);
+          if(std::memcmp(tag, buf + data_sz, tag_sz) != 0)
+            {
+              throw std::runtime_error(prefix + " frame "
+                                       + std::to_string(range.first + seq)
+                                       + " is damaged");
+            }
+        }
+      decryptFrame(hds[worker].get(), buf, data_sz, prefix);
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [result, block_sz, tag_sz, job](unsigned char *buf, const size_t &len)
+    {
+      result->write(buf + block_sz, len - block_sz - tag_sz);
+      if(job)
+        {
+          job->addProgress(len);
+        }
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(), buf_sz,
+                             buffers.get(), options.memory_budget);
+      pipeline.run(read_func, process_func, write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(buf_sz, options.memory_budget);
+      size_t sz;
+      for(uint64_t seq = 0;; seq++)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, seq, 0);
+          write_func(buf.get(), sz);
+        }
+    }
+
+  if(options.integrity && range.trailer)
+    {
+      unsigned char trailer[frame_trailer_sz];
+      unsigned char expected[frame_trailer_sz];
+      size_t sz = source->read(trailer, sizeof(trailer));
+      read_b += sz;
+      frameTrailer(macs[0].get(), range.first + frames, expected, prefix);
+      if(sz != sizeof(trailer)
+         || std::memcmp(trailer, expected, sizeof(trailer)) != 0)
+        {
+          throw std::runtime_error(prefix + " end of file is damaged");
+        }
+    }
+
+  return read_b;
+}
+
+std::vector<uint64_t>
+Stirlitz::verifyIO(FileIO *source, const uint64_t &source_sz,
+                   const std::vector<unsigned char> &key,
+                   const FileOptions &options, const FrameRange &range,
+                   const std::string &prefix)
+{
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz = frameSize(options, prefix) + frame_tag_sz;
+
+  uint64_t body_sz = source_sz;
+  if(range.trailer)
+    {
+      if(source_sz < frame_trailer_sz)
+        {
+          throw std::runtime_error(prefix + " incorrect file");
+        }
+      body_sz -= frame_trailer_sz;
+    }
+  uint64_t read_b = 0;
+  uint64_t frames = 0;
+
+  std::function<size_t(unsigned char *)> read_func
+      = [source, buf_sz, body_sz, &read_b, &frames](unsigned char *buf)
+    {
+      size_t sz = source->read(
+          buf, static_cast<size_t>(
+                   std::min(static_cast<uint64_t>(buf_sz), body_sz - read_b)));
+      read_b += sz;
+      if(sz > 0)
+        {
+          frames++;
+        }
+      return sz;
+    };
+
+  MemoryBudget budget(options);
+  size_t workers = budget.workers();
+  std::vector<
+      std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>>
+      macs;
+  for(size_t i = 0; i < workers; i++)
+    {
+      macs.emplace_back(macHandle(key, prefix));
+    }
+
+  std::mutex damaged_mtx;
+  std::vector<uint64_t> damaged;
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [this, &macs, &damaged_mtx, &damaged, &range, block_sz,
+                      prefix](unsigned char *buf, const size_t &len,
+                              const uint64_t &seq, const size_t &worker)
+    {
+      bool ok = false;
+      if(len >= block_sz + frame_tag_sz)
+        {
+          size_t data_sz = len - frame_tag_sz;
+          unsigned char tag[frame_tag_sz];
+          frameTag(macs[worker].get(), buf, data_sz, range.first + seq, tag,
+                   prefix);
+          ok = std::memcmp(tag, buf + data_sz, frame_tag_sz) == 0;
+        }
+      if(!ok)
+        {
+          std::lock_guard<std::mutex> lglock(damaged_mtx);
+          damaged.push_back(range.first + seq);
+        }
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(), buf_sz,
+                             buffers.get(), options.memory_budget);
+      pipeline.run(read_func, process_func,
+                   [](unsigned char *, const size_t &)
+                     {
+                     });
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(buf_sz, options.memory_budget);
+      size_t sz;
+      for(uint64_t seq = 0;; seq++)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, seq, 0);
+        }
+    }
+
+  if(range.trailer)
+    {
+      unsigned char trailer[frame_trailer_sz];
+      unsigned char expected[frame_trailer_sz];
+      size_t sz = source->read(trailer, sizeof(trailer));
+      frameTrailer(macs[0].get(), range.first + frames, expected, prefix);
+      if(sz != sizeof(trailer)
+         || std::memcmp(trailer, expected, sizeof(trailer)) != 0)
+        {
+          damaged.push_back(range.first + frames);
+        }
+    }
+
+  std::sort(damaged.begin(), damaged.end());
+  return damaged;
+}
+
+uint64_t
+Stirlitz::encryptSparseIO(FileIO *source, HoleMap *holes,
+                          const uint64_t &source_sz, FileIO *result,
+                          const std::vector<unsigned char> &key,
+                          const FileOptions &options,
+                          const std::string &prefix, StirlitzJob *job)
+{
+  // Marker sparse_magic is followed by records: data frame - 0x00, size of
+  // encrypted frame (4 bytes, little endian), encrypted frame; run of zeros
+  // - 0x01, number of zero bytes (8 bytes, little endian), tag; last record
+  // - 0x02, total size of plain data (8 bytes, little endian), tag. Tags
+  // (see sparseRecord()) authenticate headers of records, which are not
+  // encrypted, and their order. Frame buffer starts with 9 bytes area for
+  // record header: buf[0] is 0x01 for zeros (run length follows), for data
+  // frames header is built at buf + 4, directly before frame.
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz = frameSize(options, prefix) - block_sz;
+  uint64_t read_b = 0;
+  result->write(reinterpret_cast<const unsigned char *>(sparse_magic),
+                sparse_magic_sz);
+
+  std::function<size_t(unsigned char *)> read_func
+      = [source, holes, source_sz, buf_sz, block_sz, prefix, job,
+         &read_b](unsigned char *buf)
+    {
+      if(job && job->cancelled())
+        {
+          throw std::runtime_error(prefix + " operation cancelled");
+        }
+      unsigned char *data = buf + sparse_hdr_sz + block_sz;
+      size_t sz = 0;
+      if(holes && read_b < source_sz
+         && holes->isHole(read_b, std::min(static_cast<uint64_t>(buf_sz),
+                                           source_sz - read_b)))
+        {
+          sz = static_cast<size_t>(
+              std::min(static_cast<uint64_t>(buf_sz), source_sz - read_b));
+          source->skip(sz);
+        }
+      else
+        {
+          sz = source->read(data, buf_sz);
+          if(sz == 0)
+            {
+              return sz;
+            }
+          if(!isZero(data, sz))
+            {
+              read_b += sz;
+              buf[0] = 0x00;
+              return sparse_hdr_sz + block_sz + sz;
+            }
+        }
+      read_b += sz;
+      buf[0] = 0x01;
+      for(int i = 0; i < 8; i++)
+        {
+          buf[1 + i] = static_cast<unsigned char>(
+              (static_cast<uint64_t>(sz) >> (8 * i)) & 0xff);
+        }
+      return sparse_hdr_sz;
+    };
+
+  MemoryBudget budget(options);
+  size_t workers = budget.workers();
+  std::vector<std::unique_ptr<gcry_cipher_handle,
+                              std::function<void(gcry_cipher_handle *)>>>
+      hds;
+  for(size_t i = 0; i < workers; i++)
+    {
+      hds.emplace_back(cipherHandle(key, prefix));
+    }
+
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [this, &hds, prefix](unsigned char *buf,
+                                          const size_t &len, const uint64_t &,
+                                          const size_t &worker)
+    {
+      if(buf[0] == 0x00)
+        {
+          encryptFrame(hds[worker].get(), buf + sparse_hdr_sz,
+                       len - sparse_hdr_sz, prefix);
+        }
+    };
+
+  // Consecutive runs of zeros are joined to single record. Records are
+  // written (and so numbered) by single thread.
+  std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>
+      mac = macHandle(key, prefix);
+  uint64_t records = 0;
+  uint64_t total = 0;
+  uint64_t zeros = 0;
+  std::function<void()> write_zeros
+      = [this, result, prefix, &mac, &records, &total, &zeros]
+    {
+      if(zeros == 0)
+        {
+          return void();
+        }
+      unsigned char rec[sparse_rec_sz];
+      sparseRecord(mac.get(), 0x01, zeros, records, rec, prefix);
+      result->write(rec, sizeof(rec));
+      records++;
+      total += zeros;
+      zeros = 0;
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [result, block_sz, job, &records, &total, &zeros,
+         &write_zeros](unsigned char *buf, const size_t &len)
+    {
+      if(buf[0] == 0x01)
+        {
+          uint64_t sz = 0;
+          for(int i = 0; i < 8; i++)
+            {
+              sz |= static_cast<uint64_t>(buf[1 + i]) << (8 * i);
+            }
+          zeros += sz;
+          if(job)
+            {
+              job->addProgress(sz);
+            }
+          return void();
+        }
+      write_zeros();
+      size_t frame_sz = len - sparse_hdr_sz;
+      buf[4] = 0x00;
+      for(int i = 0; i < 4; i++)
+        {
+          buf[5 + i] = static_cast<unsigned char>(
+              (static_cast<uint64_t>(frame_sz) >> (8 * i)) & 0xff);
+        }
+      result->write(buf + 4, len - 4);
+      records++;
+      total += frame_sz - block_sz;
+      if(job)
+        {
+          job->addProgress(frame_sz - block_sz);
+        }
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(),
+                             sparse_hdr_sz + buf_sz + block_sz,
+                             buffers.get(), options.memory_budget);
+      pipeline.run(read_func, process_func, write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(sparse_hdr_sz + buf_sz + block_sz,
+                             options.memory_budget);
+      size_t sz;
+      for(uint64_t seq = 0;; seq++)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, seq, 0);
+          write_func(buf.get(), sz);
+        }
+    }
+  write_zeros();
+  unsigned char rec[sparse_rec_sz];
+  sparseRecord(mac.get(), 0x02, total, records, rec, prefix);
+  result->write(rec, sizeof(rec));
+
+  return read_b;
+}
+
+uint64_t
+Stirlitz::decryptSparseIO(FileIO *source, FileIO *result,
+                          const std::vector<unsigned char> &key,
+                          const FileOptions &options,
+                          const std::string &prefix, StirlitzJob *job)
+{
+  // See encryptSparseIO() for format. Header of record is read to buf[0]
+  // (type) and buf + 1 (run length), data frame follows header area. Tags
+  // are checked before zeros are written, so run length can not be forged
+  // without key.
+  size_t block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+  size_t buf_sz = frameSize(options, prefix);
+  unsigned char magic[sparse_magic_sz];
+  if(source->read(magic, sizeof(magic)) != sizeof(magic)
+     || std::memcmp(magic, sparse_magic, sizeof(magic)) != 0)
+    {
+      throw std::runtime_error(prefix + " file is not sparse");
+    }
+  if(job)
+    {
+      job->addProgress(sizeof(magic));
+    }
+  uint64_t read_b = sizeof(magic);
+
+  std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>
+      mac = macHandle(key, prefix);
+  uint64_t records = 0;
+  uint64_t total = 0;
+  bool ended = false;
+
+  std::function<size_t(unsigned char *)> read_func
+      = [this, source, buf_sz, block_sz, prefix, job, &mac, &records, &total,
+         &ended, &read_b](unsigned char *buf)
+    {
+      if(job && job->cancelled())
+        {
+          throw std::runtime_error(prefix + " operation cancelled");
+        }
+      if(ended)
+        {
+          return static_cast<size_t>(0);
+        }
+      if(source->read(buf, 1) == 0)
+        {
+          throw std::runtime_error(prefix + " end of file is damaged");
+        }
+      read_b++;
+      if(buf[0] == 0x01 || buf[0] == 0x02)
+        {
+          if(source->read(buf + 1, sparse_rec_sz - 1) != sparse_rec_sz - 1)
+            {
+              throw std::runtime_error(prefix + " incorrect file");
+            }
+          read_b += sparse_rec_sz - 1;
+          uint64_t sz = 0;
+          for(int i = 0; i < 8; i++)
+            {
+              sz |= static_cast<uint64_t>(buf[1 + i]) << (8 * i);
+            }
+          unsigned char expected[sparse_rec_sz];
+          sparseRecord(mac.get(), buf[0], sz, records, expected, prefix);
+          if(std::memcmp(buf, expected, sparse_rec_sz) != 0
+             || (buf[0] == 0x01 && (sz == 0 || sz > UINT64_MAX - total))
+             || (buf[0] == 0x02 && sz != total))
+            {
+              throw std::runtime_error(prefix + " file is damaged");
+            }
+          records++;
+          if(buf[0] == 0x02)
+            {
+              // Nothing may follow last record.
+              ended = true;
+              if(source->read(expected, 1) != 0)
+                {
+                  throw std::runtime_error(prefix + " incorrect file");
+                }
+              if(job)
+                {
+                  job->addProgress(sparse_rec_sz);
+                }
+              return static_cast<size_t>(0);
+            }
+          total += sz;
+          return sparse_hdr_sz;
+        }
+      unsigned char len[4];
+      if(buf[0] != 0x00 || source->read(len, sizeof(len)) != sizeof(len))
+        {
+          throw std::runtime_error(prefix + " incorrect file");
+        }
+      size_t frame_sz = 0;
+      for(int i = 0; i < 4; i++)
+        {
+          frame_sz |= static_cast<size_t>(len[i]) << (8 * i);
+        }
+      if(frame_sz < block_sz || frame_sz > buf_sz
+         || source->read(buf + sparse_hdr_sz, frame_sz) != frame_sz)
+        {
+          throw std::runtime_error(prefix + " incorrect file");
+        }
+      read_b += sizeof(len) + frame_sz;
+      records++;
+      total += frame_sz - block_sz;
+      return sparse_hdr_sz + frame_sz;
+    };
+
+  MemoryBudget budget(options);
+  size_t workers = budget.workers();
+  std::vector<std::unique_ptr<gcry_cipher_handle,
+                              std::function<void(gcry_cipher_handle *)>>>
+      hds;
+  for(size_t i = 0; i < workers; i++)
+    {
+      hds.emplace_back(cipherHandle(key, prefix));
+    }
+
+  std::function<void(unsigned char *, const size_t &, const uint64_t &,
+                     const size_t &)>
+      process_func = [this, &hds, prefix](unsigned char *buf,
+                                          const size_t &len, const uint64_t &,
+                                          const size_t &worker)
+    {
+      if(buf[0] == 0x00)
+        {
+          decryptFrame(hds[worker].get(), buf + sparse_hdr_sz,
+                       len - sparse_hdr_sz, prefix);
+        }
+    };
+
+  std::function<void(unsigned char *, const size_t &)> write_func
+      = [result, block_sz, job](unsigned char *buf, const size_t &len)
+    {
+      if(buf[0] == 0x01)
+        {
+          uint64_t sz = 0;
+          for(int i = 0; i < 8; i++)
+            {
+              sz |= static_cast<uint64_t>(buf[1 + i]) << (8 * i);
+            }
+          result->writeZeros(sz);
+          if(job)
+            {
+              job->addProgress(sparse_rec_sz);
+            }
+          return void();
+        }
+      result->write(buf + sparse_hdr_sz + block_sz,
+                    len - sparse_hdr_sz - block_sz);
+      if(job)
+        {
+          job->addProgress(len - 4);
+        }
+    };
+
+  if(workers > 1)
+    {
+      FramePipeline pipeline(workers, budget.depth(), sparse_hdr_sz + buf_sz,
+                             buffers.get(), options.memory_budget);
+      pipeline.run(read_func, process_func, write_func);
+    }
+  else
+    {
+      std::unique_ptr<unsigned char, std::function<void(unsigned char *)>>
+          buf = buffers->get(sparse_hdr_sz + buf_sz, options.memory_budget);
+      size_t sz;
+      for(uint64_t seq = 0;; seq++)
+        {
+          sz = read_func(buf.get());
+          if(sz == 0)
+            {
+              break;
+            }
+          process_func(buf.get(), sz, seq, 0);
+          write_func(buf.get(), sz);
+        }
+    }
+
+  return read_b;
+}
+
+void
+Stirlitz::sparseRecord(gcry_mac_hd_t hd, const unsigned char &type,
+                       const uint64_t &value, const uint64_t &index,
+                       unsigned char *record, const std::string &prefix)
+{
+  // Record: type, value (8 bytes, little endian) and tag of them with number
+  // of record, so records can not be moved, dropped or replaced.
+  record[0] = type;
+  for(int i = 0; i < 8; i++)
+    {
+      record[1 + i] = static_cast<unsigned char>((value >> (8 * i)) & 0xff);
+    }
+  frameTag(hd, record, sparse_hdr_sz, index, record + sparse_hdr_sz, prefix);
+}
+
+bool
+Stirlitz::isZero(const unsigned char *buf, const size_t &sz)
+{
+  // First bytes are checked directly, then buffer is compared with itself
+  // shifted by 16 bytes: memcmp() is vectorized by C library.
+  size_t head = std::min(sz, static_cast<size_t>(16));
+  for(size_t i = 0; i < head; i++)
+    {
+      if(buf[i] != 0)
+        {
+          return false;
+        }
+    }
+  return sz <= head || std::memcmp(buf, buf + head, sz - head) == 0;
+}
+
+std::vector<unsigned char>
+Stirlitz::deriveKey(const std::string &username, const std::string &password)
+{
+  std::string pass_str = username + password;
+  return hashString(pass_str, GCRY_MD_BLAKE2S_256);
+}
+
+std::unique_ptr<gcry_cipher_handle, std::function<void(gcry_cipher_handle *)>>
+Stirlitz::cipherHandle(const std::vector<unsigned char> &key,
+                       const std::string &prefix)
+{
+  return cipherHandle(key.data(), key.size(), prefix);
+}
+
+std::unique_ptr<gcry_cipher_handle, std::function<void(gcry_cipher_handle *)>>
+Stirlitz::cipherHandle(const unsigned char *key, const size_t &key_sz,
+                       const std::string &prefix)
+{
+  gcry_cipher_hd_t handle = nullptr;
+  std::unique_lock<std::mutex> ulock(handles_mtx);
+  if(!handles.empty())
+    {
+      handle = handles.back();
+      handles.pop_back();
+    }
+  ulock.unlock();
+
+  gcry_error_t err;
+  if(handle == nullptr)
+    {
+      err = gcry_cipher_open(&handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
+                             GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
+      if(err != 0)
+        {
+          printGcryptError(err, prefix);
+        }
+    }
+
+  std::unique_ptr<gcry_cipher_handle,
+                  std::function<void(gcry_cipher_handle *)>>
+      result(handle,
+             [this](gcry_cipher_handle *hd)
+               {
+                 releaseCipherHandle(hd);
+               });
+
+  err = gcry_cipher_setkey(result.get(), key, key_sz);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix);
+    }
+
+  return result;
+}
+
+void
+Stirlitz::releaseCipherHandle(gcry_cipher_hd_t handle)
+{
+  // Key is overwritten to not keep it in idle handles.
+  std::vector<unsigned char> zero_key(
+      gcry_cipher_get_algo_keylen(GCRY_CIPHER_AES256), 0);
+  gcry_error_t err = gcry_cipher_reset(handle);
+  if(err == 0)
+    {
+      err = gcry_cipher_setkey(handle, zero_key.data(), zero_key.size());
+    }
+  if(err != 0)
+    {
+      gcry_cipher_close(handle);
+      return void();
+    }
+
+  std::unique_lock<std::mutex> ulock(handles_mtx);
+  if(handles.size() < max_idle_handles)
+    {
+      handles.push_back(handle);
+      return void();
+    }
+  ulock.unlock();
+  gcry_cipher_close(handle);
+}
+
+std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>
+Stirlitz::macHandle(const std::vector<unsigned char> &key,
+                    const std::string &prefix)
+{
+  // Tag key is derived from encryption key, so no additional secrets are
+  // needed.
+  std::string tag_key_src = "STZ frame tag";
+  tag_key_src.append(key.begin(), key.end());
+  std::vector<unsigned char> tag_key
+      = hashString(tag_key_src, GCRY_MD_BLAKE2S_256);
+
+  gcry_mac_hd_t hd;
+  gcry_error_t err = gcry_mac_open(&hd, GCRY_MAC_HMAC_SHA256,
+                                   GCRY_MAC_FLAG_SECURE, nullptr);
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_mac_open:");
+    }
+  std::unique_ptr<gcry_mac_handle, std::function<void(gcry_mac_handle *)>>
+      result(hd,
+             [](gcry_mac_handle *hd)
+               {
+                 gcry_mac_close(hd);
+               });
+
+  err = gcry_mac_setkey(result.get(), tag_key.data(), tag_key.size());
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " gcry_mac_setkey:");
+    }
+
+  return result;
+}
+
+void
+Stirlitz::frameTag(gcry_mac_hd_t hd, const unsigned char *buf,
+                   const size_t &sz, const uint64_t &index, unsigned char *tag,
+                   const std::string &prefix)
+{
+  unsigned char index_buf[8];
+  for(int i = 0; i < 8; i++)
+    {
+      index_buf[i] = static_cast<unsigned char>((index >> (8 * i)) & 0xff);
+    }
+
+  gcry_error_t err = gcry_mac_reset(hd);
+  if(err == 0)
+    {
+      err = gcry_mac_write(hd, index_buf, sizeof(index_buf));
+    }
+  if(err == 0)
+    {
+      err = gcry_mac_write(hd, buf, sz);
+    }
+  size_t tag_sz = frame_tag_sz;
+  if(err == 0)
+    {
+      err = gcry_mac_read(hd, tag, &tag_sz);
+    }
+  if(err != 0)
+    {
+      printGcryptError(err, prefix + " frame tag:");
+    }
+}
+
+void
+Stirlitz::frameTrailer(gcry_mac_hd_t hd, const uint64_t &frames,
+                       unsigned char *trailer, const std::string &prefix)
+{
+  // Trailer: number of frames (8 bytes, little endian) and its tag with
+  // index, which can not belong to any frame.
+  for(int i = 0; i < 8; i++)
+    {
+      trailer[i] = static_cast<unsigned char>((frames >> (8 * i)) & 0xff);
+    }
+  frameTag(hd, trailer, 8, UINT64_MAX, trailer + 8, prefix);
+}
+
+bool
+Stirlitz::hasTrailer(const std::filesystem::path &source_file,
+                     const uint64_t &fsz,
+                     const std::vector<unsigned char> &key,
+                     const FileOptions &options, const std::string &prefix)
+{
+  if(fsz < frame_trailer_sz)
+    {
+      return false;
+    }
+  size_t buf_sz = frameSize(options, prefix) + frame_tag_sz;
+  uint64_t body_sz = fsz - frame_trailer_sz;
+  uint64_t frames = body_sz / buf_sz;
+  if(body_sz % buf_sz != 0)
+    {
+      frames++;
+    }
+
+  std::fstream f;
+  f.open(source_file, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return false;
+    }
+  unsigned char trailer[frame_trailer_sz];
+  f.seekg(static_cast<std::streamoff>(body_sz), std::ios_base::beg);
+  f.read(reinterpret_cast<char *>(trailer), sizeof(trailer));
+  if(!f.good())
+    {
+      return false;
+    }
+  f.close();
+
+  // Trailer of file without tags matches only by chance (2^-128).
+  unsigned char expected[frame_trailer_sz];
+  frameTrailer(macHandle(key, prefix).get(), frames, expected, prefix);
+  return std::memcmp(trailer, expected, sizeof(trailer)) == 0;
+}
+
 void
 Stirlitz::printGcryptError(const gcry_error_t &err, const std::string &prefix)
 {
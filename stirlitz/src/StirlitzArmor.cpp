@@ -0,0 +1,500 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzArmor.h>
+#include <stdexcept>
+
+namespace
+{
+const std::string armor_begin = "-----BEGIN STIRLITZ MESSAGE-----";
+const std::string armor_end = "-----END STIRLITZ MESSAGE-----";
+const char hex_digits[] = "0123456789abcdef";
+const char base64_digits[]
+    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+} // namespace
+
+StirlitzArmor::StirlitzArmor(const Mode &mode, const Encoding &encoding,
+                             const bool &header, const size_t &line_length)
+{
+  this->mode = mode;
+  enc = encoding;
+  default_enc = encoding;
+  this->header = header;
+  this->line_length = line_length;
+}
+
+void
+StirlitzArmor::update(const unsigned char *data, const size_t &data_sz,
+                      std::string &result)
+{
+  if(state == End && mode == Encode)
+    {
+      throw std::runtime_error("StirlitzArmor::update: conversion is "
+                               "finished");
+    }
+  if(mode == Encode)
+    {
+      encode(data, data_sz, result);
+    }
+  else
+    {
+      decode(data, data_sz, result);
+    }
+}
+
+void
+StirlitzArmor::finish(std::string &result)
+{
+  if(mode == Encode)
+    {
+      if(state == End)
+        {
+          return void();
+        }
+      encode(nullptr, 0, result);
+      if(enc == Base64 && bits_count > 0)
+        {
+          bits <<= 24 - bits_count;
+          putChar(base64_digits[(bits >> 18) & 0x3f], result);
+          putChar(base64_digits[(bits >> 12) & 0x3f], result);
+          if(bits_count == 16)
+            {
+              putChar(base64_digits[(bits >> 6) & 0x3f], result);
+            }
+          else
+            {
+              putChar('=', result);
+            }
+          putChar('=', result);
+        }
+      if(column > 0 && (line_length > 0 || header))
+        {
+          result.push_back('\n');
+        }
+      if(header)
+        {
+          result += armor_end + "\n";
+        }
+      state = End;
+      return void();
+    }
+
+  switch(state)
+    {
+    case Begin:
+    case Headers:
+      {
+        throw std::runtime_error(
+            "StirlitzArmor::finish: armor header is incomplete");
+      }
+    case Trailer:
+      {
+        parseLine();
+        break;
+      }
+    default:
+      break;
+    }
+  if(armored && state != End)
+    {
+      throw std::runtime_error(
+          "StirlitzArmor::finish: armor trailer is missing");
+    }
+  if(enc == Hex)
+    {
+      if(bits_count > 0)
+        {
+          throw std::runtime_error(
+              "StirlitzArmor::finish: odd number of hexadecimal digits");
+        }
+    }
+  else if(!padded)
+    {
+      flushBase64(result);
+    }
+}
+
+void
+StirlitzArmor::reset()
+{
+  enc = default_enc;
+  state = Start;
+  armored = false;
+  line_start = true;
+  padded = false;
+  line.clear();
+  bits = 0;
+  bits_count = 0;
+  column = 0;
+}
+
+StirlitzArmor::Encoding
+StirlitzArmor::encoding() const
+{
+  return enc;
+}
+
+void
+StirlitzArmor::encode(const unsigned char *data, const size_t &data_sz,
+                      std::string &result)
+{
+  if(state == Start)
+    {
+      if(header)
+        {
+          result += armor_begin + "\nEncoding: ";
+          if(enc == Hex)
+            {
+              result += "hex\n\n";
+            }
+          else
+            {
+              result += "base64\n\n";
+            }
+        }
+      state = Data;
+    }
+
+  size_t out_sz;
+  if(enc == Hex)
+    {
+      out_sz = data_sz * 2;
+    }
+  else
+    {
+      out_sz = (data_sz / 3 + 1) * 4;
+    }
+  if(line_length > 0)
+    {
+      out_sz += out_sz / line_length + 1;
+    }
+  result.reserve(result.size() + out_sz);
+
+  if(enc == Hex)
+    {
+      for(size_t i = 0; i < data_sz; i++)
+        {
+          putChar(hex_digits[data[i] >> 4], result);
+          putChar(hex_digits[data[i] & 0x0f], result);
+        }
+      return void();
+    }
+
+  for(size_t i = 0; i < data_sz; i++)
+    {
+      bits = (bits << 8) | data[i];
+      bits_count += 8;
+      if(bits_count == 24)
+        {
+          putChar(base64_digits[(bits >> 18) & 0x3f], result);
+          putChar(base64_digits[(bits >> 12) & 0x3f], result);
+          putChar(base64_digits[(bits >> 6) & 0x3f], result);
+          putChar(base64_digits[bits & 0x3f], result);
+          bits = 0;
+          bits_count = 0;
+        }
+    }
+}
+
+void
+StirlitzArmor::putChar(const char &ch, std::string &result)
+{
+  if(line_length > 0 && column == line_length)
+    {
+      result.push_back('\n');
+      column = 0;
+    }
+  result.push_back(ch);
+  column++;
+}
+
+void
+StirlitzArmor::decode(const unsigned char *data, const size_t &data_sz,
+                      std::string &result)
+{
+  result.reserve(result.size() + data_sz / 2 + 3);
+  for(size_t i = 0; i < data_sz; i++)
+    {
+      const unsigned char &ch = data[i];
+      switch(state)
+        {
+        case Start:
+          {
+            if(ch == '-')
+              {
+                state = Begin;
+                line.push_back(static_cast<char>(ch));
+              }
+            else if(ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
+              {
+                state = Data;
+                line_start = false;
+                decodeChar(ch, result);
+              }
+            break;
+          }
+        case Begin:
+        case Headers:
+        case Trailer:
+          {
+            if(ch == '\n')
+              {
+                parseLine();
+              }
+            else
+              {
+                if(line.size() >= 256)
+                  {
+                    throw std::runtime_error(
+                        "StirlitzArmor::update: armor line is too long");
+                  }
+                line.push_back(static_cast<char>(ch));
+              }
+            break;
+          }
+        case Data:
+          {
+            switch(ch)
+              {
+              case '\n':
+                {
+                  line_start = true;
+                  break;
+                }
+              case ' ':
+              case '\t':
+              case '\r':
+                break;
+              case '-':
+                {
+                  if(line_start)
+                    {
+                      state = Trailer;
+                      line.push_back(static_cast<char>(ch));
+                      break;
+                    }
+                  decodeChar(ch, result);
+                  break;
+                }
+              default:
+                {
+                  line_start = false;
+                  decodeChar(ch, result);
+                  break;
+                }
+              }
+            break;
+          }
+        case End:
+          {
+            if(ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
+              {
+                throw std::runtime_error(
+                    "StirlitzArmor::update: data after armor trailer");
+              }
+            break;
+          }
+        }
+    }
+}
+
+void
+StirlitzArmor::decodeChar(const unsigned char &ch, std::string &result)
+{
+  int val = -1;
+  if(enc == Hex)
+    {
+      if(ch >= '0' && ch <= '9')
+        {
+          val = ch - '0';
+        }
+      else if(ch >= 'a' && ch <= 'f')
+        {
+          val = ch - 'a' + 10;
+        }
+      else if(ch >= 'A' && ch <= 'F')
+        {
+          val = ch - 'A' + 10;
+        }
+      if(val < 0)
+        {
+          throw std::runtime_error(
+              "StirlitzArmor::update: incorrect hexadecimal digit");
+        }
+      bits = (bits << 4) | static_cast<uint32_t>(val);
+      bits_count += 4;
+      if(bits_count == 8)
+        {
+          result.push_back(static_cast<char>(bits & 0xff));
+          bits = 0;
+          bits_count = 0;
+        }
+      return void();
+    }
+
+  if(ch == '=')
+    {
+      if(!padded)
+        {
+          if(bits_count == 0)
+            {
+              throw std::runtime_error(
+                  "StirlitzArmor::update: incorrect Base64 padding");
+            }
+          flushBase64(result);
+          padded = true;
+        }
+      return void();
+    }
+  if(ch >= 'A' && ch <= 'Z')
+    {
+      val = ch - 'A';
+    }
+  else if(ch >= 'a' && ch <= 'z')
+    {
+      val = ch - 'a' + 26;
+    }
+  else if(ch >= '0' && ch <= '9')
+    {
+      val = ch - '0' + 52;
+    }
+  else if(ch == '+')
+    {
+      val = 62;
+    }
+  else if(ch == '/')
+    {
+      val = 63;
+    }
+  if(val < 0 || padded)
+    {
+      throw std::runtime_error(
+          "StirlitzArmor::update: incorrect Base64 digit");
+    }
+  bits = (bits << 6) | static_cast<uint32_t>(val);
+  bits_count += 6;
+  if(bits_count == 24)
+    {
+      result.push_back(static_cast<char>((bits >> 16) & 0xff));
+      result.push_back(static_cast<char>((bits >> 8) & 0xff));
+      result.push_back(static_cast<char>(bits & 0xff));
+      bits = 0;
+      bits_count = 0;
+    }
+}
+
+void
+StirlitzArmor::flushBase64(std::string &result)
+{
+  switch(bits_count)
+    {
+    case 0:
+      break;
+    case 12:
+      {
+        result.push_back(static_cast<char>((bits >> 4) & 0xff));
+        break;
+      }
+    case 18:
+      {
+        result.push_back(static_cast<char>((bits >> 10) & 0xff));
+        result.push_back(static_cast<char>((bits >> 2) & 0xff));
+        break;
+      }
+    default:
+      {
+        throw std::runtime_error(
+            "StirlitzArmor::flushBase64: incomplete Base64 data");
+      }
+    }
+  bits = 0;
+  bits_count = 0;
+}
+
+void
+StirlitzArmor::parseLine()
+{
+  while(!line.empty()
+        && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+    {
+      line.pop_back();
+    }
+
+  switch(state)
+    {
+    case Begin:
+      {
+        if(line != armor_begin)
+          {
+            throw std::runtime_error(
+                "StirlitzArmor::parseLine: incorrect armor header");
+          }
+        armored = true;
+        state = Headers;
+        break;
+      }
+    case Headers:
+      {
+        if(line.empty())
+          {
+            state = Data;
+            line_start = true;
+            break;
+          }
+        std::string::size_type n = line.find(':');
+        if(n == std::string::npos)
+          {
+            throw std::runtime_error(
+                "StirlitzArmor::parseLine: incorrect armor header");
+          }
+        std::string key = line.substr(0, n);
+        std::string val = line.substr(n + 1);
+        while(!val.empty() && (val.front() == ' ' || val.front() == '\t'))
+          {
+            val.erase(val.begin());
+          }
+        if(key == "Encoding")
+          {
+            if(val == "hex")
+              {
+                enc = Hex;
+              }
+            else if(val == "base64")
+              {
+                enc = Base64;
+              }
+            else
+              {
+                throw std::runtime_error(
+                    "StirlitzArmor::parseLine: unknown encoding " + val);
+              }
+          }
+        break;
+      }
+    case Trailer:
+      {
+        if(!armored || line != armor_end)
+          {
+            throw std::runtime_error(
+                "StirlitzArmor::parseLine: incorrect armor trailer");
+          }
+        state = End;
+        break;
+      }
+    default:
+      break;
+    }
+  line.clear();
+}
@@ -0,0 +1,663 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzC.h>
+#include <Stirlitz.h>
+#include <StirlitzStream.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <string>
+
+// Field is contained in caller's version of stirlitz_file_options.
+#define HAS_FIELD(options, field)                                             \
+  ((options)->struct_size                                                     \
+   >= offsetof(stirlitz_file_options, field) + sizeof((options)->field))
+
+struct stirlitz_ctx
+{
+  std::unique_ptr<Stirlitz> spy;
+};
+
+struct stirlitz_key
+{
+  std::shared_ptr<gcry_sexp> exp;
+};
+
+struct stirlitz_stream
+{
+  std::unique_ptr<StirlitzStream> strm;
+};
+
+namespace
+{
+thread_local std::string last_error;
+
+int
+fail(const int &status, const std::string &msg)
+{
+  last_error = msg;
+  return status;
+}
+
+template <typename F>
+int
+guard(F &&func)
+{
+  try
+    {
+      last_error.clear();
+      return func();
+    }
+  catch(std::exception &er)
+    {
+      return fail(STIRLITZ_ERROR, er.what());
+    }
+  catch(...)
+    {
+      return fail(STIRLITZ_ERROR, "unknown error");
+    }
+}
+
+std::string
+toString(const char *data, const size_t &data_sz)
+{
+  if(data == nullptr)
+    {
+      return std::string();
+    }
+  return std::string(data, data_sz);
+}
+
+int
+copyResult(const std::string &data, void *out, const size_t &out_cap,
+           size_t *out_len, const std::string &prefix)
+{
+  if(out_len == nullptr || (out == nullptr && out_cap > 0))
+    {
+      return fail(STIRLITZ_INVALID_ARGUMENT, prefix + ": null pointer");
+    }
+  *out_len = data.size();
+  if(out_cap < data.size())
+    {
+      return fail(STIRLITZ_BUFFER_TOO_SMALL, prefix + ": buffer too small");
+    }
+  if(data.size() > 0)
+    {
+      std::memcpy(out, data.data(), data.size());
+    }
+  return STIRLITZ_OK;
+}
+
+Stirlitz::FileOptions
+fileOptions(const stirlitz_file_options *options)
+{
+  Stirlitz::FileOptions result;
+  // Structures of older versions do not contain last fields.
+  if(options == nullptr || !HAS_FIELD(options, frame_size))
+    {
+      return result;
+    }
+  result.direct_io = options->direct_io != 0;
+  if(options->io_uring != 0)
+    {
+      result.io_backend = Stirlitz::FileOptions::IOUring;
+    }
+  result.io_queue_depth = options->io_queue_depth;
+  result.preallocate = options->preallocate != 0;
+  result.threads = options->threads;
+  result.frame_size = options->frame_size;
+  if(HAS_FIELD(options, integrity))
+    {
+      result.integrity = options->integrity != 0;
+    }
+  if(HAS_FIELD(options, armor))
+    {
+      result.armor = options->armor != STIRLITZ_ARMOR_NONE;
+      if(options->armor == STIRLITZ_ARMOR_HEX)
+        {
+          result.armor_encoding = StirlitzArmor::Hex;
+        }
+    }
+  if(HAS_FIELD(options, memory_budget))
+    {
+      result.memory_budget = options->memory_budget;
+    }
+  if(HAS_FIELD(options, durability))
+    {
+      if(options->durability == STIRLITZ_SYNC_FILE)
+        {
+          result.durability = Stirlitz::FileOptions::SyncFile;
+        }
+      else if(options->durability == STIRLITZ_SYNC_BATCH)
+        {
+          result.durability = Stirlitz::FileOptions::SyncBatch;
+        }
+    }
+  if(HAS_FIELD(options, sparse))
+    {
+      result.sparse = options->sparse != 0;
+    }
+  if(HAS_FIELD(options, part_size))
+    {
+      result.part_size = options->part_size;
+    }
+  if(HAS_FIELD(options, batch))
+    {
+      result.batch = options->batch;
+    }
+  return result;
+}
+
+stirlitz_key *
+newKey(std::shared_ptr<gcry_sexp> exp)
+{
+  stirlitz_key *key = new stirlitz_key;
+  key->exp = exp;
+  return key;
+}
+} // namespace
+
+const char *
+stirlitz_last_error(void)
+{
+  return last_error.c_str();
+}
+
+stirlitz_ctx *
+stirlitz_ctx_new(size_t secmem_size)
+{
+  stirlitz_ctx *ctx = nullptr;
+  guard(
+      [&]
+        {
+          std::unique_ptr<stirlitz_ctx> loc(new stirlitz_ctx);
+          if(secmem_size > 0)
+            {
+              loc->spy.reset(new Stirlitz(secmem_size));
+            }
+          else
+            {
+              loc->spy.reset(new Stirlitz);
+            }
+          ctx = loc.release();
+          return STIRLITZ_OK;
+        });
+  return ctx;
+}
+
+void
+stirlitz_ctx_free(stirlitz_ctx *ctx)
+{
+  delete ctx;
+}
+
+size_t
+stirlitz_encrypted_size(size_t data_len)
+{
+  return data_len + 16;
+}
+
+size_t
+stirlitz_decrypted_size(size_t data_len)
+{
+  if(data_len < 16)
+    {
+      return 0;
+    }
+  return data_len - 16;
+}
+
+int
+stirlitz_encrypt_data(stirlitz_ctx *ctx, const char *username,
+                      size_t username_len, const char *password,
+                      size_t password_len, const uint8_t *data,
+                      size_t data_len, uint8_t *out, size_t out_cap,
+                      size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || out_len == nullptr
+             || (data == nullptr && data_len > 0))
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_encrypt_data: null pointer");
+            }
+          *out_len = data_len + 16;
+          if(out == nullptr || out_cap < *out_len)
+            {
+              return fail(STIRLITZ_BUFFER_TOO_SMALL,
+                          "stirlitz_encrypt_data: buffer too small");
+            }
+          ctx->spy->encryptData(toString(username, username_len),
+                                toString(password, password_len), data,
+                                data_len, out);
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_decrypt_data(stirlitz_ctx *ctx, const char *username,
+                      size_t username_len, const char *password,
+                      size_t password_len, const uint8_t *data,
+                      size_t data_len, uint8_t *out, size_t out_cap,
+                      size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || out_len == nullptr
+             || (data == nullptr && data_len > 0))
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_decrypt_data: null pointer");
+            }
+          *out_len = stirlitz_decrypted_size(data_len);
+          if(*out_len == 0)
+            {
+              return int(STIRLITZ_OK);
+            }
+          if(out == nullptr || out_cap < *out_len)
+            {
+              return fail(STIRLITZ_BUFFER_TOO_SMALL,
+                          "stirlitz_decrypt_data: buffer too small");
+            }
+          *out_len = ctx->spy->decryptData(toString(username, username_len),
+                                           toString(password, password_len),
+                                           data, data_len, out);
+          return int(STIRLITZ_OK);
+        });
+}
+
+stirlitz_stream *
+stirlitz_stream_new(stirlitz_ctx *ctx, int mode, const char *username,
+                    size_t username_len, const char *password,
+                    size_t password_len)
+{
+  stirlitz_stream *stream = nullptr;
+  guard(
+      [&]
+        {
+          if(ctx == nullptr
+             || (mode != STIRLITZ_ENCRYPT && mode != STIRLITZ_DECRYPT))
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_stream_new: invalid argument");
+            }
+          StirlitzStream::Mode m = StirlitzStream::Encrypt;
+          if(mode == STIRLITZ_DECRYPT)
+            {
+              m = StirlitzStream::Decrypt;
+            }
+          std::unique_ptr<stirlitz_stream> loc(new stirlitz_stream);
+          loc->strm.reset(new StirlitzStream(
+              *ctx->spy, m, toString(username, username_len),
+              toString(password, password_len)));
+          stream = loc.release();
+          return int(STIRLITZ_OK);
+        });
+  return stream;
+}
+
+size_t
+stirlitz_stream_update_size(size_t data_len)
+{
+  return StirlitzStream::updateSize(data_len);
+}
+
+size_t
+stirlitz_stream_final_size(void)
+{
+  return StirlitzStream::finishSize();
+}
+
+int
+stirlitz_stream_update(stirlitz_stream *stream, const uint8_t *data,
+                       size_t data_len, uint8_t *out, size_t out_cap,
+                       size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(stream == nullptr || out_len == nullptr
+             || (data == nullptr && data_len > 0))
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_stream_update: null pointer");
+            }
+          if(out == nullptr
+             || out_cap < StirlitzStream::updateSize(data_len))
+            {
+              *out_len = StirlitzStream::updateSize(data_len);
+              return fail(STIRLITZ_BUFFER_TOO_SMALL,
+                          "stirlitz_stream_update: buffer too small");
+            }
+          *out_len = stream->strm->update(data, data_len, out);
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_stream_final(stirlitz_stream *stream, uint8_t *out, size_t out_cap,
+                      size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(stream == nullptr || out_len == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_stream_final: null pointer");
+            }
+          if(out == nullptr || out_cap < StirlitzStream::finishSize())
+            {
+              *out_len = StirlitzStream::finishSize();
+              return fail(STIRLITZ_BUFFER_TOO_SMALL,
+                          "stirlitz_stream_final: buffer too small");
+            }
+          *out_len = stream->strm->finish(out);
+          return int(STIRLITZ_OK);
+        });
+}
+
+void
+stirlitz_stream_free(stirlitz_stream *stream)
+{
+  delete stream;
+}
+
+void
+stirlitz_file_options_init(stirlitz_file_options *options,
+                           size_t struct_size)
+{
+  if(options == nullptr || struct_size < sizeof(options->struct_size))
+    {
+      return;
+    }
+  Stirlitz::FileOptions def;
+  stirlitz_file_options loc;
+  std::memset(&loc, 0, sizeof(loc));
+  loc.struct_size = std::min(struct_size, sizeof(loc));
+  loc.direct_io = def.direct_io;
+  loc.io_uring = def.io_backend == Stirlitz::FileOptions::IOUring;
+  loc.io_queue_depth = def.io_queue_depth;
+  loc.preallocate = def.preallocate;
+  loc.threads = def.threads;
+  loc.frame_size = def.frame_size;
+  loc.integrity = def.integrity;
+  loc.armor = STIRLITZ_ARMOR_NONE;
+  loc.memory_budget = def.memory_budget;
+  loc.durability = STIRLITZ_SYNC_NONE;
+  loc.sparse = def.sparse;
+  loc.part_size = def.part_size;
+  loc.batch = def.batch;
+  // Caller's structure can be smaller (older version) or larger (newer
+  // version) than ours, fields unknown to library are zeroed.
+  std::memset(options, 0, struct_size);
+  std::memcpy(options, &loc, loc.struct_size);
+  options->struct_size = struct_size;
+}
+
+int
+stirlitz_encrypt_file(stirlitz_ctx *ctx, const char *source_path,
+                      const char *result_path, const char *username,
+                      size_t username_len, const char *password,
+                      size_t password_len,
+                      const stirlitz_file_options *options)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || source_path == nullptr
+             || result_path == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_encrypt_file: null pointer");
+            }
+          ctx->spy->encryptFile(
+              std::filesystem::u8path(source_path),
+              std::filesystem::u8path(result_path),
+              toString(username, username_len),
+              toString(password, password_len), fileOptions(options));
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_decrypt_file(stirlitz_ctx *ctx, const char *source_path,
+                      const char *result_path, const char *username,
+                      size_t username_len, const char *password,
+                      size_t password_len,
+                      const stirlitz_file_options *options)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || source_path == nullptr
+             || result_path == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_decrypt_file: null pointer");
+            }
+          ctx->spy->decryptFile(
+              std::filesystem::u8path(source_path),
+              std::filesystem::u8path(result_path),
+              toString(username, username_len),
+              toString(password, password_len), fileOptions(options));
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_new_batch(stirlitz_ctx *ctx, uint64_t *batch)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || batch == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_new_batch: null pointer");
+            }
+          *batch = ctx->spy->newBatch();
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_commit_files(stirlitz_ctx *ctx)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_commit_files: null pointer");
+            }
+          ctx->spy->commitFiles();
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_commit_batch(stirlitz_ctx *ctx, uint64_t batch)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_commit_batch: null pointer");
+            }
+          ctx->spy->commitFiles(batch);
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_key_generate(stirlitz_ctx *ctx, stirlitz_key **key)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || key == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_key_generate: null pointer");
+            }
+          *key = newKey(ctx->spy->generateKeyPair());
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_key_from_public(stirlitz_ctx *ctx, const uint8_t *public_key,
+                         size_t public_key_len, stirlitz_key **key)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || public_key == nullptr || key == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_key_from_public: null pointer");
+            }
+          std::string raw(reinterpret_cast<const char *>(public_key),
+                          public_key_len);
+          *key = newKey(ctx->spy->generatePublicKeyExp(raw));
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_key_import(stirlitz_ctx *ctx, const char *sexp, size_t sexp_len,
+                    stirlitz_key **key)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || sexp == nullptr || key == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_key_import: null pointer");
+            }
+          *key = newKey(ctx->spy->sexpFromString(std::string(sexp, sexp_len)));
+          return int(STIRLITZ_OK);
+        });
+}
+
+int
+stirlitz_key_export(stirlitz_ctx *ctx, const stirlitz_key *key, char *out,
+                    size_t out_cap, size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || key == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_key_export: null pointer");
+            }
+          std::string exp = ctx->spy->sexpToString(key->exp);
+          while(exp.size() > 0 && exp.back() == '\0')
+            {
+              exp.pop_back();
+            }
+          return copyResult(exp, out, out_cap, out_len,
+                            "stirlitz_key_export");
+        });
+}
+
+int
+stirlitz_key_public(stirlitz_ctx *ctx, const stirlitz_key *key, uint8_t *out,
+                    size_t out_cap, size_t *out_len)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || key == nullptr)
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_key_public: null pointer");
+            }
+          StirlitzKey pub;
+          try
+            {
+              pub = StirlitzKey::fromSexp(key->exp);
+            }
+          catch(std::exception &er)
+            {
+              return fail(STIRLITZ_ERROR,
+                          "stirlitz_key_public: public key not found");
+            }
+          return copyResult(pub.raw(), out, out_cap, out_len,
+                            "stirlitz_key_public");
+        });
+}
+
+void
+stirlitz_key_free(stirlitz_key *key)
+{
+  delete key;
+}
+
+int
+stirlitz_derive_credentials(stirlitz_ctx *ctx,
+                            const stirlitz_key *own_key_pair,
+                            const stirlitz_key *opponent_key, int mode,
+                            char *username, size_t username_cap,
+                            size_t *username_len, char *password,
+                            size_t password_cap, size_t *password_len)
+{
+  return guard(
+      [&]
+        {
+          if(ctx == nullptr || own_key_pair == nullptr
+             || opponent_key == nullptr
+             || (mode != STIRLITZ_ENCRYPT && mode != STIRLITZ_DECRYPT))
+            {
+              return fail(STIRLITZ_INVALID_ARGUMENT,
+                          "stirlitz_derive_credentials: invalid argument");
+            }
+          std::tuple<std::string, std::string> cred;
+          if(mode == STIRLITZ_ENCRYPT)
+            {
+              cred = ctx->spy->genUsernamePasswordEncryption(
+                  own_key_pair->exp, opponent_key->exp);
+            }
+          else
+            {
+              cred = ctx->spy->genUsernamePasswordDecryption(
+                  own_key_pair->exp, opponent_key->exp);
+            }
+          int status
+              = copyResult(std::get<0>(cred), username, username_cap,
+                           username_len, "stirlitz_derive_credentials");
+          int pstatus
+              = copyResult(std::get<1>(cred), password, password_cap,
+                           password_len, "stirlitz_derive_credentials");
+          if(status != STIRLITZ_OK)
+            {
+              return status;
+            }
+          return pstatus;
+        });
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <StirlitzHash.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+StirlitzHash::StirlitzHash(const int &algo)
+{
+  this->algo = algo;
+  gcry_md_hd_t hd_t;
+  gcry_error_t err = gcry_md_open(&hd_t, algo, GCRY_MD_FLAG_SECURE);
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzHash:");
+    }
+  hd = std::unique_ptr<gcry_md_handle,
+                       std::function<void(gcry_md_handle *)>>(
+      hd_t,
+      [](gcry_md_handle *hd)
+        {
+          gcry_md_close(hd);
+        });
+}
+
+void
+StirlitzHash::update(const unsigned char *data, const size_t &data_sz)
+{
+  gcry_md_write(hd.get(), data, data_sz);
+}
+
+void
+StirlitzHash::update(const std::string &data)
+{
+  gcry_md_write(hd.get(), data.c_str(), data.size());
+}
+
+std::vector<unsigned char>
+StirlitzHash::result()
+{
+  unsigned char *hsh = gcry_md_read(hd.get(), algo);
+  if(hsh == nullptr)
+    {
+      throw std::runtime_error("StirlitzHash::result: cannot read hash summ");
+    }
+  return std::vector<unsigned char>(hsh, hsh + size());
+}
+
+void
+StirlitzHash::reset()
+{
+  gcry_md_reset(hd.get());
+}
+
+size_t
+StirlitzHash::size() const
+{
+  return static_cast<size_t>(gcry_md_get_algo_dlen(algo));
+}
+
+void
+StirlitzHash::printGcryptError(const gcry_error_t &err,
+                               const std::string &prefix)
+{
+  std::string errstr;
+  errstr.resize(1024);
+  gpg_strerror_r(err, errstr.data(), errstr.size());
+  errstr.erase(std::find(errstr.begin(), errstr.end(), 0), errstr.end());
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << err;
+  if(!errstr.empty())
+    {
+      errstr = prefix + " " + strm.str() + " (" + errstr + ")";
+    }
+  else
+    {
+      errstr = prefix + " " + strm.str();
+    }
+  throw std::runtime_error(errstr);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzJob.h>
+#include <exception>
+
+#ifndef __ANDROID__
+#include <iostream>
+#else
+#define APPNAME "Stirlitz"
+#include <android/log.h>
+#endif
+
+StirlitzJob::StirlitzJob(std::function<void(StirlitzJob &job)> work,
+                         const Callbacks &callbacks)
+{
+  this->work = work;
+  this->callbacks = callbacks;
+  cancel_requested.store(false);
+  processed_b.store(0);
+  total_b.store(0);
+}
+
+StirlitzJob::State
+StirlitzJob::state()
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  return st;
+}
+
+uint64_t
+StirlitzJob::processed()
+{
+  return processed_b.load();
+}
+
+uint64_t
+StirlitzJob::total()
+{
+  return total_b.load();
+}
+
+void
+StirlitzJob::cancel()
+{
+  cancel_requested.store(true);
+}
+
+void
+StirlitzJob::wait()
+{
+  std::unique_lock<std::mutex> ulock(mtx);
+  cv.wait(ulock,
+          [this]
+            {
+              return done;
+            });
+}
+
+bool
+StirlitzJob::waitFor(const std::chrono::milliseconds &timeout)
+{
+  std::unique_lock<std::mutex> ulock(mtx);
+  return cv.wait_for(ulock, timeout,
+                     [this]
+                       {
+                         return done;
+                       });
+}
+
+std::string
+StirlitzJob::error()
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  return error_msg;
+}
+
+std::string
+StirlitzJob::result()
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  if(st != State::Finished)
+    {
+      return std::string();
+    }
+  return std::move(result_data);
+}
+
+void
+StirlitzJob::execute()
+{
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    if(!cancel_requested.load())
+      {
+        st = State::Running;
+      }
+  }
+  if(cancel_requested.load())
+    {
+      complete(State::Cancelled);
+      return;
+    }
+
+  try
+    {
+      work(*this);
+      complete(State::Finished);
+    }
+  catch(std::exception &er)
+    {
+      if(cancel_requested.load())
+        {
+          complete(State::Cancelled);
+        }
+      else
+        {
+          {
+            std::lock_guard<std::mutex> lglock(mtx);
+            error_msg = er.what();
+          }
+          complete(State::Failed);
+        }
+    }
+}
+
+bool
+StirlitzJob::cancelled()
+{
+  return cancel_requested.load();
+}
+
+void
+StirlitzJob::setTotal(const uint64_t &total)
+{
+  total_b.store(total);
+}
+
+void
+StirlitzJob::addProgress(const uint64_t &sz)
+{
+  uint64_t processed = processed_b.fetch_add(sz) + sz;
+  if(callbacks.progress)
+    {
+      callbacks.progress(processed, total_b.load());
+    }
+}
+
+void
+StirlitzJob::complete(const State &state)
+{
+  work = nullptr;
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    st = state;
+  }
+  if(callbacks.finished)
+    {
+      try
+        {
+          callbacks.finished(*this);
+        }
+      catch(std::exception &er)
+        {
+#ifndef __ANDROID__
+          std::cout << "StirlitzJob: finished callback error: " << er.what()
+                    << std::endl;
+#else
+          __android_log_print(ANDROID_LOG_VERBOSE, APPNAME,
+                              "StirlitzJob: finished callback error: %s",
+                              er.what());
+#endif
+        }
+    }
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    done = true;
+  }
+  cv.notify_all();
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzKey.h>
+#include <functional>
+#include <stdexcept>
+
+namespace
+{
+// First byte of compact form. S-expressions in text form start with '('.
+const char public_key_tag = 1;
+const char key_pair_tag = 2;
+const size_t raw_key_sz = 32;
+
+std::shared_ptr<gcry_sexp>
+sexpPtr(gcry_sexp_t exp)
+{
+  return std::shared_ptr<gcry_sexp>(exp,
+                                    [](gcry_sexp *exp)
+                                      {
+                                        gcry_sexp_release(exp);
+                                      });
+}
+
+std::shared_ptr<gcry_sexp>
+parseSexp(const std::string &data, const std::string &prefix)
+{
+  gcry_sexp_t exp;
+  gcry_error_t err = gcry_sexp_new(&exp, data.c_str(), data.size(), 1);
+  if(err != 0)
+    {
+      throw std::runtime_error(prefix + " incorrect data");
+    }
+  return sexpPtr(exp);
+}
+} // namespace
+
+StirlitzKey::StirlitzKey()
+{
+}
+
+StirlitzKey::StirlitzKey(const std::string &public_key)
+{
+  if(public_key.size() != raw_key_sz)
+    {
+      throw std::runtime_error("StirlitzKey: incorrect key size");
+    }
+  key = public_key;
+  fpr.resize(gcry_md_get_algo_dlen(GCRY_MD_BLAKE2S_256));
+  gcry_md_hash_buffer(GCRY_MD_BLAKE2S_256, fpr.data(), key.c_str(),
+                      key.size());
+}
+
+StirlitzKey
+StirlitzKey::fromSexp(std::shared_ptr<gcry_sexp> key)
+{
+  if(!key)
+    {
+      throw std::runtime_error("StirlitzKey::fromSexp: empty key");
+    }
+  std::string q
+      = token(key.get(), "public-key", "q", "StirlitzKey::fromSexp:");
+  // Compressed point prefix.
+  if(q.size() == raw_key_sz + 1 && q[0] == 0x40)
+    {
+      q.erase(q.begin());
+    }
+  return StirlitzKey(q);
+}
+
+std::shared_ptr<gcry_sexp>
+StirlitzKey::sexp() const
+{
+  std::shared_ptr<gcry_sexp> result;
+  if(key.empty())
+    {
+      return result;
+    }
+
+  gcry_sexp_t exp;
+  size_t erroffset = 0;
+  gcry_error_t err = gcry_sexp_build(
+      &exp, &erroffset,
+      "(public-key (ecc (curve Ed25519)(flags eddsa)(q %b)))",
+      static_cast<int>(key.size()), key.c_str());
+  if(err != 0)
+    {
+      throw std::runtime_error("StirlitzKey::sexp: cannot build S-expression");
+    }
+  result = sexpPtr(exp);
+
+  return result;
+}
+
+const std::string &
+StirlitzKey::raw() const
+{
+  return key;
+}
+
+const std::string &
+StirlitzKey::fingerprint() const
+{
+  return fpr;
+}
+
+bool
+StirlitzKey::empty() const
+{
+  return key.empty();
+}
+
+std::string
+StirlitzKey::serialize() const
+{
+  if(key.empty())
+    {
+      throw std::runtime_error("StirlitzKey::serialize: empty key");
+    }
+  return public_key_tag + key;
+}
+
+StirlitzKey
+StirlitzKey::deserialize(const std::string &data)
+{
+  if(data.size() == raw_key_sz + 1 && data[0] == public_key_tag)
+    {
+      return StirlitzKey(data.substr(1));
+    }
+  if(!data.empty() && data[0] == '(')
+    {
+      return fromSexp(parseSexp(data, "StirlitzKey::deserialize:"));
+    }
+  throw std::runtime_error("StirlitzKey::deserialize: incorrect data");
+}
+
+bool
+StirlitzKey::operator==(const StirlitzKey &other) const
+{
+  return key == other.key;
+}
+
+bool
+StirlitzKey::operator!=(const StirlitzKey &other) const
+{
+  return key != other.key;
+}
+
+std::string
+StirlitzKey::token(gcry_sexp *exp, const std::string &section,
+                   const std::string &name, const std::string &prefix)
+{
+  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> sect(
+      gcry_sexp_find_token(exp, section.c_str(), section.size()),
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+  if(!sect)
+    {
+      throw std::runtime_error(prefix + " cannot find " + section);
+    }
+
+  std::unique_ptr<gcry_sexp, std::function<void(gcry_sexp *)>> val(
+      gcry_sexp_find_token(sect.get(), name.c_str(), name.size()),
+      [](gcry_sexp *exp)
+        {
+          gcry_sexp_release(exp);
+        });
+  if(!val)
+    {
+      throw std::runtime_error(prefix + " cannot find " + name);
+    }
+
+  size_t len;
+  const char *data = gcry_sexp_nth_data(val.get(), 1, &len);
+  if(data == nullptr)
+    {
+      throw std::runtime_error(prefix + " incorrect " + name);
+    }
+  return std::string(data, len);
+}
+
+StirlitzKeyPair::StirlitzKeyPair()
+{
+}
+
+StirlitzKeyPair::StirlitzKeyPair(const std::string &public_key,
+                                 const std::string &secret_key)
+    : pub(public_key)
+{
+  if(secret_key.size() != raw_key_sz)
+    {
+      throw std::runtime_error("StirlitzKeyPair: incorrect key size");
+    }
+  unsigned char *buf
+      = reinterpret_cast<unsigned char *>(gcry_malloc_secure(raw_key_sz));
+  if(buf == nullptr)
+    {
+      throw std::runtime_error(
+          "StirlitzKeyPair: cannot allocate secure memory");
+    }
+  secret = std::shared_ptr<unsigned char>(buf,
+                                          [](unsigned char *buf)
+                                            {
+                                              gcry_free(buf);
+                                            });
+  for(size_t i = 0; i < raw_key_sz; i++)
+    {
+      buf[i] = static_cast<unsigned char>(secret_key[i]);
+    }
+}
+
+StirlitzKeyPair
+StirlitzKeyPair::generate()
+{
+  gcry_sexp_t param;
+  gcry_error_t err = gcry_sexp_build(
+      &param, nullptr, "(genkey (ecdh (curve \"Ed25519\") (flags eddsa)))");
+  if(err != 0)
+    {
+      throw std::runtime_error(
+          "StirlitzKeyPair::generate: cannot build S-expression");
+    }
+  std::shared_ptr<gcry_sexp> param_ptr = sexpPtr(param);
+
+  gcry_sexp_t exp;
+  err = gcry_pk_genkey(&exp, param_ptr.get());
+  if(err != 0)
+    {
+      throw std::runtime_error(
+          "StirlitzKeyPair::generate: key generation error");
+    }
+  return fromSexp(sexpPtr(exp));
+}
+
+StirlitzKeyPair
+StirlitzKeyPair::fromSexp(std::shared_ptr<gcry_sexp> key)
+{
+  if(!key)
+    {
+      throw std::runtime_error("StirlitzKeyPair::fromSexp: empty key");
+    }
+  std::string d = StirlitzKey::token(key.get(), "private-key", "d",
+                                     "StirlitzKeyPair::fromSexp:");
+  StirlitzKeyPair result(StirlitzKey::fromSexp(key).raw(), d);
+  // Secret key must not stay in usual memory.
+  for(auto it = d.begin(); it != d.end(); it++)
+    {
+      *it = 0;
+    }
+  return result;
+}
+
+std::shared_ptr<gcry_sexp>
+StirlitzKeyPair::sexp() const
+{
+  std::shared_ptr<gcry_sexp> result;
+  if(pub.empty())
+    {
+      return result;
+    }
+
+  const std::string &q = pub.raw();
+  gcry_sexp_t exp;
+  size_t erroffset = 0;
+  gcry_error_t err = gcry_sexp_build(
+      &exp, &erroffset,
+      "(key-data"
+      " (public-key (ecc (curve Ed25519)(flags eddsa)(q %b)))"
+      " (private-key (ecc (curve Ed25519)(flags eddsa)(q %b)(d %b))))",
+      static_cast<int>(q.size()), q.c_str(), static_cast<int>(q.size()),
+      q.c_str(), static_cast<int>(raw_key_sz), secret.get());
+  if(err != 0)
+    {
+      throw std::runtime_error(
+          "StirlitzKeyPair::sexp: cannot build S-expression");
+    }
+  result = sexpPtr(exp);
+
+  return result;
+}
+
+const StirlitzKey &
+StirlitzKeyPair::publicKey() const
+{
+  return pub;
+}
+
+bool
+StirlitzKeyPair::empty() const
+{
+  return pub.empty();
+}
+
+std::string
+StirlitzKeyPair::serialize() const
+{
+  if(pub.empty())
+    {
+      throw std::runtime_error("StirlitzKeyPair::serialize: empty key");
+    }
+  std::string result;
+  result.reserve(1 + 2 * raw_key_sz);
+  result.push_back(key_pair_tag);
+  result += pub.raw();
+  result.append(reinterpret_cast<const char *>(secret.get()), raw_key_sz);
+  return result;
+}
+
+StirlitzKeyPair
+StirlitzKeyPair::deserialize(const std::string &data)
+{
+  if(data.size() == 2 * raw_key_sz + 1 && data[0] == key_pair_tag)
+    {
+      return StirlitzKeyPair(data.substr(1, raw_key_sz),
+                             data.substr(1 + raw_key_sz));
+    }
+  if(!data.empty() && data[0] == '(')
+    {
+      return fromSexp(parseSexp(data, "StirlitzKeyPair::deserialize:"));
+    }
+  throw std::runtime_error("StirlitzKeyPair::deserialize: incorrect data");
+}
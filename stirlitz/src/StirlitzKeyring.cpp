@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzKeyring.h>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+// Serialized keyring: "STKR", format version (1 byte), number of keys (4
+// bytes, little endian), then for each key: raw public key (32 bytes),
+// length of name (2 bytes, little endian) and name.
+static const std::string keyring_magic = "STKR";
+static const unsigned char keyring_version = 1;
+static const size_t key_sz = 32;
+
+StirlitzKeyring::StirlitzKeyring(Stirlitz &spy)
+{
+  this->spy = &spy;
+}
+
+std::string
+StirlitzKeyring::add(const std::string &public_key, const std::string &name)
+{
+  if(public_key.size() != key_sz)
+    {
+      throw std::runtime_error("StirlitzKeyring::add: incorrect key size");
+    }
+  if(name.size() > UINT16_MAX)
+    {
+      throw std::runtime_error("StirlitzKeyring::add: name is too long");
+    }
+
+  Entry ent;
+  ent.public_key = public_key;
+  ent.fingerprint = fingerprint(public_key);
+  ent.name = name;
+
+  auto it = index.find(ent.fingerprint);
+  if(it != index.end())
+    {
+      keys[it->second].name = name;
+    }
+  else
+    {
+      index.insert(std::make_pair(ent.fingerprint, keys.size()));
+      keys.emplace_back(ent);
+    }
+
+  return ent.fingerprint;
+}
+
+std::string
+StirlitzKeyring::add(std::shared_ptr<gcry_sexp> key, const std::string &name)
+{
+  return add(StirlitzKey::fromSexp(key).raw(), name);
+}
+
+bool
+StirlitzKeyring::remove(const std::string &fingerprint)
+{
+  auto it = index.find(fingerprint);
+  if(it == index.end())
+    {
+      return false;
+    }
+
+  size_t pos = it->second;
+  index.erase(it);
+  if(pos != keys.size() - 1)
+    {
+      keys[pos] = std::move(keys.back());
+      index[keys[pos].fingerprint] = pos;
+    }
+  keys.pop_back();
+
+  return true;
+}
+
+const StirlitzKeyring::Entry *
+StirlitzKeyring::find(const std::string &fingerprint) const
+{
+  auto it = index.find(fingerprint);
+  if(it == index.end())
+    {
+      return nullptr;
+    }
+  return &keys[it->second];
+}
+
+std::shared_ptr<gcry_sexp>
+StirlitzKeyring::publicKey(const std::string &fingerprint)
+{
+  const Entry *ent = find(fingerprint);
+  if(ent == nullptr)
+    {
+      return std::shared_ptr<gcry_sexp>();
+    }
+  return StirlitzKey(ent->public_key).sexp();
+}
+
+const std::vector<StirlitzKeyring::Entry> &
+StirlitzKeyring::entries() const
+{
+  return keys;
+}
+
+size_t
+StirlitzKeyring::size() const
+{
+  return keys.size();
+}
+
+void
+StirlitzKeyring::clear()
+{
+  keys.clear();
+  index.clear();
+}
+
+std::string
+StirlitzKeyring::fingerprint(const std::string &public_key)
+{
+  std::vector<unsigned char> hash
+      = spy->hashString(public_key, GCRY_MD_BLAKE2S_256);
+  return std::string(hash.begin(), hash.end());
+}
+
+std::string
+StirlitzKeyring::serialize() const
+{
+  size_t sz = keyring_magic.size() + 1 + 4;
+  for(auto it = keys.begin(); it != keys.end(); it++)
+    {
+      sz += key_sz + 2 + it->name.size();
+    }
+
+  std::string result;
+  result.reserve(sz);
+  result += keyring_magic;
+  result.push_back(static_cast<char>(keyring_version));
+  uint32_t count = static_cast<uint32_t>(keys.size());
+  for(int i = 0; i < 4; i++)
+    {
+      result.push_back(static_cast<char>((count >> (8 * i)) & 0xff));
+    }
+  for(auto it = keys.begin(); it != keys.end(); it++)
+    {
+      result += it->public_key;
+      uint16_t len = static_cast<uint16_t>(it->name.size());
+      result.push_back(static_cast<char>(len & 0xff));
+      result.push_back(static_cast<char>(len >> 8));
+      result += it->name;
+    }
+
+  return result;
+}
+
+void
+StirlitzKeyring::deserialize(const std::string &data)
+{
+  size_t pos = keyring_magic.size() + 1 + 4;
+  if(data.size() < pos
+     || data.compare(0, keyring_magic.size(), keyring_magic) != 0
+     || static_cast<unsigned char>(data[keyring_magic.size()])
+            != keyring_version)
+    {
+      throw std::runtime_error(
+          "StirlitzKeyring::deserialize: incorrect keyring");
+    }
+
+  const unsigned char *d = reinterpret_cast<const unsigned char *>(data.data());
+  uint32_t count = 0;
+  for(int i = 0; i < 4; i++)
+    {
+      count |= static_cast<uint32_t>(d[keyring_magic.size() + 1 + i])
+               << (8 * i);
+    }
+
+  std::vector<Entry> loc_keys;
+  std::unordered_map<std::string, size_t> loc_index;
+  loc_keys.reserve(count);
+  loc_index.reserve(count);
+  for(uint32_t i = 0; i < count; i++)
+    {
+      if(data.size() - pos < key_sz + 2)
+        {
+          throw std::runtime_error(
+              "StirlitzKeyring::deserialize: incorrect keyring");
+        }
+      Entry ent;
+      ent.public_key = data.substr(pos, key_sz);
+      pos += key_sz;
+      size_t len = d[pos] | (static_cast<size_t>(d[pos + 1]) << 8);
+      pos += 2;
+      if(data.size() - pos < len)
+        {
+          throw std::runtime_error(
+              "StirlitzKeyring::deserialize: incorrect keyring");
+        }
+      ent.name = data.substr(pos, len);
+      pos += len;
+      ent.fingerprint = fingerprint(ent.public_key);
+      if(loc_index.insert(std::make_pair(ent.fingerprint, loc_keys.size()))
+             .second)
+        {
+          loc_keys.emplace_back(std::move(ent));
+        }
+    }
+
+  keys = std::move(loc_keys);
+  index = std::move(loc_index);
+}
+
+void
+StirlitzKeyring::load(const std::filesystem::path &file,
+                      const std::string &username, const std::string &password)
+{
+  std::ifstream f(file, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error("StirlitzKeyring::load: cannot open file");
+    }
+  std::string val((std::istreambuf_iterator<char>(f)),
+                  std::istreambuf_iterator<char>());
+  f.close();
+
+  try
+    {
+      deserialize(spy->decryptData(username, password, val));
+    }
+  catch(std::exception &er)
+    {
+      throw std::runtime_error("StirlitzKeyring::load: incorrect keyring, "
+                               "user name or password");
+    }
+}
+
+void
+StirlitzKeyring::save(const std::filesystem::path &file,
+                      const std::string &username, const std::string &password)
+{
+  std::string val = spy->encryptData(username, password, serialize());
+
+  if(!file.parent_path().empty())
+    {
+      std::filesystem::create_directories(file.parent_path());
+    }
+  std::ofstream f(file, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      throw std::runtime_error("StirlitzKeyring::save: cannot open file");
+    }
+  f.write(val.c_str(), val.size());
+  f.close();
+  if(f.fail())
+    {
+      throw std::runtime_error("StirlitzKeyring::save: write error");
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <StirlitzSessionKey.h>
+#include <gcrypt.h>
+#include <stdexcept>
+
+StirlitzSessionKey::StirlitzSessionKey()
+{
+}
+
+StirlitzSessionKey::StirlitzSessionKey(const std::string &username,
+                                       const std::string &password)
+{
+  // BLAKE2s-256 of user name followed by password (see
+  // Stirlitz::deriveKey()). Hash state is kept in secure memory, so
+  // credentials are not concatenated in usual memory.
+  gcry_md_hd_t hd;
+  gcry_error_t err = gcry_md_open(&hd, GCRY_MD_BLAKE2S_256,
+                                  GCRY_MD_FLAG_SECURE);
+  if(err != 0)
+    {
+      throw std::runtime_error(
+          "StirlitzSessionKey: cannot open hash function");
+    }
+  gcry_md_write(hd, username.c_str(), username.size());
+  gcry_md_write(hd, password.c_str(), password.size());
+
+  key_sz = gcry_md_get_algo_dlen(GCRY_MD_BLAKE2S_256);
+  unsigned char *buf
+      = reinterpret_cast<unsigned char *>(gcry_malloc_secure(key_sz));
+  if(buf == nullptr)
+    {
+      gcry_md_close(hd);
+      throw std::runtime_error(
+          "StirlitzSessionKey: cannot allocate secure memory");
+    }
+  key = std::shared_ptr<unsigned char>(buf,
+                                       [](unsigned char *buf)
+                                         {
+                                           gcry_free(buf);
+                                         });
+  const unsigned char *hsh = gcry_md_read(hd, GCRY_MD_BLAKE2S_256);
+  if(hsh == nullptr)
+    {
+      gcry_md_close(hd);
+      key.reset();
+      throw std::runtime_error("StirlitzSessionKey: cannot read hash summ");
+    }
+  for(size_t i = 0; i < key_sz; i++)
+    {
+      buf[i] = hsh[i];
+    }
+  gcry_md_close(hd);
+}
+
+const unsigned char *
+StirlitzSessionKey::data() const
+{
+  return key.get();
+}
+
+size_t
+StirlitzSessionKey::size() const
+{
+  return key_sz;
+}
+
+bool
+StirlitzSessionKey::empty() const
+{
+  return !key;
+}
+
+void
+StirlitzSessionKey::clear()
+{
+  key.reset();
+  key_sz = 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <StirlitzStream.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+StirlitzStream::StirlitzStream(Stirlitz &spy, const Mode &mode,
+                               const std::string &username,
+                               const std::string &password)
+{
+  this->mode = mode;
+  block_sz = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+
+  std::vector<unsigned char> key
+      = spy.hashString(username + password, GCRY_MD_BLAKE2S_256);
+
+  // Bulk of message is processed by plain CBC, last two blocks are
+  // processed by CBC with cipher text stealing (same as one-shot methods).
+  gcry_cipher_hd_t hd;
+  gcry_error_t err = gcry_cipher_open(&hd, GCRY_CIPHER_AES256,
+                                      GCRY_CIPHER_MODE_CBC, GCRY_CIPHER_SECURE);
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream:");
+    }
+  cbc = std::unique_ptr<gcry_cipher_handle,
+                        std::function<void(gcry_cipher_handle *)>>(
+      hd,
+      [](gcry_cipher_handle *hd)
+        {
+          gcry_cipher_close(hd);
+        });
+
+  err = gcry_cipher_open(&hd, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC,
+                         GCRY_CIPHER_CBC_CTS | GCRY_CIPHER_SECURE);
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream:");
+    }
+  cts = std::unique_ptr<gcry_cipher_handle,
+                        std::function<void(gcry_cipher_handle *)>>(
+      hd,
+      [](gcry_cipher_handle *hd)
+        {
+          gcry_cipher_close(hd);
+        });
+
+  err = gcry_cipher_setkey(cbc.get(), key.data(), key.size());
+  if(err == 0)
+    {
+      err = gcry_cipher_setkey(cts.get(), key.data(), key.size());
+    }
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream:");
+    }
+
+  std::vector<unsigned char> iv(block_sz);
+  gcry_create_nonce(iv.data(), iv.size());
+  err = gcry_cipher_setiv(cbc.get(), iv.data(), iv.size());
+  if(err == 0)
+    {
+      err = gcry_cipher_setiv(cts.get(), iv.data(), iv.size());
+    }
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream:");
+    }
+
+  tail.reserve(3 * block_sz);
+  last_block.resize(block_sz);
+  if(mode == Mode::Encrypt)
+    {
+      // Message starts from random block.
+      tail.resize(block_sz);
+      gcry_randomize(tail.data(), tail.size(), GCRY_STRONG_RANDOM);
+    }
+  else
+    {
+      // First decrypted block is random and is not returned.
+      skip_first = true;
+    }
+}
+
+size_t
+StirlitzStream::update(const unsigned char *data, const size_t &data_sz,
+                       unsigned char *result)
+{
+  if(finished)
+    {
+      throw std::runtime_error("StirlitzStream::update: stream is finished");
+    }
+
+  // At least 17 bytes are always kept back: last two blocks of message are
+  // unknown until finish().
+  size_t keep = block_sz + 1;
+  size_t written = 0;
+  const unsigned char *in = data;
+  size_t rem = data_sz;
+
+  // Kept bytes are completed up to block boundary.
+  while(rem > 0
+        && (tail.size() % block_sz != 0
+            || (skip_first && tail.size() < block_sz)))
+    {
+      size_t cp = std::min(rem, block_sz - tail.size() % block_sz);
+      tail.insert(tail.end(), in, in + cp);
+      in += cp;
+      rem -= cp;
+    }
+
+  std::vector<unsigned char> skipped;
+  while(tail.size() >= block_sz && tail.size() + rem >= keep + block_sz)
+    {
+      if(skip_first)
+        {
+          skipped.resize(block_sz);
+          process(tail.data(), skipped.data(), block_sz);
+          skip_first = false;
+        }
+      else
+        {
+          process(tail.data(), result + written, block_sz);
+          written += block_sz;
+        }
+      tail.erase(tail.begin(), tail.begin() + block_sz);
+    }
+
+  // Bulk of data goes from caller's buffer to caller's buffer.
+  if(tail.empty() && rem >= keep + block_sz)
+    {
+      size_t sz = ((rem - keep) / block_sz) * block_sz;
+      process(in, result + written, sz);
+      written += sz;
+      in += sz;
+      rem -= sz;
+    }
+
+  tail.insert(tail.end(), in, in + rem);
+
+  return written;
+}
+
+size_t
+StirlitzStream::finish(unsigned char *result)
+{
+  if(finished)
+    {
+      throw std::runtime_error("StirlitzStream::finish: stream is finished");
+    }
+  finished = true;
+
+  if(tail.size() < block_sz)
+    {
+      // Only possible for decryption of incorrect data (same result as
+      // Stirlitz::decryptData()).
+      return 0;
+    }
+
+  gcry_error_t err;
+  if(processed)
+    {
+      err = gcry_cipher_setiv(cts.get(), last_block.data(), last_block.size());
+      if(err != 0)
+        {
+          printGcryptError(err, "StirlitzStream::finish:");
+        }
+    }
+
+  size_t result_sz = tail.size();
+  if(mode == Mode::Encrypt)
+    {
+      err = gcry_cipher_encrypt(cts.get(), tail.data(), tail.size(), nullptr,
+                                0);
+    }
+  else
+    {
+      err = gcry_cipher_decrypt(cts.get(), tail.data(), tail.size(), nullptr,
+                                0);
+    }
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream::finish:");
+    }
+
+  if(skip_first)
+    {
+      result_sz -= block_sz;
+      std::memcpy(result, tail.data() + block_sz, result_sz);
+    }
+  else
+    {
+      std::memcpy(result, tail.data(), result_sz);
+    }
+  std::fill(tail.begin(), tail.end(), 0);
+  tail.clear();
+
+  return result_sz;
+}
+
+size_t
+StirlitzStream::updateSize(const size_t &data_sz)
+{
+  return data_sz + 2 * gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+}
+
+size_t
+StirlitzStream::finishSize()
+{
+  return 2 * gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+}
+
+void
+StirlitzStream::process(const unsigned char *data, unsigned char *result,
+                        const size_t &sz)
+{
+  gcry_error_t err;
+  if(mode == Mode::Encrypt)
+    {
+      err = gcry_cipher_encrypt(cbc.get(), result, sz, data, sz);
+      std::memcpy(last_block.data(), result + sz - block_sz, block_sz);
+    }
+  else
+    {
+      std::memcpy(last_block.data(), data + sz - block_sz, block_sz);
+      err = gcry_cipher_decrypt(cbc.get(), result, sz, data, sz);
+    }
+  if(err != 0)
+    {
+      printGcryptError(err, "StirlitzStream:");
+    }
+  processed = true;
+}
+
+void
+StirlitzStream::printGcryptError(const gcry_error_t &err,
+                                 const std::string &prefix)
+{
+  std::string errstr;
+  errstr.resize(1024);
+  gpg_strerror_r(err, errstr.data(), errstr.size());
+  errstr.erase(std::find(errstr.begin(), errstr.end(), 0), errstr.end());
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << err;
+  if(!errstr.empty())
+    {
+      errstr = prefix + " " + strm.str() + " (" + errstr + ")";
+    }
+  else
+    {
+      errstr = prefix + " " + strm.str();
+    }
+  throw std::runtime_error(errstr);
+}
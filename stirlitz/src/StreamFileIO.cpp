@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <StreamFileIO.h>
+#include <stdexcept>
+
+StreamFileIO::StreamFileIO(std::istream *in)
+{
+  this->in = in;
+}
+
+StreamFileIO::StreamFileIO(std::ostream *out)
+{
+  this->out = out;
+}
+
+size_t
+StreamFileIO::read(unsigned char *buf, const size_t &sz)
+{
+  if(in == nullptr)
+    {
+      throw std::runtime_error("StreamFileIO::read: stream is not readable");
+    }
+  in->read(reinterpret_cast<char *>(buf), sz);
+  if(in->bad())
+    {
+      throw std::runtime_error("StreamFileIO::read: read error");
+    }
+  return static_cast<size_t>(in->gcount());
+}
+
+void
+StreamFileIO::write(const unsigned char *buf, const size_t &sz)
+{
+  if(out == nullptr)
+    {
+      throw std::runtime_error("StreamFileIO::write: stream is not writable");
+    }
+  out->write(reinterpret_cast<const char *>(buf), sz);
+  if(!out->good())
+    {
+      throw std::runtime_error("StreamFileIO::write: write error");
+    }
+}
+
+void
+StreamFileIO::close()
+{
+  if(out)
+    {
+      out->flush();
+      if(!out->good())
+        {
+          throw std::runtime_error("StreamFileIO::close: write error");
+        }
+    }
+}
+
+uint64_t
+StreamFileIO::size()
+{
+  return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STREAMFILEIO_H
+#define STREAMFILEIO_H
+
+#include <FileIO.h>
+#include <istream>
+#include <ostream>
+
+// Adapter of standard streams (pipes, standard input and output etc.). Size
+// of such sources is unknown, so size() always returns 0.
+class StreamFileIO : public FileIO
+{
+public:
+  StreamFileIO(std::istream *in);
+
+  StreamFileIO(std::ostream *out);
+
+  size_t
+  read(unsigned char *buf, const size_t &sz) override;
+
+  void
+  write(const unsigned char *buf, const size_t &sz) override;
+
+  void
+  close() override;
+
+  uint64_t
+  size() override;
+
+private:
+  std::istream *in = nullptr;
+  std::ostream *out = nullptr;
+};
+
+#endif // STREAMFILEIO_H
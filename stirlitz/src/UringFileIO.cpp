@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <UringFileIO.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+UringFileIO::UringFileIO(const std::filesystem::path &p, const Mode &mode,
+                         const bool &direct_io, const size_t &queue_depth)
+{
+  this->mode = mode;
+  this->direct_io = direct_io;
+  int flags;
+  switch(mode)
+    {
+    case Mode::Read:
+      {
+        flags = O_RDONLY;
+        break;
+      }
+    case Mode::Write:
+    default:
+      {
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+        break;
+      }
+    }
+  if(direct_io)
+    {
+      fd = ::open(p.c_str(), flags | O_DIRECT | O_CLOEXEC, 0666);
+      if(fd < 0 && errno == EINVAL)
+        {
+          this->direct_io = false;
+        }
+    }
+  if(!this->direct_io)
+    {
+      fd = ::open(p.c_str(), flags | O_CLOEXEC, 0666);
+    }
+  if(fd < 0)
+    {
+      throw std::runtime_error("UringFileIO: cannot open file: "
+                               + std::string(std::strerror(errno)));
+    }
+
+  unsigned int depth = static_cast<unsigned int>(
+      std::clamp(queue_depth, static_cast<size_t>(1), static_cast<size_t>(64)));
+  int res = io_uring_queue_init(depth, &ring, 0);
+  if(res < 0)
+    {
+      release();
+      throw std::runtime_error("UringFileIO: io_uring initialization error: "
+                               + std::string(std::strerror(-res)));
+    }
+  ring_initialized = true;
+
+  chunks.resize(depth);
+  std::vector<struct iovec> iov(depth);
+  for(size_t i = 0; i < chunks.size(); i++)
+    {
+      void *ptr;
+      if(posix_memalign(&ptr, align, chunk_sz) != 0)
+        {
+          release();
+          throw std::runtime_error("UringFileIO: cannot allocate buffer");
+        }
+      chunks[i].buf = reinterpret_cast<unsigned char *>(ptr);
+      iov[i].iov_base = ptr;
+      iov[i].iov_len = chunk_sz;
+    }
+  // Registration can fail because of RLIMIT_MEMLOCK on older kernels. Not
+  // registered buffers are used in this case.
+  buffers_registered = io_uring_register_buffers(&ring, iov.data(), depth) == 0;
+
+  if(mode == Mode::Read)
+    {
+      fsz = size();
+      for(size_t i = 0; i < chunks.size(); i++)
+        {
+          submitChunk(i);
+        }
+    }
+}
+
+UringFileIO::~UringFileIO()
+{
+  release();
+}
+
+size_t
+UringFileIO::read(unsigned char *buf, const size_t &sz)
+{
+  size_t result = 0;
+  while(result < sz)
+    {
+      Chunk &chunk = chunks[current];
+      if(chunk.requested == 0)
+        {
+          break;
+        }
+      waitChunk(current);
+      size_t avail = chunk.done - current_pos;
+      if(avail == 0)
+        {
+          if(chunk.done < chunk.requested)
+            {
+              break;
+            }
+          submitChunk(current);
+          current = (current + 1) % chunks.size();
+          current_pos = 0;
+          continue;
+        }
+      size_t cp = std::min(sz - result, avail);
+      std::memcpy(buf + result, chunk.buf + current_pos, cp);
+      current_pos += cp;
+      result += cp;
+    }
+  return result;
+}
+
+void
+UringFileIO::write(const unsigned char *buf, const size_t &sz)
+{
+  size_t written = 0;
+  while(written < sz)
+    {
+      Chunk &chunk = chunks[current];
+      waitChunk(current);
+      size_t cp = std::min(sz - written, chunk_sz - current_pos);
+      std::memcpy(chunk.buf + current_pos, buf + written, cp);
+      current_pos += cp;
+      written += cp;
+      if(current_pos == chunk_sz)
+        {
+          chunk.offset = next_offset;
+          chunk.requested = chunk_sz;
+          chunk.done = 0;
+          next_offset += chunk_sz;
+          queueChunk(current);
+          current = (current + 1) % chunks.size();
+          current_pos = 0;
+        }
+    }
+}
+
+void
+UringFileIO::close()
+{
+  if(fd < 0)
+    {
+      return void();
+    }
+  for(size_t i = 0; i < chunks.size(); i++)
+    {
+      waitChunk(i);
+    }
+  if(mode == Mode::Write && current_pos > 0)
+    {
+      Chunk &chunk = chunks[current];
+      size_t aligned = current_pos;
+      if(direct_io)
+        {
+          aligned -= current_pos % align;
+        }
+      if(aligned > 0)
+        {
+          chunk.offset = next_offset;
+          chunk.requested = aligned;
+          chunk.done = 0;
+          next_offset += aligned;
+          queueChunk(current);
+          waitChunk(current);
+        }
+      if(aligned < current_pos)
+        {
+          // Unaligned tail: O_DIRECT is switched off for last write.
+          int flags = fcntl(fd, F_GETFL);
+          if(flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) < 0)
+            {
+              throw std::runtime_error("UringFileIO::close: "
+                                       + std::string(std::strerror(errno)));
+            }
+          size_t written = aligned;
+          while(written < current_pos)
+            {
+              ssize_t wb = pwrite(fd, chunk.buf + written,
+                                  current_pos - written,
+                                  static_cast<off_t>(next_offset));
+              if(wb < 0)
+                {
+                  if(errno == EINTR)
+                    {
+                      continue;
+                    }
+                  throw std::runtime_error(
+                      "UringFileIO::close: "
+                      + std::string(std::strerror(errno)));
+                }
+              written += static_cast<size_t>(wb);
+              next_offset += static_cast<uint64_t>(wb);
+            }
+        }
+      current_pos = 0;
+    }
+  int res = ::close(fd);
+  fd = -1;
+  if(res != 0)
+    {
+      throw std::runtime_error("UringFileIO::close: "
+                               + std::string(std::strerror(errno)));
+    }
+}
+
+uint64_t
+UringFileIO::size()
+{
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    {
+      throw std::runtime_error("UringFileIO::size: "
+                               + std::string(std::strerror(errno)));
+    }
+  return static_cast<uint64_t>(st.st_size);
+}
+
+void
+UringFileIO::preallocate(const uint64_t &sz)
+{
+  allocate(fd, sz);
+}
+
+bool
+UringFileIO::isAvailable()
+{
+  static std::once_flag probe_flag;
+  static bool result = false;
+  std::call_once(probe_flag,
+                 []
+                   {
+                     struct io_uring probe_ring;
+                     if(io_uring_queue_init(1, &probe_ring, 0) == 0)
+                       {
+                         io_uring_queue_exit(&probe_ring);
+                         result = true;
+                       }
+                   });
+  return result;
+}
+
+void
+UringFileIO::submitChunk(const size_t &index)
+{
+  Chunk &chunk = chunks[index];
+  chunk.done = 0;
+  if(next_offset >= fsz)
+    {
+      chunk.requested = 0;
+      return void();
+    }
+  chunk.offset = next_offset;
+  chunk.requested
+      = static_cast<size_t>(std::min(static_cast<uint64_t>(chunk_sz),
+                                     fsz - next_offset));
+  next_offset += chunk.requested;
+  queueChunk(index);
+}
+
+void
+UringFileIO::queueChunk(const size_t &index)
+{
+  Chunk &chunk = chunks[index];
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+  if(sqe == nullptr)
+    {
+      io_uring_submit(&ring);
+      sqe = io_uring_get_sqe(&ring);
+      if(sqe == nullptr)
+        {
+          throw std::runtime_error("UringFileIO: submission queue is full");
+        }
+    }
+
+  unsigned char *ptr = chunk.buf + chunk.done;
+  size_t len = chunk.requested - chunk.done;
+  if(direct_io && mode == Mode::Read && len % align != 0)
+    {
+      // Direct reads must be aligned, reading beyond end of file is allowed.
+      len += align - len % align;
+    }
+  uint64_t offset = chunk.offset + chunk.done;
+  int buf_index = static_cast<int>(index);
+
+  if(mode == Mode::Read)
+    {
+      if(buffers_registered)
+        {
+          io_uring_prep_read_fixed(sqe, fd, ptr, static_cast<unsigned>(len),
+                                   offset, buf_index);
+        }
+      else
+        {
+          io_uring_prep_read(sqe, fd, ptr, static_cast<unsigned>(len),
+                             offset);
+        }
+    }
+  else
+    {
+      if(buffers_registered)
+        {
+          io_uring_prep_write_fixed(sqe, fd, ptr, static_cast<unsigned>(len),
+                                    offset, buf_index);
+        }
+      else
+        {
+          io_uring_prep_write(sqe, fd, ptr, static_cast<unsigned>(len),
+                              offset);
+        }
+    }
+  io_uring_sqe_set_data(sqe, &chunk);
+
+  int res = io_uring_submit(&ring);
+  if(res < 0)
+    {
+      throw std::runtime_error("UringFileIO: submission error: "
+                               + std::string(std::strerror(-res)));
+    }
+  chunk.in_flight = true;
+}
+
+void
+UringFileIO::waitChunk(const size_t &index)
+{
+  while(chunks[index].in_flight)
+    {
+      completeOne();
+    }
+}
+
+void
+UringFileIO::completeOne()
+{
+  struct io_uring_cqe *cqe;
+  int res;
+  do
+    {
+      res = io_uring_wait_cqe(&ring, &cqe);
+    }
+  while(res == -EINTR);
+  if(res < 0)
+    {
+      throw std::runtime_error("UringFileIO: completion error: "
+                               + std::string(std::strerror(-res)));
+    }
+
+  Chunk *chunk = reinterpret_cast<Chunk *>(io_uring_cqe_get_data(cqe));
+  res = cqe->res;
+  io_uring_cqe_seen(&ring, cqe);
+
+  chunk->in_flight = false;
+  if(res < 0)
+    {
+      throw std::runtime_error("UringFileIO: I/O error: "
+                               + std::string(std::strerror(-res)));
+    }
+  if(res == 0)
+    {
+      if(mode == Mode::Write)
+        {
+          throw std::runtime_error("UringFileIO: nothing has been written");
+        }
+      return void();
+    }
+  chunk->done = std::min(chunk->done + static_cast<size_t>(res),
+                         chunk->requested);
+  if(chunk->done < chunk->requested)
+    {
+      queueChunk(static_cast<size_t>(chunk - chunks.data()));
+    }
+}
+
+void
+UringFileIO::release()
+{
+  if(ring_initialized)
+    {
+      // Kernel can still write to buffers, all requests must be completed
+      // before buffers are freed.
+      for(size_t i = 0; i < chunks.size(); i++)
+        {
+          while(chunks[i].in_flight)
+            {
+              struct io_uring_cqe *cqe;
+              int res = io_uring_wait_cqe(&ring, &cqe);
+              if(res == -EINTR)
+                {
+                  continue;
+                }
+              if(res < 0)
+                {
+                  break;
+                }
+              Chunk *chunk
+                  = reinterpret_cast<Chunk *>(io_uring_cqe_get_data(cqe));
+              chunk->in_flight = false;
+              io_uring_cqe_seen(&ring, cqe);
+            }
+        }
+      if(buffers_registered)
+        {
+          io_uring_unregister_buffers(&ring);
+          buffers_registered = false;
+        }
+      io_uring_queue_exit(&ring);
+      ring_initialized = false;
+    }
+  // Chunks hold plain text of source or result, so they are wiped as frame
+  // buffers of BufferPool. Call through volatile pointer can not be removed
+  // by optimizer.
+  static void *(*const volatile wipe_func)(void *, int, size_t) = std::memset;
+  for(size_t i = 0; i < chunks.size(); i++)
+    {
+      if(chunks[i].buf != nullptr)
+        {
+          wipe_func(chunks[i].buf, 0, chunk_sz);
+        }
+      free(chunks[i].buf);
+      chunks[i].buf = nullptr;
+    }
+  if(fd >= 0)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+}
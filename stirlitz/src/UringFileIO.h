@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef URINGFILEIO_H
+#define URINGFILEIO_H
+
+#include <FileIO.h>
+#include <liburing.h>
+#include <vector>
+
+/*
+ * Reads and writes files by io_uring. File is divided into chunks, several
+ * chunks are kept in flight: reads are queued ahead of the reader, writes
+ * are queued behind the writer and completed in background. Chunk buffers are
+ * registered in ring, so kernel does not need to map them on each I/O.
+ */
+class UringFileIO : public FileIO
+{
+public:
+  UringFileIO(const std::filesystem::path &p, const Mode &mode,
+              const bool &direct_io, const size_t &queue_depth);
+
+  ~UringFileIO();
+
+  size_t
+  read(unsigned char *buf, const size_t &sz) override;
+
+  void
+  write(const unsigned char *buf, const size_t &sz) override;
+
+  void
+  close() override;
+
+  uint64_t
+  size() override;
+
+  void
+  preallocate(const uint64_t &sz) override;
+
+  static bool
+  isAvailable();
+
+private:
+  struct Chunk
+  {
+    unsigned char *buf = nullptr;
+    uint64_t offset = 0;
+    size_t requested = 0;
+    size_t done = 0;
+    bool in_flight = false;
+  };
+
+  void
+  submitChunk(const size_t &index);
+
+  void
+  queueChunk(const size_t &index);
+
+  void
+  waitChunk(const size_t &index);
+
+  void
+  completeOne();
+
+  void
+  release();
+
+  int fd = -1;
+  Mode mode;
+  bool direct_io = false;
+
+  struct io_uring ring;
+  bool ring_initialized = false;
+  bool buffers_registered = false;
+
+  std::vector<Chunk> chunks;
+  size_t chunk_sz = 2097152;
+  const size_t align = 4096;
+
+  uint64_t fsz = 0;
+  uint64_t next_offset = 0;
+  size_t current = 0;
+  size_t current_pos = 0;
+};
+
+#endif // URINGFILEIO_H
@@ -67,53 +67,127 @@
 <context>
     <name>FileTabWidget</name>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="63"/>
-        <source>File to be encrypted or decrypted</source>
-        <translation>Файл, нуждающийся в шифровании или дешифровке</translation>
+        <location filename="../src/FileTabWidget.cpp" line="87"/>
+        <source>File</source>
+        <translation>Файл</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="67"/>
-        <source>Open</source>
-        <translation>Открыть</translation>
+        <location filename="../src/FileTabWidget.cpp" line="87"/>
+        <source>Result</source>
+        <translation>Результат</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="72"/>
-        <source>Resulting file path</source>
-        <translation>Путь к файлу результата</translation>
+        <location filename="../src/FileTabWidget.cpp" line="88"/>
+        <source>State</source>
+        <translation>Состояние</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="76"/>
-        <source>Save as...</source>
-        <translation>Сохранить как...</translation>
+        <location filename="../src/FileTabWidget.cpp" line="98"/>
+        <source>Drop files here or press &quot;Add files&quot;</source>
+        <translation>Перетащите файлы сюда или нажмите &quot;Добавить файлы&quot;</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="87"/>
+        <location filename="../src/FileTabWidget.cpp" line="105"/>
+        <source>Add files</source>
+        <translation>Добавить файлы</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="110"/>
+        <source>Clear list</source>
+        <translation>Очистить список</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="118"/>
+        <source>Folder for resulting files (next to source files if empty)</source>
+        <translation>Папка для файлов результата (рядом с исходными файлами, если не указана)</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="124"/>
+        <source>Choose...</source>
+        <translation>Выбрать...</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="133"/>
+        <source>Simultaneous jobs:</source>
+        <translation>Одновременных заданий:</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="151"/>
         <source>Encrypt</source>
         <translation>Зашифровать</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="92"/>
+        <location filename="../src/FileTabWidget.cpp" line="160"/>
         <source>Decrypt</source>
         <translation>Расшифровать</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="173"/>
-        <location filename="../src/FileTabWidget.cpp" line="223"/>
-        <source>Operation in progress...</source>
-        <translation>Операция выполняется...</translation>
+        <location filename="../src/FileTabWidget.cpp" line="169"/>
+        <source>Cancel</source>
+        <translation>Отмена</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="582"/>
+        <source>Waiting</source>
+        <translation>Ожидает</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="587"/>
+        <source>In progress</source>
+        <translation>Выполняется</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="592"/>
+        <source>Done</source>
+        <translation>Готово</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="597"/>
+        <source>Error</source>
+        <translation>Ошибка</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="602"/>
+        <source>Cancelled</source>
+        <translation>Отменено</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="634"/>
+        <source>Files: </source>
+        <translation>Файлы: </translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="635"/>
+        <source>, processed: </source>
+        <translation>, обработано: </translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="273"/>
-        <source>File has been successfully decrypted</source>
-        <translation>Файл бы успешно расшифрован</translation>
+        <location filename="../src/FileTabWidget.cpp" line="641"/>
+        <source> MiB</source>
+        <translation> МиБ</translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="279"/>
-        <source>File has been successfully encrypted</source>
-        <translation>Файл бы успешно зашифрован</translation>
+        <location filename="../src/FileTabWidget.cpp" line="651"/>
+        <source>, speed: </source>
+        <translation>, скорость: </translation>
     </message>
     <message>
-        <location filename="../src/FileTabWidget.cpp" line="285"/>
+        <location filename="../src/FileTabWidget.cpp" line="652"/>
+        <source> MiB/s</source>
+        <translation> МиБ/с</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="669"/>
+        <source>Files have been successfully decrypted</source>
+        <translation>Файлы были успешно расшифрованы</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="675"/>
+        <source>Files have been successfully encrypted</source>
+        <translation>Файлы были успешно зашифрованы</translation>
+    </message>
+    <message>
+        <location filename="../src/FileTabWidget.cpp" line="681"/>
         <source>Error!</source>
         <translation>Ошибка!</translation>
     </message>
@@ -352,53 +426,103 @@
         <source>Operation successfully completed!</source>
         <translation>Операция успешно завершена!</translation>
     </message>
+    <message>
+        <location filename="../src/SimpleFileEncryptionTab.cpp" line="124"/>
+        <source>Cancel</source>
+        <translation>Отмена</translation>
+    </message>
+    <message>
+        <location filename="../src/SimpleFileEncryptionTab.cpp" line="351"/>
+        <source>Processed: </source>
+        <translation>Обработано: </translation>
+    </message>
+    <message>
+        <location filename="../src/SimpleFileEncryptionTab.cpp" line="352"/>
+        <source> MiB, speed: </source>
+        <translation> МиБ, скорость: </translation>
+    </message>
+    <message>
+        <location filename="../src/SimpleFileEncryptionTab.cpp" line="353"/>
+        <source> MiB/s</source>
+        <translation> МиБ/с</translation>
+    </message>
 </context>
 <context>
     <name>TextTabWidget</name>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="62"/>
+        <location filename="../src/TextTabWidget.cpp" line="82"/>
         <source>Text to be encrypted or text to be decrypted</source>
         <translation>Текст, нуждающийся в шифровании или дешифровке</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="69"/>
+        <location filename="../src/TextTabWidget.cpp" line="89"/>
         <source>Encrypt</source>
         <translation>Зашифровать</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="74"/>
+        <location filename="../src/TextTabWidget.cpp" line="94"/>
         <source>Decrypt</source>
         <translation>Расшифровать</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="84"/>
+        <location filename="../src/TextTabWidget.cpp" line="99"/>
+        <source>Cancel</source>
+        <translation>Отмена</translation>
+    </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="117"/>
         <source>Paste</source>
         <translation>Вставить</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="94"/>
+        <location filename="../src/TextTabWidget.cpp" line="127"/>
         <source>Clear</source>
         <translation>Очистить</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="103"/>
+        <location filename="../src/TextTabWidget.cpp" line="136"/>
         <source>Load from file</source>
         <translation>Загрузить из файла</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="112"/>
+        <location filename="../src/TextTabWidget.cpp" line="150"/>
         <source>Result</source>
         <translation>Результат</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="120"/>
+        <location filename="../src/TextTabWidget.cpp" line="163"/>
         <source>Copy result</source>
         <translation>Копировать результат</translation>
     </message>
     <message>
-        <location filename="../src/TextTabWidget.cpp" line="130"/>
+        <location filename="../src/TextTabWidget.cpp" line="176"/>
         <source>Save result</source>
         <translation>Сохранить результат</translation>
     </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="188"/>
+        <source>Encrypt file to text file</source>
+        <translation>Зашифровать файл в текстовый файл</translation>
+    </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="197"/>
+        <source>Decrypt text file</source>
+        <translation>Расшифровать текстовый файл</translation>
+    </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="388"/>
+        <source>Result is too large to be shown completely (%1 of %2 bytes are shown). Use &quot;Copy result&quot; or &quot;Save result&quot; to get whole result.</source>
+        <translation>Результат слишком велик для полного отображения (показано %1 из %2 байт). Используйте «Копировать результат» или «Сохранить результат», чтобы получить весь результат.</translation>
+    </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="542"/>
+        <source>Operation successfully completed!</source>
+        <translation>Операция успешно завершена!</translation>
+    </message>
+    <message>
+        <location filename="../src/TextTabWidget.cpp" line="547"/>
+        <source>Error! See system log for details.</source>
+        <translation>Ошибка! См. системный журнал для получения подробностей.</translation>
+    </message>
 </context>
 </TS>